@@ -0,0 +1,118 @@
+/* Minimal reader of NovaWM's shared state segment.
+ *
+ *   novawm-state-reader           print the state once
+ *   novawm-state-reader -f        print it again after every change
+ *   novawm-state-reader -b SECS   count consistent snapshots per second
+ */
+#include "novawm_state.h"
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static const struct novawm_state *map_state(void) {
+    const char *disp = getenv("DISPLAY");
+    char name[128];
+    snprintf(name, sizeof name, "%s-%u%s", NOVAWM_STATE_SHM_PREFIX,
+             (unsigned)geteuid(), disp && *disp ? disp : ":0");
+    for (char *p = name + 1; *p; p++)
+        if (*p == '/')
+            *p = '_';
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        perror(name);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_uid != geteuid()) {
+        fprintf(stderr, "%s: not created by this user\n", name);
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, sizeof(struct novawm_state), PROT_READ, MAP_SHARED,
+                   fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+
+    const struct novawm_state *seg = p;
+    if (seg->magic != NOVAWM_STATE_MAGIC ||
+        seg->version != NOVAWM_STATE_VERSION ||
+        seg->size != sizeof *seg) {
+        fprintf(stderr, "%s: not a version %u state segment\n", name,
+                NOVAWM_STATE_VERSION);
+        return NULL;
+    }
+    return seg;
+}
+
+static void print_state(const struct novawm_state *st) {
+    printf("workspace %u, focus 0x%x, %u clients%s\n",
+           st->current_ws + 1, st->focused, st->client_count,
+           st->truncated ? " (truncated)" : "");
+    for (uint32_t i = 0; i < st->client_count; i++) {
+        const struct novawm_state_client *c = &st->clients[i];
+        printf("  0x%08x ws %-2d %5d,%-5d %5dx%-5d%s%s%s%s%s\n",
+               c->win, c->ws < 0 ? 0 : c->ws + 1, c->x, c->y, c->w, c->h,
+               c->flags & NOVAWM_STATE_FOCUSED    ? " focused" : "",
+               c->flags & NOVAWM_STATE_FLOATING   ? " floating" : "",
+               c->flags & NOVAWM_STATE_FULLSCREEN ? " fullscreen" : "",
+               c->flags & NOVAWM_STATE_HIDDEN     ? " hidden" : "",
+               c->flags & NOVAWM_STATE_SCRATCHPAD ? " scratchpad" : "");
+    }
+    fflush(stdout);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    const struct novawm_state *seg = map_state();
+    if (!seg)
+        return 1;
+
+    static struct novawm_state st;
+
+    if (argc > 2 && argv[1][0] == '-' && argv[1][1] == 'b') {
+        double secs = atof(argv[2]);
+        unsigned long n = 0, failed = 0;
+        double start = now(), end = start + (secs > 0 ? secs : 1.0);
+        do {
+            for (int i = 0; i < 1000; i++) {
+                if (novawm_state_read(seg, &st, 100))
+                    n++;
+                else
+                    failed++;
+            }
+        } while (now() < end);
+        double t = now() - start;
+        printf("%.0f snapshots/s (%lu in %.2fs, %lu gave up)\n",
+               (double)n / t, n, t, failed);
+        return 0;
+    }
+
+    bool follow = argc > 1 && argv[1][0] == '-' && argv[1][1] == 'f';
+    for (;;) {
+        if (!novawm_state_read(seg, &st, 1000)) {
+            fprintf(stderr, "state segment stayed busy\n");
+            return 1;
+        }
+        print_state(&st);
+        if (!follow)
+            return 0;
+
+        /* sleeps until the WM bumps seq past what we just read */
+        syscall(SYS_futex, &seg->seq, FUTEX_WAIT, st.seq, NULL, NULL, 0);
+    }
+}
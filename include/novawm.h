@@ -3,18 +3,42 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <regex.h>
+#include <sys/types.h>
+#include <time.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_keysyms.h>
+#include <xcb/sync.h>
 
 /* --- limits --- */
 
 #define NOVAWM_MAX_BINDS     64
 #define NOVAWM_MAX_AUTOSTART 32
 #define NOVAWM_WORKSPACES    10
+#define NOVAWM_RULE_BUCKETS  256
+#define NOVAWM_MAX_SCRATCHPADS 8
+#define NOVAWM_GRID_CELL     128 /* spatial index cell size, pixels */
+#define NOVAWM_GRID_PREALLOC 8   /* client slots per cell allocated up front */
+#define NOVAWM_SYNC_TIMEOUT_MS 250 /* give up waiting for a sync ack */
+#define NOVAWM_ERROR_KINDS   32  /* distinct (request, error) pairs counted */
+#define NOVAWM_TRACE_RECORDS 65536 /* trace ring size, power of two */
 
 /* Super/Win as global modifier for mouse drag */
 #define NOVAWM_MOD_MASK XCB_MOD_MASK_4
 
+/* events selected on the root window while we are the WM */
+#define NOVAWM_ROOT_EVENT_MASK              \
+    (XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | \
+     XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY   | \
+     XCB_EVENT_MASK_STRUCTURE_NOTIFY      | \
+     XCB_EVENT_MASK_PROPERTY_CHANGE       | \
+     XCB_EVENT_MASK_BUTTON_PRESS          | \
+     XCB_EVENT_MASK_BUTTON_RELEASE        | \
+     XCB_EVENT_MASK_POINTER_MOTION        | \
+     XCB_EVENT_MASK_ENTER_WINDOW          | \
+     XCB_EVENT_MASK_KEY_PRESS)
+
 /* --- config / bindings --- */
 
 struct novawm_bind {
@@ -24,6 +48,89 @@ struct novawm_bind {
     char         arg[256];
 };
 
+/* --- window rules --- */
+
+enum novawm_rule_field {
+    NOVAWM_RULE_CLASS,
+    NOVAWM_RULE_INSTANCE,
+    NOVAWM_RULE_TITLE,
+    NOVAWM_RULE_TYPE,
+    NOVAWM_RULE_FIELDS
+};
+
+/* One "key:pattern" matcher. Plain patterns compare exactly; globs and
+ * "~regex" patterns are compiled to a regex_t once at config load. */
+struct novawm_rule_match {
+    bool    used;
+    bool    is_regex;
+    char   *exact;
+    char   *glob;               /* matched by rules.c itself, not regexec */
+    regex_t re;
+};
+
+struct novawm_rule {
+    struct novawm_rule_match match[NOVAWM_RULE_FIELDS];
+    int workspace;              /* 0-based, -1 = leave alone */
+    int floating;               /* 1 float, 0 tile, -1 leave alone */
+    int w, h;                   /* 0 = leave alone */
+    char scratchpad[32];        /* capture into this scratchpad, "" = no */
+    int next;                   /* next rule in class bucket, 1-based */
+};
+
+/* Properties a rule can look at, fetched with the manage round trip. */
+struct novawm_window_props {
+    char        wm_class[128];
+    char        instance[128];
+    char        title[256];
+    const char *type;           /* "normal", "dialog", ... or "" */
+};
+
+struct novawm_rule_result {
+    int workspace;
+    int floating;
+    int w, h;
+    const char *scratchpad;     /* NULL = not a scratchpad */
+};
+
+struct novawm_rules {
+    struct novawm_rule *v;
+    int                 len, cap;
+
+    /* rules with an exact class, chained per hash bucket (1-based index) */
+    int buckets[NOVAWM_RULE_BUCKETS];
+    /* everything else, in config order */
+    int *generic;
+    int  generic_len;
+};
+
+/* How a workspace places its tiled clients. */
+enum novawm_layout {
+    NOVAWM_LAYOUT_DWINDLE,
+    NOVAWM_LAYOUT_MONOCLE,      /* focused tile fills the area, rest unmapped */
+    NOVAWM_LAYOUT_BSP,          /* persistent split tree, see bsp.c */
+};
+
+/* How the focused client's process is given more CPU, see boost.c. */
+enum novawm_boost_mode {
+    NOVAWM_BOOST_OFF,
+    NOVAWM_BOOST_AUTO,          /* cgroup when delegated, else nice */
+    NOVAWM_BOOST_CGROUP,
+    NOVAWM_BOOST_NICE,
+};
+
+/* Where the built-in bar goes, if anywhere. */
+enum novawm_bar_pos {
+    NOVAWM_BAR_OFF,
+    NOVAWM_BAR_TOP,
+    NOVAWM_BAR_BOTTOM,
+};
+
+/* How a mouse move or resize is shown while the button is held. */
+enum novawm_drag_mode {
+    NOVAWM_DRAG_LIVE,           /* configure the client on every motion */
+    NOVAWM_DRAG_OUTLINE,        /* move a wireframe, configure on release */
+};
+
 struct novawm_config {
     float    master_factor;
     int      border_width;
@@ -32,28 +139,161 @@ struct novawm_config {
     int      gaps_inner;
     int      gaps_outer;
     bool     focus_follows_mouse;
+    bool     state_shm;         /* publish the shared state segment */
+    enum novawm_layout layout;  /* initial layout of every workspace */
+    enum novawm_drag_mode drag_move_mode;
+    enum novawm_drag_mode drag_resize_mode;
+    int      audit_budget_us;   /* NOVAWM_AUDIT builds: per-event reply wait */
+    bool     audit_fail;        /* ... and exit non-zero if it was exceeded */
+    int      client_pool;       /* clients preallocated at startup */
+    bool     lock_memory;       /* mlockall and a pre-faulted heap */
+    enum novawm_bar_pos bar;
+    int      bar_height;        /* 0 = from the font */
+    char     bar_font[64];      /* core X font */
+    uint32_t bar_bg;
+    uint32_t bar_fg;
+    enum novawm_boost_mode focus_boost;
+    int      focus_boost_weight;   /* cpu.weight of the focused app's scope */
+    int      focus_boost_nice;     /* nice levels below its own */
+    int      focus_boost_interval; /* ms between two boost changes */
 
     struct novawm_bind binds[NOVAWM_MAX_BINDS];
     int                binds_len;
 
     char autostart[NOVAWM_MAX_AUTOSTART][256];
     int  autostart_len;
+
+    struct novawm_rules rules;
 };
 
 /* --- client / workspace / monitor --- */
 
+/* The parts of WM_NORMAL_HINTS that affect size; 0 = not set. */
+struct novawm_size_hints {
+    int base_w, base_h;
+    int min_w, min_h;
+    int max_w, max_h;
+    int inc_w, inc_h;
+};
+
 struct novawm_client {
     xcb_window_t win;
     int x, y, w, h;
     bool floating;
-    int  ws;                    /* workspace index 0..NOVAWM_WORKSPACES-1 */
+    int  ws;                    /* workspace index 0..NOVAWM_WORKSPACES-1,
+                                   -1 for scratchpad clients */
     bool ignore_unmap;          /* unused now, but kept for compatibility */
-    struct novawm_client *next; /* next in workspace list */
+    struct novawm_scratchpad *scratch; /* owning scratchpad, if any */
+    struct novawm_client *below, *above; /* believed server stacking order */
+    bool     raise_req;         /* go to the top of its layer next commit */
+    uint32_t raise_seq;
+    bool     indexed;           /* present in the monitor's spatial grid */
+    bool     grid_dirty;        /* moved since it was last indexed */
+    int      gx0, gy0, gx1, gy1; /* grid cells it was inserted into */
+    bool    hidden;             /* not visible to the user right now */
+    bool    mapped;             /* last map state we asked for */
+    int     unmaps_pending;     /* UnmapNotify still due for our unmaps */
+    int      border_w;          /* last border width sent, -1 = none yet */
+    uint32_t border_color;      /* last border pixel sent, if border_set */
+    bool     border_set;
+    bool    fullscreen;
+    int     saved_x, saved_y, saved_w, saved_h; /* floating geometry before
+                                                  fullscreen */
+    uint8_t wm_state;           /* last WM_STATE written, 0 = none yet */
+    char    title[256];         /* for the bar */
+    bool    title_stale;        /* renamed since title was fetched */
+    struct novawm_size_hints hints; /* from WM_NORMAL_HINTS */
+    pid_t   pid;                /* _NET_WM_PID, 0 = unknown */
+    int     tile_x, tile_y, tile_w, tile_h; /* slot of the last layout */
+    bool    planned;            /* plan_* hold where a held-back arrange
+                                   will put it, see novawm_layout_plan() */
+    int     plan_x, plan_y, plan_w, plan_h;
+    struct novawm_bsp_node *leaf; /* in its workspace's bsp tree, if any */
+
+    /* _NET_WM_SYNC_REQUEST: while waiting for the client to paint the
+     * last size, newer geometry is parked in sync_x..sync_h */
+    xcb_sync_counter_t sync_counter; /* 0 = protocol not supported */
+    xcb_sync_alarm_t   sync_alarm;
+    uint64_t sync_value;        /* last value the client was asked for */
+    uint64_t sync_deadline;     /* ms, CLOCK_MONOTONIC */
+    bool     sync_known;        /* sync_value seeded from the counter */
+    bool     sync_waiting;
+    bool     sync_deferred;
+    int      sync_x, sync_y, sync_w, sync_h;
+
+    struct novawm_client *next, *prev; /* workspace list */
+    struct novawm_client *mru_next, *mru_prev; /* workspace focus history */
+};
+
+/* Node of a workspace's bsp tree. Leaves hold a tiled client; an inner
+ * node splits its rectangle between its two children, `ratio` of it
+ * going to child[0]. */
+struct novawm_bsp_node {
+    struct novawm_bsp_node *parent, *child[2]; /* free list via parent */
+    struct novawm_client   *client;             /* leaves only */
+    float ratio;
+    bool  vertical;             /* children side by side */
+};
+
+struct novawm_bsp_pool {
+    struct novawm_bsp_node *nodes;
+    int                     size;
+    struct novawm_bsp_node *free;
+    int                     used;
+    uint64_t                overflow;
+};
+
+/* Clients come from one preallocated block, so managing a window does
+ * not allocate until more than cfg.client_pool exist at once. */
+struct novawm_client_pool {
+    struct novawm_client *slots;
+    int                   size;
+    struct novawm_client *free;     /* linked through ->next */
+    int                   used;
+    uint64_t              overflow; /* clients allocated past the pool */
+};
+
+/* Stacking layers, bottom to top. Override-redirect windows are not ours
+ * and always sit above all of these. */
+enum novawm_layer {
+    NOVAWM_LAYER_TILED,
+    NOVAWM_LAYER_FLOATING,
+    NOVAWM_LAYER_FULLSCREEN,
+    NOVAWM_LAYER_SCRATCHPAD,
+};
+
+/* A scratchpad window lives outside the workspace lists and stays mapped;
+ * while hidden it is parked off-screen, so showing it is one configure. */
+struct novawm_scratchpad {
+    char name[32];
+    struct novawm_client *client;
+    int  x, y;                  /* on-screen position while shown */
+    bool visible;
+    bool show_on_map;           /* toggled before its window appeared */
+    uint64_t spawned_ms;        /* when show_on_map was set, monotonic */
+};
+
+/* What a workspace's dwindle layout was computed from. Client order,
+ * floating flags and size hints are covered by the workspace's
+ * layout_gen, the rest is compared directly. */
+struct novawm_layout_key {
+    bool     valid;
+    uint32_t gen;
+    const struct novawm_client *focused;
+    float    factor;
+    int      gaps_inner;
+    int      x, y, w, h;        /* tiling area */
 };
 
 struct novawm_workspace {
-    struct novawm_client *clients;
+    enum novawm_layout    layout;
+    struct novawm_client *clients, *last;
     struct novawm_client *focused;
+    struct novawm_client *mru, *mru_last; /* most recently focused first */
+    struct novawm_client *fullscreen; /* covers the monitor, others skipped */
+    struct novawm_bsp_node *bsp; /* tree root, bsp layout only */
+    uint32_t layout_gen;        /* see novawm_layout_invalidate() */
+    struct novawm_layout_key layout_key; /* of the tiles' slots */
 };
 
 struct novawm_drag_state {
@@ -63,25 +303,370 @@ struct novawm_drag_state {
     int start_root_x, start_root_y;
     int start_x, start_y;
     int start_w, start_h;
+    bool swapping;              /* tile drag: swap with the drop target */
+    bool outline;               /* wireframe drag, geometry in ox..oh */
+    int  ox, oy, ow, oh;
+};
+
+/* Uniform grid over the monitor; each cell lists the visible clients
+ * whose rectangle touches it. */
+struct novawm_grid_cell {
+    struct novawm_client **v;
+    int len, cap;
+};
+
+struct novawm_spatial {
+    int cols, rows;
+    struct novawm_grid_cell *cells;
+    struct novawm_client **store; /* first NOVAWM_GRID_PREALLOC of each */
+};
+
+enum novawm_dir {
+    NOVAWM_DIR_LEFT,
+    NOVAWM_DIR_RIGHT,
+    NOVAWM_DIR_UP,
+    NOVAWM_DIR_DOWN,
 };
 
 struct novawm_monitor {
     int x, y, w, h;
     int current_ws;                         /* 0..NOVAWM_WORKSPACES-1 */
     struct novawm_workspace ws[NOVAWM_WORKSPACES];
+    struct novawm_spatial   grid;           /* visible clients */
+};
+
+/* Built-in bar: a cell per workspace, the layout symbol and the focused
+ * title. The bar is drawn into a pixmap a segment at a time, and only
+ * when what that segment shows changed; Expose copies the pixmap back. */
+enum novawm_bar_segment {
+    NOVAWM_BAR_SEG_WORKSPACE,
+    NOVAWM_BAR_SEG_LAYOUT,
+    NOVAWM_BAR_SEG_TITLE,
+    NOVAWM_BAR_SEG_COUNT
+};
+
+struct novawm_bar {
+    int  h;                     /* reserved by arrange, 0 when off */
+    bool bottom;
+    xcb_window_t   win;         /* XCB_NONE when off or without X */
+    xcb_pixmap_t   pixmap;
+    xcb_gcontext_t gc;
+    int  w, y;
+    int  char_w, text_y;        /* glyph advance, baseline */
+    int  cell_w, layout_w;
+    bool shown;                 /* unmapped under a fullscreen client */
+    int  ws_drawn[NOVAWM_WORKSPACES]; /* -1 until drawn */
+    int  layout_drawn;
+    bool title_drawn_valid;
+    char title_drawn[256];
+    uint64_t redraws[NOVAWM_BAR_SEG_COUNT];
+    uint64_t exposes;
+};
+
+/* Focus boost state. `boosted` is the process currently given more CPU
+ * and `how` the way it got it, so it can be taken back the same way. */
+struct novawm_boost {
+    enum novawm_boost_mode mode;    /* resolved: OFF, CGROUP or NICE */
+    bool     cgroup_ok, nice_ok;
+    pid_t    wanted;                /* focus owner at the last change */
+    pid_t    boosted;               /* 0 if that could not be boosted */
+    enum novawm_boost_mode how;
+    int      base_nice;             /* boosted's nice before */
+    char     cgroup[256];           /* boosted's cgroup dir, CGROUP */
+    uint64_t changed_ms;            /* last change, for the rate limit */
+    uint64_t changes;
+    uint64_t deferred;              /* frames that waited for the limit */
+    uint64_t failures;
+};
+
+/* --- input / stats --- */
+
+/* Repeatable bindings (grow/shrink/focus) pressed within one event batch
+ * are folded here and applied once by novawm_input_commit(). */
+struct novawm_pending {
+    float factor_delta;
+    int   focus_steps;
+};
+
+/* An action list runs as one transaction. While depth > 0, arranges,
+ * SetInputFocus and flushes are only noted and done once at the end, so
+ * the server sees the final state and none of the steps in between. */
+struct novawm_txn {
+    int  depth;
+    bool arrange;
+    bool focus;
+    int  shown_ws;              /* on screen when it began, -1 = no switch */
+    uint32_t planned;           /* workspaces with planned clients, a bit
+                                   per index */
+};
+
+struct novawm_error_count {
+    uint8_t  major;             /* request opcode */
+    uint8_t  code;              /* error code */
+    uint64_t count;
+};
+
+struct novawm_stats {
+    uint64_t events;
+    uint64_t frames;
+    uint64_t arranges;
+    uint64_t layouts_cached;    /* arranges that reused the last slots */
+    uint64_t configures;
+    uint64_t key_repeats;
+    uint64_t coalesced;
+    uint64_t focus_changes;
+    uint64_t restacks;
+    uint64_t maps;
+    uint64_t unmaps;
+    uint64_t sync_requests;
+    uint64_t sync_deferred;     /* configures held back for an ack */
+    uint64_t sync_timeouts;
+    uint64_t resizes;           /* configures that changed the size */
+    uint64_t grid_updates;      /* clients re-checked in the spatial grid */
+    uint64_t drags;
+    uint64_t drag_configures;   /* client configures caused by drags */
+    uint64_t errors;
+    uint64_t dead_unmanaged;    /* clients dropped on BadWindow */
+    uint64_t state_publishes;
+    int      error_kinds;
+    struct novawm_error_count error_counts[NOVAWM_ERROR_KINDS];
+};
+
+/* Round-trip audit, compiled in with -DNOVAWM_AUDIT=ON. Every call that
+ * waits for a reply goes through NOVAWM_REPLY(); the waits are charged to
+ * the event being handled (kinds[] is indexed by event type, plus one
+ * slot for the per-frame commit). Waits outside any event (startup) are
+ * only counted. Backend queries, each one round trip, are also counted
+ * against a fixed budget per kind, so a new one fails however fast the
+ * server answers it. */
+#define NOVAWM_AUDIT_COMMIT 128
+#define NOVAWM_AUDIT_KINDS  129
+
+struct novawm_audit_kind {
+    uint64_t events;
+    uint64_t round_trips;
+    uint64_t wait_us;
+    uint64_t max_us;            /* worst single event */
+    uint64_t queries;           /* backend queries */
+    uint64_t over;              /* events over either budget */
+};
+
+struct novawm_audit {
+    int         kind;           /* being handled, -1 outside events */
+    uint32_t    round_trips;    /* in the current event */
+    uint32_t    queries;
+    uint64_t    wait_us;
+    uint64_t    slowest_us;     /* slowest wait in the current event */
+    const char *slowest_file;
+    int         slowest_line;
+    uint64_t    outside_round_trips;
+    uint64_t    outside_us;
+    uint64_t    violations;
+    struct novawm_audit_kind kinds[NOVAWM_AUDIT_KINDS];
+};
+
+/* Startup phases, timed from main() entry. The config is parsed on a
+ * thread while the X connection is set up, so CONFIG overlaps CONNECT. */
+enum novawm_phase {
+    NOVAWM_PHASE_CONFIG,
+    NOVAWM_PHASE_CONNECT,
+    NOVAWM_PHASE_INIT,
+    NOVAWM_PHASE_GRAB,
+    NOVAWM_PHASE_AUTOSTART,
+    NOVAWM_PHASE_SCAN,
+    NOVAWM_PHASE_COUNT
+};
+
+struct novawm_startup {
+    uint64_t start_us;          /* main() entry, CLOCK_MONOTONIC */
+    uint64_t ready_us;          /* first event loop iteration, 0 before */
+    uint64_t ready_allocs;      /* novawm_alloc_count() at that point */
+    uint64_t phase_us[NOVAWM_PHASE_COUNT];
+};
+
+/* --- atoms --- */
+
+enum novawm_atom {
+    NOVAWM_ATOM_STATE,          /* _NOVAWM_STATE: restart snapshot on root */
+    NOVAWM_ATOM_UTF8_STRING,
+    NOVAWM_ATOM_NET_WM_NAME,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_NORMAL,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_DIALOG,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_UTILITY,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_TOOLBAR,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_SPLASH,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_MENU,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_DOCK,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE_NOTIFICATION,
+    NOVAWM_ATOM_WM_STATE,
+    NOVAWM_ATOM_NET_SUPPORTED,
+    NOVAWM_ATOM_NET_SUPPORTING_WM_CHECK,
+    NOVAWM_ATOM_NET_WM_STATE,
+    NOVAWM_ATOM_NET_WM_STATE_HIDDEN,
+    NOVAWM_ATOM_NET_WM_STATE_FULLSCREEN,
+    NOVAWM_ATOM_NET_WM_BYPASS_COMPOSITOR,
+    NOVAWM_ATOM_WM_PROTOCOLS,
+    NOVAWM_ATOM_NET_WM_SYNC_REQUEST,
+    NOVAWM_ATOM_NET_WM_SYNC_REQUEST_COUNTER,
+    NOVAWM_ATOM_NET_WM_PID,
+    NOVAWM_ATOM_COUNT
+};
+
+/* --- backend --- */
+
+/* What manage needs to know about a new window, fetched in one go. */
+struct novawm_window_info {
+    bool override_redirect;
+    int  x, y, w, h;
+    bool fullscreen;                /* _NET_WM_STATE_FULLSCREEN set */
+    xcb_sync_counter_t sync_counter; /* 0 unless it speaks SYNC_REQUEST */
+    pid_t pid;                      /* _NET_WM_PID, 0 if not set */
+    struct novawm_size_hints  hints;
+    struct novawm_window_props props;
+};
+
+struct novawm_server;
+
+enum novawm_request {
+    NOVAWM_REQ_QUERY,
+    NOVAWM_REQ_CONFIGURE,
+    NOVAWM_REQ_MAP,
+    NOVAWM_REQ_UNMAP,
+    NOVAWM_REQ_ATTRIBUTES,
+    NOVAWM_REQ_FOCUS,
+    NOVAWM_REQ_GRAB,
+    NOVAWM_REQ_PROPERTY,
+    NOVAWM_REQ_SEND_EVENT,
+    NOVAWM_REQ_KILL,
+    NOVAWM_REQ_ALARM,           /* XSync alarm create/change/destroy */
+    NOVAWM_REQ_FLUSH,
+    NOVAWM_REQ_COUNT
+};
+
+/* Everything the window management code asks of the display server goes
+ * through srv->backend: the X11 one in x11.c, or the in-memory fake in
+ * fake.c that `novawm --bench` runs against. Value lists use the xcb
+ * layouts. Startup, restart and the WM's own windows (splash, outline)
+ * are X11-only and talk to xcb directly. */
+struct novawm_backend {
+    const char *name;
+    bool (*query_window)(struct novawm_server *srv, xcb_window_t win,
+                         struct novawm_window_info *out);
+    bool (*size_hints)(struct novawm_server *srv, xcb_window_t win,
+                       struct novawm_size_hints *out);
+    bool (*title)(struct novawm_server *srv, xcb_window_t win,
+                  char *out, size_t outsz);
+    void (*configure)(struct novawm_server *srv, xcb_window_t win,
+                      uint16_t mask, const uint32_t *values);
+    void (*map)(struct novawm_server *srv, xcb_window_t win);
+    void (*unmap)(struct novawm_server *srv, xcb_window_t win);
+    void (*set_attributes)(struct novawm_server *srv, xcb_window_t win,
+                           uint32_t mask, const uint32_t *values);
+    void (*focus)(struct novawm_server *srv, xcb_window_t win);
+    void (*grab_key)(struct novawm_server *srv, uint16_t mods,
+                     xcb_keycode_t key);
+    void (*ungrab_keys)(struct novawm_server *srv);
+    void (*set_property)(struct novawm_server *srv, xcb_window_t win,
+                         xcb_atom_t prop, xcb_atom_t type, uint8_t format,
+                         uint32_t len, const void *data);
+    void (*delete_property)(struct novawm_server *srv, xcb_window_t win,
+                            xcb_atom_t prop);
+    void (*send_event)(struct novawm_server *srv, xcb_window_t win,
+                       uint32_t mask, const void *ev);
+    void (*kill)(struct novawm_server *srv, xcb_window_t win);
+    /* an alarm that fires once `counter` reaches the value last set */
+    xcb_sync_alarm_t (*alarm_create)(struct novawm_server *srv,
+                                     xcb_sync_counter_t counter);
+    void (*alarm_set)(struct novawm_server *srv, xcb_sync_alarm_t alarm,
+                      uint64_t value);
+    void (*alarm_destroy)(struct novawm_server *srv, xcb_sync_alarm_t alarm);
+    void (*flush)(struct novawm_server *srv);
+};
+
+extern const struct novawm_backend novawm_backend_x11;
+extern const struct novawm_backend novawm_backend_fake;
+
+/* Always-on trace: the last NOVAWM_TRACE_RECORDS things the WM did, as
+ * raw timestamped records. Only the event loop thread writes, and the
+ * "trace" action or SIGUSR1 turns the ring into Chrome trace JSON. */
+enum novawm_trace_kind {
+    NOVAWM_TRACE_EVENT,          /* read from the queue, sub = type */
+    NOVAWM_TRACE_HANDLER_BEGIN,  /* sub = event type */
+    NOVAWM_TRACE_HANDLER_END,
+    NOVAWM_TRACE_COMMIT_BEGIN,   /* per-frame commit */
+    NOVAWM_TRACE_COMMIT_END,
+    NOVAWM_TRACE_ARRANGE_BEGIN,
+    NOVAWM_TRACE_ARRANGE_END,
+    NOVAWM_TRACE_REPLY_BEGIN,    /* site = file, arg = line */
+    NOVAWM_TRACE_REPLY_END,
+    NOVAWM_TRACE_IDLE_BEGIN,     /* blocked in poll() */
+    NOVAWM_TRACE_IDLE_END,
+    NOVAWM_TRACE_FLUSH,
+    NOVAWM_TRACE_SPAWN,          /* arg = pid */
+};
+
+struct novawm_trace_rec {
+    uint64_t    ts;             /* novawm_trace_clock() ticks */
+    const char *site;           /* string that outlives the ring, or NULL */
+    uint32_t    arg;
+    uint8_t     kind;
+    uint8_t     sub;
+};
+
+struct novawm_trace {
+    struct novawm_trace_rec *ring; /* NULL if tracing is off */
+    uint64_t head;              /* records ever written */
+    uint64_t clock0;            /* ticks and ns at init, for scaling */
+    uint64_t ns0;
+    int      dumps;
 };
 
 /* --- main server --- */
 
 struct novawm_server {
-    xcb_connection_t  *conn;
+    const struct novawm_backend *backend;
+    xcb_connection_t  *conn;          /* NULL with the fake backend */
     xcb_screen_t      *screen;
     xcb_window_t       root;
     xcb_key_symbols_t *keysyms;
+    xcb_atom_t         atoms[NOVAWM_ATOM_COUNT];
+
+    char **argv;                     /* for in-place restart */
+    bool   restarted;                /* exec'd by novawm_restart() */
 
     struct novawm_monitor    mon;
+    struct novawm_scratchpad scratch[NOVAWM_MAX_SCRATCHPADS];
+    int                      scratch_len;
+    struct novawm_client    *scratch_focused; /* scratchpad holding focus */
+
+    struct novawm_client_pool pool;
+    struct novawm_bsp_pool    bsp_pool;
+    struct novawm_client *stack_bottom, *stack_top; /* every client */
+    uint32_t              raise_seq;
+    bool                  stack_dirty;  /* stacking order may be off */
+    struct novawm_stack_slot *stack_slots; /* novawm_stack_commit() scratch */
+    int                   stack_cap;
     struct novawm_config     cfg;
     struct novawm_drag_state drag;
+    struct novawm_pending    pending;
+    struct novawm_txn        txn;
+    struct novawm_stats      stats;
+    struct novawm_startup    startup;
+    struct novawm_audit      audit;
+    struct novawm_trace      trace;
+    struct novawm_bar        bar;
+    struct novawm_boost      boost;
+
+    bool          detectable_repeat; /* XKB detectable autorepeat active */
+    xcb_keycode_t held_key;          /* last pressed, not yet released */
+
+    bool    have_sync;               /* XSync extension usable */
+    uint8_t sync_event_base;
+    int     sync_waiting;            /* clients with an ack outstanding */
+
+    struct novawm_state *state;      /* shared segment, NULL if off */
+    struct novawm_state *state_stage; /* next contents, built per frame */
 
     bool running;
 };
@@ -93,30 +678,186 @@ const char *novawm_get_config_path(void);
 void        novawm_run_autostart(struct novawm_config *cfg);
 uint16_t    novawm_parse_mods(const char *s);
 
+/* --- rules --- */
+
+bool novawm_rules_add(struct novawm_rules *rules, char *spec);
+void novawm_rules_compile(struct novawm_rules *rules);
+void novawm_rules_match(const struct novawm_rules *rules,
+                        const struct novawm_window_props *props,
+                        struct novawm_rule_result *out);
+
 /* --- X11 backend --- */
 
+bool novawm_x11_connect(struct novawm_server *srv);
 bool novawm_x11_init(struct novawm_server *srv);
 void novawm_x11_grab_keys(struct novawm_server *srv);
 void novawm_x11_scan_existing(struct novawm_server *srv);
 void novawm_x11_run(struct novawm_server *srv);
+void novawm_x11_handle_event(struct novawm_server *srv,
+                             xcb_generic_event_t *ev);
+void novawm_x11_commit_frame(struct novawm_server *srv);
+void novawm_x11_error(struct novawm_server *srv, xcb_generic_error_t *err);
+const char *novawm_error_name(uint8_t code);
+const char *novawm_request_name(uint8_t major);
+const char *novawm_event_name(struct novawm_server *srv, int type);
 
 /* --- layout / manage --- */
 
 void novawm_arrange(struct novawm_server *srv);
+void novawm_arrange_held(struct novawm_server *srv);
+void novawm_layout_plan(struct novawm_server *srv);
+void novawm_layout_invalidate(struct novawm_server *srv, int ws);
+void novawm_flush(struct novawm_server *srv);
+void novawm_set_focus(struct novawm_server *srv, xcb_window_t win);
+bool novawm_layout_parse(const char *name, enum novawm_layout *out);
 
+bool novawm_server_init(struct novawm_server *srv);
 void novawm_manage_window(struct novawm_server *srv, xcb_window_t win);
+void novawm_client_set_mapped(struct novawm_server *srv,
+                              struct novawm_client *c, bool mapped);
+struct novawm_client *novawm_attach_client(struct novawm_server *srv,
+                                           xcb_window_t win, int ws);
+void novawm_mru_touch(struct novawm_workspace *ws, struct novawm_client *c);
+void novawm_detach_client(struct novawm_server *srv, struct novawm_client *c);
 void novawm_unmanage_window(struct novawm_server *srv, struct novawm_client *c);
 struct novawm_client *novawm_find_client(struct novawm_server *srv,
                                          xcb_window_t win);
 
 void novawm_focus_client(struct novawm_server *srv, struct novawm_client *c);
 void novawm_toggle_floating(struct novawm_server *srv);
+void novawm_swap_clients(struct novawm_server *srv,
+                         struct novawm_client *a, struct novawm_client *b);
+void novawm_set_fullscreen(struct novawm_server *srv,
+                           struct novawm_client *c, bool on);
 void novawm_kill_focused(struct novawm_server *srv);
 
+/* --- bsp tree --- */
+
+bool novawm_bsp_init(struct novawm_server *srv);
+void novawm_bsp_sync(struct novawm_server *srv, struct novawm_workspace *ws);
+void novawm_bsp_remove(struct novawm_server *srv, struct novawm_workspace *ws,
+                       struct novawm_client *c);
+void novawm_bsp_swap(struct novawm_client *a, struct novawm_client *b);
+bool novawm_bsp_resize(struct novawm_client *c, float delta);
+struct novawm_bsp_node *novawm_bsp_leaf(struct novawm_server *srv,
+                                        struct novawm_client *c);
+struct novawm_bsp_node *novawm_bsp_join(struct novawm_server *srv,
+                                        struct novawm_bsp_node *a,
+                                        struct novawm_bsp_node *b,
+                                        bool vertical, float ratio);
+
+/* --- scratchpads --- */
+
+struct novawm_scratchpad *novawm_scratchpad_get(struct novawm_server *srv,
+                                                const char *name, bool create);
+void novawm_scratchpad_capture(struct novawm_server *srv,
+                               struct novawm_scratchpad *sp,
+                               struct novawm_client *c);
+void novawm_scratchpad_release(struct novawm_server *srv,
+                               struct novawm_client *c);
+void novawm_scratchpad_toggle(struct novawm_server *srv, const char *arg);
+void novawm_scratchpad_move_focused(struct novawm_server *srv,
+                                    const char *name);
+
+/* --- stacking --- */
+
+bool novawm_stack_init(struct novawm_server *srv);
+void novawm_stack_invalidate(struct novawm_server *srv);
+void novawm_stack_insert(struct novawm_server *srv, struct novawm_client *c);
+void novawm_stack_remove(struct novawm_server *srv, struct novawm_client *c);
+void novawm_stack_raise(struct novawm_server *srv, struct novawm_client *c);
+void novawm_stack_mark_top(struct novawm_server *srv,
+                           struct novawm_client *c);
+void novawm_stack_sync(struct novawm_server *srv,
+                       const xcb_window_t *children, int len);
+void novawm_stack_commit(struct novawm_server *srv);
+
+/* --- spatial index --- */
+
+bool novawm_spatial_init(struct novawm_server *srv);
+void novawm_spatial_update(struct novawm_server *srv, struct novawm_client *c);
+void novawm_spatial_remove(struct novawm_server *srv, struct novawm_client *c);
+struct novawm_client *novawm_spatial_at(struct novawm_server *srv,
+                                        int x, int y);
+struct novawm_client *novawm_spatial_neighbor(struct novawm_server *srv,
+                                              struct novawm_client *c,
+                                              enum novawm_dir dir);
+
+/* Geometry the grid and the visibility pass go by: the planned slot
+ * while a transaction holds the arrange back, else the window's own. */
+struct novawm_box {
+    int x, y, w, h;
+};
+
+static inline struct novawm_box novawm_client_box(const struct novawm_client *c) {
+    if (c->planned)
+        return (struct novawm_box){ c->plan_x, c->plan_y, c->plan_w, c->plan_h };
+    return (struct novawm_box){ c->x, c->y, c->w, c->h };
+}
+
+/* --- restart --- */
+
+void novawm_restart(struct novawm_server *srv);
+bool novawm_restart_restore(struct novawm_server *srv,
+                            xcb_get_property_reply_t *snap,
+                            xcb_window_t *children, int len,
+                            uint8_t *map_state);
+
+/* --- EWMH / ICCCM hints --- */
+
+void novawm_ewmh_init(struct novawm_server *srv);
+void novawm_client_set_hidden(struct novawm_server *srv,
+                              struct novawm_client *c, bool hidden);
+void novawm_ewmh_update_state(struct novawm_server *srv,
+                              struct novawm_client *c);
+void novawm_ewmh_client_message(struct novawm_server *srv,
+                                xcb_client_message_event_t *ev);
+void novawm_size_hints_update(struct novawm_size_hints *sh,
+                              const xcb_get_property_reply_t *r);
+void novawm_size_hints_apply(const struct novawm_size_hints *sh,
+                             int *w, int *h);
+
+/* --- _NET_WM_SYNC_REQUEST --- */
+
+void novawm_sync_init(struct novawm_server *srv);
+void novawm_sync_setup(struct novawm_server *srv, struct novawm_client *c,
+                       xcb_sync_counter_t counter);
+void novawm_sync_release(struct novawm_server *srv, struct novawm_client *c);
+void novawm_client_configure(struct novawm_server *srv,
+                             struct novawm_client *c,
+                             int x, int y, int w, int h);
+void novawm_sync_alarm_notify(struct novawm_server *srv,
+                              xcb_sync_alarm_notify_event_t *ev);
+int  novawm_sync_timeout(struct novawm_server *srv);
+void novawm_sync_expire(struct novawm_server *srv);
+
+/* --- bar --- */
+
+void novawm_bar_init(struct novawm_server *srv);
+void novawm_bar_update(struct novawm_server *srv);
+void novawm_bar_expose(struct novawm_server *srv);
+
+/* --- drag outline --- */
+
+void novawm_outline_show(struct novawm_server *srv,
+                         int x, int y, int w, int h);
+void novawm_outline_hide(struct novawm_server *srv);
+
+/* --- shared state segment (novawm_state.h) --- */
+
+void novawm_state_init(struct novawm_server *srv);
+void novawm_state_publish(struct novawm_server *srv);
+void novawm_state_fini(struct novawm_server *srv);
+
 /* --- input handlers --- */
 
 void novawm_handle_key_press(struct novawm_server *srv,
                              xcb_key_press_event_t *ev);
+void novawm_handle_key_release(struct novawm_server *srv,
+                               xcb_key_release_event_t *ev);
+void novawm_input_commit(struct novawm_server *srv);
+void novawm_dispatch_action(struct novawm_server *srv,
+                            const char *action, const char *arg);
 void novawm_handle_button_press(struct novawm_server *srv,
                                 xcb_button_press_event_t *ev);
 void novawm_handle_button_release(struct novawm_server *srv,
@@ -126,9 +867,119 @@ void novawm_handle_motion_notify(struct novawm_server *srv,
 void novawm_handle_enter_notify(struct novawm_server *srv,
                                 xcb_enter_notify_event_t *ev);
 
+/* --- fake backend / bench --- */
+
+void novawm_fake_init(struct novawm_server *srv, int w, int h);
+xcb_window_t novawm_fake_create_window(struct novawm_server *srv,
+                                       const struct novawm_window_info *info);
+void novawm_fake_destroy_window(struct novawm_server *srv, xcb_window_t win);
+int  novawm_fake_dispatch(struct novawm_server *srv);
+const uint64_t *novawm_fake_requests(void);
+uint64_t novawm_fake_dead_requests(uint64_t *late);
+int  novawm_fake_paint(int *mapped, int *all);
+void novawm_fake_set_paint_ticks(xcb_window_t win, int ticks);
+void novawm_fake_pointer(struct novawm_server *srv, uint8_t type,
+                         xcb_window_t win, uint8_t button, uint16_t state,
+                         int x, int y);
+int  novawm_fake_tick(struct novawm_server *srv);
+uint64_t novawm_fake_sync_overruns(void);
+uint64_t novawm_fake_allocs(void);
+void novawm_fake_fini(void);
+int  novawm_bench(int windows);
+int  novawm_bench_boost(int hogs);
+
+/* --- stats --- */
+
+void novawm_stats_dump(struct novawm_server *srv, FILE *out);
+uint64_t novawm_now_us(void);
+
+/* --- round-trip audit --- */
+
+void novawm_audit_init(struct novawm_server *srv);
+void novawm_audit_begin(struct novawm_server *srv, int kind);
+void novawm_audit_end(struct novawm_server *srv);
+void novawm_audit_query(struct novawm_server *srv);
+void novawm_audit_reply(struct novawm_server *srv, uint64_t start,
+                        const char *file, int line);
+void novawm_audit_dump(struct novawm_server *srv, FILE *out);
+
+uint64_t novawm_startup_phase(struct novawm_server *srv,
+                              enum novawm_phase phase, uint64_t since);
+void novawm_startup_ready(struct novawm_server *srv);
+
+/* --- trace ring --- */
+
+void novawm_trace_init(struct novawm_server *srv);
+bool novawm_trace_dump(struct novawm_server *srv);
+void novawm_trace_poll(struct novawm_server *srv);
+void novawm_trace_fini(struct novawm_server *srv);
+
+/* rdtsc where there is one; scaled to ns only when dumping */
+static inline uint64_t novawm_trace_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline void novawm_trace(struct novawm_server *srv,
+                                enum novawm_trace_kind kind, uint8_t sub,
+                                uint32_t arg, const char *site) {
+    struct novawm_trace *t = &srv->trace;
+    if (!t->ring)
+        return;
+    struct novawm_trace_rec *r =
+        &t->ring[t->head++ & (NOVAWM_TRACE_RECORDS - 1)];
+    r->ts = novawm_trace_clock();
+    r->site = site;
+    r->arg = arg;
+    r->kind = (uint8_t)kind;
+    r->sub = sub;
+}
+
+#ifdef NOVAWM_AUDIT
+#define NOVAWM_REPLY(srv, call) __extension__ ({                      \
+        uint64_t audit_t_ = novawm_now_us();                          \
+        novawm_trace((srv), NOVAWM_TRACE_REPLY_BEGIN, 0, __LINE__,    \
+                     __FILE__);                                       \
+        __typeof__(call) audit_r_ = (call);                           \
+        novawm_trace((srv), NOVAWM_TRACE_REPLY_END, 0, 0, NULL);      \
+        novawm_audit_reply((srv), audit_t_, __FILE__, __LINE__);      \
+        audit_r_; })
+#define NOVAWM_AUDIT_BEGIN(srv, kind) novawm_audit_begin((srv), (kind))
+#define NOVAWM_AUDIT_END(srv)         novawm_audit_end(srv)
+#define NOVAWM_AUDIT_QUERY(srv)       novawm_audit_query(srv)
+#else
+#define NOVAWM_REPLY(srv, call) __extension__ ({                      \
+        novawm_trace((srv), NOVAWM_TRACE_REPLY_BEGIN, 0, __LINE__,    \
+                     __FILE__);                                       \
+        __typeof__(call) trace_r_ = (call);                           \
+        novawm_trace((srv), NOVAWM_TRACE_REPLY_END, 0, 0, NULL);      \
+        trace_r_; })
+#define NOVAWM_AUDIT_BEGIN(srv, kind) ((void)0)
+#define NOVAWM_AUDIT_END(srv)         ((void)0)
+#define NOVAWM_AUDIT_QUERY(srv)       ((void)(srv))
+#endif
+
+/* --- focus boost --- */
+
+void novawm_boost_init(struct novawm_server *srv);
+void novawm_boost_update(struct novawm_server *srv);
+int  novawm_boost_timeout(struct novawm_server *srv);
+void novawm_boost_fini(struct novawm_server *srv);
+void novawm_boost_enter_scope(void);
+
+/* --- memory --- */
+
+void     novawm_memory_lock(struct novawm_server *srv);
+uint64_t novawm_alloc_count(void);
+
 /* --- util --- */
 
-void         novawm_spawn(const char *cmd);
+pid_t        novawm_spawn(const char *cmd);
 uint16_t     novawm_clean_mods(uint16_t state);
 xcb_keysym_t novawm_keycode_to_keysym(struct novawm_server *srv,
                                       xcb_keycode_t code);
@@ -0,0 +1,86 @@
+#ifndef NOVAWM_STATE_H
+#define NOVAWM_STATE_H
+
+/* Read-only window manager state published in POSIX shared memory, for
+ * bars and scripts. The object is named NOVAWM_STATE_SHM_PREFIX, a dash,
+ * the effective uid and $DISPLAY (e.g. "/novawm-state-1000:0"); check that
+ * it is owned by that uid and map it PROT_READ.
+ *
+ * The writer updates it under a seqlock: `seq` is odd while a write is in
+ * progress and is bumped to the next even value when it is done. Readers
+ * copy the segment and retry if `seq` was odd or changed meanwhile (see
+ * novawm_state_read below). `seq` doubles as a shared futex word: wait on
+ * it with FUTEX_WAIT to sleep until the next change.
+ *
+ * Only this header is needed to read the segment. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NOVAWM_STATE_SHM_PREFIX   "/novawm-state"
+#define NOVAWM_STATE_MAGIC        0x4e575354u /* "NWST" */
+#define NOVAWM_STATE_VERSION      1u
+#define NOVAWM_STATE_WORKSPACES   10
+#define NOVAWM_STATE_MAX_CLIENTS  512
+
+/* client flags */
+#define NOVAWM_STATE_FLOATING     (1u << 0)
+#define NOVAWM_STATE_FULLSCREEN   (1u << 1)
+#define NOVAWM_STATE_HIDDEN       (1u << 2)
+#define NOVAWM_STATE_SCRATCHPAD   (1u << 3)
+#define NOVAWM_STATE_FOCUSED      (1u << 4)
+
+struct novawm_state_client {
+    uint32_t win;
+    int16_t  ws;                /* -1 for scratchpads */
+    uint16_t flags;
+    int32_t  x, y, w, h;
+};
+
+struct novawm_state_workspace {
+    uint32_t focused;           /* XID, 0 if none */
+    uint16_t clients;           /* how many of clients[] belong here */
+    uint8_t  layout;            /* 0 dwindle, 1 monocle, 2 bsp */
+    uint8_t  pad;
+};
+
+struct novawm_state {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;              /* sizeof(struct novawm_state) */
+    uint32_t seq;               /* seqlock and futex word */
+
+    int32_t  mon_x, mon_y, mon_w, mon_h;
+    uint32_t current_ws;
+    uint32_t focused;           /* XID with input focus, 0 if none */
+    uint32_t client_count;
+    uint32_t truncated;         /* clients that did not fit */
+
+    struct novawm_state_workspace ws[NOVAWM_STATE_WORKSPACES];
+    /* grouped by workspace in list order, scratchpads last */
+    struct novawm_state_client clients[NOVAWM_STATE_MAX_CLIENTS];
+};
+
+/* Copy a consistent snapshot of `seg` into `out`. Returns false if the
+ * writer kept it busy for `tries` attempts. `out->seq` is the version
+ * read, the value to FUTEX_WAIT on for the next change. */
+static inline bool novawm_state_read(const struct novawm_state *seg,
+                                     struct novawm_state *out, int tries) {
+    while (tries-- > 0) {
+        uint32_t s1 = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1u)
+            continue;
+
+        memcpy(out, seg, sizeof *out);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&seg->seq, __ATOMIC_RELAXED) == s1) {
+            out->seq = s1;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif /* NOVAWM_STATE_H */
@@ -0,0 +1,110 @@
+#include "novawm.h"
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* Allocation counting and memory locking. In NOVAWM_COUNT_ALLOCS builds
+ * on glibc, every allocating function glibc lets a program replace is
+ * wrapped here: malloc, calloc, realloc and the aligned ones. A definition
+ * in the executable takes precedence for libxcb and libc too, so
+ * novawm_alloc_count() sees every heap allocation in the process. free()
+ * is libc's own: the wrappers hand out ordinary glibc chunks. Other builds
+ * leave the allocator alone and count nothing. */
+
+#define PREFAULT_HEAP  (8u << 20) /* heap kept resident with lock_memory */
+#define PREFAULT_STACK (256u << 10)
+
+static uint64_t allocs;
+
+#if defined(__GLIBC__) && defined(NOVAWM_COUNT_ALLOCS)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+
+void *malloc(size_t size) {
+    __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size) {
+    __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(p, size);
+}
+
+void *memalign(size_t align, size_t size) {
+    __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_memalign(align, size);
+}
+
+/* the checks __libc_memalign leaves out: it rounds the alignment up */
+void *aligned_alloc(size_t align, size_t size) {
+    if (!align || (align & (align - 1))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return memalign(align, size);
+}
+
+int posix_memalign(void **out, size_t align, size_t size) {
+    if (align < sizeof(void *) || (align & (align - 1)))
+        return EINVAL;
+    void *p = memalign(align, size);
+    if (!p)
+        return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+void *valloc(size_t size) {
+    __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_valloc(size);
+}
+
+void *pvalloc(size_t size) {
+    __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_pvalloc(size);
+}
+#endif
+
+/* Heap allocations so far; always 0 unless built with
+ * NOVAWM_COUNT_ALLOCS on glibc. */
+uint64_t novawm_alloc_count(void) {
+    return __atomic_load_n(&allocs, __ATOMIC_RELAXED);
+}
+
+static void __attribute__((noinline)) prefault_stack(void) {
+    volatile char buf[PREFAULT_STACK];
+    memset((char *)buf, 0, sizeof buf);
+}
+
+/* lock_memory: grow the heap and stack once, keep freed memory instead of
+ * returning it to the kernel, and lock everything so the event loop never
+ * waits on a page fault. Failure (RLIMIT_MEMLOCK) is logged and ignored. */
+void novawm_memory_lock(struct novawm_server *srv) {
+    if (!srv->cfg.lock_memory)
+        return;
+
+#ifdef __GLIBC__
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    char *heap = malloc(PREFAULT_HEAP);
+    if (heap) {
+        memset(heap, 0, PREFAULT_HEAP);
+        free(heap);
+    }
+#endif
+    prefault_stack();
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        perror("novawm: mlockall");
+}
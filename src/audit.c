@@ -0,0 +1,129 @@
+#include "novawm.h"
+#include <inttypes.h>
+
+/* Round-trip auditor (NOVAWM_AUDIT builds). A reply wait inside an event
+ * handler stalls every later event, so each one is charged to the event
+ * type being handled; an event whose waits add up to more than
+ * audit_budget_us is logged with the call site of its slowest wait.
+ * Waiting time depends on the server, so each kind also has a budget of
+ * backend queries that does not: an event making more is logged too.
+ * Ordinary builds keep these functions but never call them. */
+
+static const char *kind_name(struct novawm_server *srv, int kind) {
+    if (kind == NOVAWM_AUDIT_COMMIT)
+        return "frame commit";
+    return novawm_event_name(srv, kind);
+}
+
+/* Backend queries one event of `kind` may make: manage fetches all it
+ * needs at once, a hints change refetches the hints and a frame the
+ * focused window's title. Nothing else needs to ask the server. */
+static uint32_t query_budget(int kind) {
+    switch (kind) {
+    case XCB_MAP_REQUEST:
+    case XCB_PROPERTY_NOTIFY:
+    case NOVAWM_AUDIT_COMMIT:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+void novawm_audit_init(struct novawm_server *srv) {
+    srv->audit.kind = -1;
+}
+
+void novawm_audit_begin(struct novawm_server *srv, int kind) {
+    struct novawm_audit *a = &srv->audit;
+    a->kind = kind;
+    a->round_trips = 0;
+    a->queries = 0;
+    a->wait_us = 0;
+    a->slowest_us = 0;
+    a->slowest_file = NULL;
+    a->slowest_line = 0;
+}
+
+/* A backend query: one round trip, however many replies it waits for. */
+void novawm_audit_query(struct novawm_server *srv) {
+    struct novawm_audit *a = &srv->audit;
+    if (a->kind >= 0)
+        a->queries++;
+}
+
+void novawm_audit_reply(struct novawm_server *srv, uint64_t start,
+                        const char *file, int line) {
+    struct novawm_audit *a = &srv->audit;
+    uint64_t us = novawm_now_us() - start;
+
+    if (a->kind < 0) {
+        a->outside_round_trips++;
+        a->outside_us += us;
+        return;
+    }
+
+    a->round_trips++;
+    a->wait_us += us;
+    if (!a->slowest_file || us > a->slowest_us) {
+        a->slowest_us = us;
+        a->slowest_file = file;
+        a->slowest_line = line;
+    }
+}
+
+void novawm_audit_end(struct novawm_server *srv) {
+    struct novawm_audit *a = &srv->audit;
+    if (a->kind < 0)
+        return;
+
+    struct novawm_audit_kind *k = &a->kinds[a->kind];
+    k->events++;
+    k->round_trips += a->round_trips;
+    k->queries += a->queries;
+    k->wait_us += a->wait_us;
+    if (a->wait_us > k->max_us)
+        k->max_us = a->wait_us;
+
+    if (a->round_trips && a->wait_us > (uint64_t)srv->cfg.audit_budget_us) {
+        k->over++;
+        a->violations++;
+        fprintf(stderr, "novawm: audit: %s waited %.2f ms on %u "
+                "round trip%s (budget %.2f ms), slowest at %s:%d\n",
+                kind_name(srv, a->kind), (double)a->wait_us / 1000.0,
+                a->round_trips, a->round_trips == 1 ? "" : "s",
+                (double)srv->cfg.audit_budget_us / 1000.0,
+                a->slowest_file, a->slowest_line);
+    } else if (a->queries > query_budget(a->kind)) {
+        k->over++;
+        a->violations++;
+        fprintf(stderr, "novawm: audit: %s made %u backend queries "
+                "(budget %u)\n", kind_name(srv, a->kind), a->queries,
+                query_budget(a->kind));
+    }
+    a->kind = -1;
+}
+
+void novawm_audit_dump(struct novawm_server *srv, FILE *out) {
+#ifdef NOVAWM_AUDIT
+    const struct novawm_audit *a = &srv->audit;
+
+    fprintf(out, "  audit        %" PRIu64 " events over budget, %" PRIu64
+            " round trips (%.2f ms) outside events\n",
+            a->violations, a->outside_round_trips,
+            (double)a->outside_us / 1000.0);
+    for (int i = 0; i < NOVAWM_AUDIT_KINDS; i++) {
+        const struct novawm_audit_kind *k = &a->kinds[i];
+        if (!k->round_trips && !k->queries)
+            continue;
+        fprintf(out, "    %-18s %" PRIu64 " round trips (%" PRIu64
+                " queries) in %" PRIu64 " events, %.2f ms total, worst "
+                "%.2f ms, %" PRIu64 " over\n",
+                kind_name(srv, i), k->round_trips, k->queries, k->events,
+                (double)k->wait_us / 1000.0, (double)k->max_us / 1000.0,
+                k->over);
+    }
+#else
+    (void)srv;
+    (void)out;
+#endif
+}
@@ -0,0 +1,270 @@
+#include "novawm.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Built-in bar. Everything it shows is already in novawm_monitor, so once
+ * per frame novawm_bar_update() compares that with what each segment last
+ * drew and redraws only the segments that differ: two workspace cells on
+ * a switch, the title on focus or rename. Segments are drawn into a
+ * pixmap and copied to the window, so an Expose costs one CopyArea and no
+ * redrawing. The focused client's title is fetched only after it changed
+ * (PropertyNotify marks it stale). Without an X connection (the bench)
+ * the bookkeeping runs and the drawing is skipped. */
+
+#define WS_CELL_CHARS   3
+#define LAYOUT_CHARS    5
+
+static const char *const layout_symbols[] = {
+    [NOVAWM_LAYOUT_DWINDLE] = " []= ",
+    [NOVAWM_LAYOUT_MONOCLE] = " [M] ",
+    [NOVAWM_LAYOUT_BSP]     = " [+] ",
+};
+
+/* Open the configured font, falling back to "fixed"; fills in the glyph
+ * metrics. One round trip, at startup. */
+static xcb_font_t open_font(struct novawm_server *srv, int *char_w,
+                            int *ascent, int *descent) {
+    const char *names[2] = { srv->cfg.bar_font, "fixed" };
+
+    for (int i = 0; i < 2; i++) {
+        xcb_font_t font = xcb_generate_id(srv->conn);
+        xcb_void_cookie_t ck = xcb_open_font_checked(
+            srv->conn, font, (uint16_t)strlen(names[i]), names[i]);
+        xcb_generic_error_t *err =
+            NOVAWM_REPLY(srv, xcb_request_check(srv->conn, ck));
+        if (err) {
+            free(err);
+            fprintf(stderr, "novawm: bar: cannot open font '%s'\n",
+                    names[i]);
+            continue;
+        }
+
+        xcb_query_font_reply_t *r = NOVAWM_REPLY(srv,
+            xcb_query_font_reply(srv->conn,
+                                 xcb_query_font(srv->conn, font), NULL));
+        if (!r) {
+            xcb_close_font(srv->conn, font);
+            continue;
+        }
+        *char_w = r->max_bounds.character_width;
+        *ascent = r->font_ascent;
+        *descent = r->font_descent;
+        free(r);
+        return font;
+    }
+    return XCB_NONE;
+}
+
+static bool bar_create(struct novawm_server *srv, struct novawm_bar *b) {
+    int ascent, descent;
+    xcb_font_t font = open_font(srv, &b->char_w, &ascent, &descent);
+    if (!font)
+        return false;
+
+    if (!srv->cfg.bar_height)
+        b->h = ascent + descent + 4;
+    b->text_y = (b->h - ascent - descent) / 2 + ascent;
+    b->y = b->bottom ? srv->mon.y + srv->mon.h - b->h : srv->mon.y;
+
+    uint32_t wvals[3] = {
+        srv->cfg.bar_bg,
+        1, /* override-redirect */
+        XCB_EVENT_MASK_EXPOSURE,
+    };
+    b->win = xcb_generate_id(srv->conn);
+    xcb_create_window(srv->conn, XCB_COPY_FROM_PARENT, b->win, srv->root,
+                      (int16_t)srv->mon.x, (int16_t)b->y,
+                      (uint16_t)b->w, (uint16_t)b->h, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      srv->screen->root_visual,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT |
+                      XCB_CW_EVENT_MASK, wvals);
+
+    b->pixmap = xcb_generate_id(srv->conn);
+    xcb_create_pixmap(srv->conn, srv->screen->root_depth, b->pixmap,
+                      b->win, (uint16_t)b->w, (uint16_t)b->h);
+
+    uint32_t gvals[4] = { srv->cfg.bar_bg, srv->cfg.bar_bg, font, 0 };
+    b->gc = xcb_generate_id(srv->conn);
+    xcb_create_gc(srv->conn, b->gc, b->pixmap,
+                  XCB_GC_FOREGROUND | XCB_GC_BACKGROUND | XCB_GC_FONT |
+                  XCB_GC_GRAPHICS_EXPOSURES, gvals);
+    xcb_close_font(srv->conn, font); /* the GC keeps it */
+
+    xcb_rectangle_t all = { 0, 0, (uint16_t)b->w, (uint16_t)b->h };
+    xcb_poly_fill_rectangle(srv->conn, b->pixmap, b->gc, 1, &all);
+    return true;
+}
+
+void novawm_bar_init(struct novawm_server *srv) {
+    struct novawm_bar *b = &srv->bar;
+
+    memset(b, 0, sizeof *b);
+    if (srv->cfg.bar == NOVAWM_BAR_OFF)
+        return;
+
+    b->bottom = srv->cfg.bar == NOVAWM_BAR_BOTTOM;
+    b->h = srv->cfg.bar_height ? srv->cfg.bar_height : 16;
+    b->w = srv->mon.w;
+    b->char_w = 6;
+    b->text_y = b->h - 4;
+    b->layout_drawn = -1;
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++)
+        b->ws_drawn[i] = -1;
+
+    if (srv->conn && !bar_create(srv, b)) {
+        fprintf(stderr, "novawm: bar disabled\n");
+        memset(b, 0, sizeof *b);
+        return;
+    }
+    b->cell_w = WS_CELL_CHARS * b->char_w;
+    b->layout_w = LAYOUT_CHARS * b->char_w;
+}
+
+/* --- drawing into the pixmap --- */
+
+static void fill(struct novawm_server *srv, uint32_t color, int x, int w) {
+    struct novawm_bar *b = &srv->bar;
+    xcb_change_gc(srv->conn, b->gc, XCB_GC_FOREGROUND, &color);
+    xcb_rectangle_t r = { (int16_t)x, 0, (uint16_t)w, (uint16_t)b->h };
+    xcb_poly_fill_rectangle(srv->conn, b->pixmap, b->gc, 1, &r);
+}
+
+static void text(struct novawm_server *srv, uint32_t fg, uint32_t bg,
+                 int x, const char *s, int len) {
+    struct novawm_bar *b = &srv->bar;
+    uint32_t vals[2] = { fg, bg };
+    xcb_change_gc(srv->conn, b->gc,
+                  XCB_GC_FOREGROUND | XCB_GC_BACKGROUND, vals);
+    xcb_image_text_8(srv->conn, (uint8_t)len, b->pixmap, b->gc,
+                     (int16_t)x, (int16_t)b->text_y, s);
+}
+
+/* Put pixmap columns x..x+w on screen. */
+static void show(struct novawm_server *srv, int x, int w) {
+    struct novawm_bar *b = &srv->bar;
+    xcb_copy_area(srv->conn, b->pixmap, b->win, b->gc, (int16_t)x, 0,
+                  (int16_t)x, 0, (uint16_t)w, (uint16_t)b->h);
+}
+
+/* state: bit 0 = has clients, bit 1 = current */
+static void draw_workspace(struct novawm_server *srv, int i, int state) {
+    struct novawm_bar *b = &srv->bar;
+    b->ws_drawn[i] = state;
+    b->redraws[NOVAWM_BAR_SEG_WORKSPACE]++;
+    if (!b->win)
+        return;
+
+    uint32_t bg = state & 2 ? srv->cfg.border_color_active : srv->cfg.bar_bg;
+    uint32_t fg = state & 2 ? srv->cfg.bar_bg : srv->cfg.bar_fg;
+    int x = i * b->cell_w;
+    char label[4];
+    int len = snprintf(label, sizeof label, "%d", i + 1);
+
+    fill(srv, bg, x, b->cell_w);
+    text(srv, fg, bg, x + (b->cell_w - len * b->char_w) / 2, label, len);
+    if (state & 1) {
+        /* occupied: a small square in the corner */
+        int sq = b->h / 6 > 2 ? b->h / 6 : 2;
+        xcb_change_gc(srv->conn, b->gc, XCB_GC_FOREGROUND, &fg);
+        xcb_rectangle_t r = { (int16_t)(x + 1), 1, (uint16_t)sq,
+                              (uint16_t)sq };
+        xcb_poly_fill_rectangle(srv->conn, b->pixmap, b->gc, 1, &r);
+    }
+    show(srv, x, b->cell_w);
+}
+
+static void draw_layout(struct novawm_server *srv, int layout) {
+    struct novawm_bar *b = &srv->bar;
+    b->layout_drawn = layout;
+    b->redraws[NOVAWM_BAR_SEG_LAYOUT]++;
+    if (!b->win)
+        return;
+
+    int x = NOVAWM_WORKSPACES * b->cell_w;
+    text(srv, srv->cfg.bar_fg, srv->cfg.bar_bg, x, layout_symbols[layout],
+         LAYOUT_CHARS);
+    show(srv, x, b->layout_w);
+}
+
+static void draw_title(struct novawm_server *srv, const char *title) {
+    struct novawm_bar *b = &srv->bar;
+    snprintf(b->title_drawn, sizeof b->title_drawn, "%s", title);
+    b->title_drawn_valid = true;
+    b->redraws[NOVAWM_BAR_SEG_TITLE]++;
+    if (!b->win)
+        return;
+
+    int x = NOVAWM_WORKSPACES * b->cell_w + b->layout_w;
+    int w = b->w - x;
+    if (w <= 0)
+        return;
+
+    /* core fonts are 8-bit: one '?' per non-ASCII UTF-8 sequence */
+    char buf[256];
+    int max = w / b->char_w - 1, len = 0;
+    if (max > 255)
+        max = 255;              /* ImageText8 limit */
+    for (const unsigned char *p = (const unsigned char *)title;
+         *p && len < max; p++) {
+        if (*p < 0x80)
+            buf[len++] = (char)*p;
+        else if (*p >= 0xc0)
+            buf[len++] = '?';
+    }
+
+    fill(srv, srv->cfg.bar_bg, x, w);
+    if (len > 0)
+        text(srv, srv->cfg.bar_fg, srv->cfg.bar_bg, x + b->char_w, buf, len);
+    show(srv, x, w);
+}
+
+/* Once per frame: redraw the segments whose state changed. */
+void novawm_bar_update(struct novawm_server *srv) {
+    struct novawm_bar *b = &srv->bar;
+    if (!b->h)
+        return;
+
+    struct novawm_workspace *cur = &srv->mon.ws[srv->mon.current_ws];
+
+    /* a fullscreen client covers the whole monitor, bar included */
+    bool visible = !cur->fullscreen;
+    if (visible != b->shown) {
+        b->shown = visible;
+        if (b->win) {
+            if (visible)
+                xcb_map_window(srv->conn, b->win); /* Expose paints it */
+            else
+                xcb_unmap_window(srv->conn, b->win);
+        }
+    }
+    if (!visible)
+        return;
+
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        int state = (srv->mon.ws[i].clients ? 1 : 0) |
+                    (i == srv->mon.current_ws ? 2 : 0);
+        if (state != b->ws_drawn[i])
+            draw_workspace(srv, i, state);
+    }
+
+    if ((int)cur->layout != b->layout_drawn)
+        draw_layout(srv, (int)cur->layout);
+
+    struct novawm_client *f =
+        srv->scratch_focused ? srv->scratch_focused : cur->focused;
+    if (f && f->title_stale) {
+        if (!srv->backend->title(srv, f->win, f->title, sizeof f->title))
+            f->title[0] = '\0';
+        f->title_stale = false;
+    }
+    const char *title = f ? f->title : "";
+    if (!b->title_drawn_valid || strcmp(title, b->title_drawn))
+        draw_title(srv, title);
+}
+
+void novawm_bar_expose(struct novawm_server *srv) {
+    srv->bar.exposes++;
+    show(srv, 0, srv->bar.w);
+    xcb_flush(srv->conn);
+}
@@ -0,0 +1,1183 @@
+#include "novawm.h"
+#include <inttypes.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* `novawm --bench N`: run manage, workspace switching, arrange and
+ * teardown with N windows against the fake backend and report the time
+ * and the exact requests of each phase. No X server is involved, so the
+ * numbers are the WM's own cost and repeat run to run. Once warmed up
+ * the WM must not allocate: the steady phases fail the bench if it does.
+ * Flipping between two workspaces must not configure anything either.
+ * Scratchpad toggles report their latency, and fake clients count the
+ * frames they would paint on shown and hidden workspaces. */
+
+#define BENCH_SWITCH_ROUNDS 10
+#define BENCH_ARRANGES      1000
+#define BENCH_FLIPS         100
+#define BENCH_CHURN_PERCENT 10
+#define BENCH_TRACE_RECORDS 10000000
+#define BENCH_CHAIN_ROUNDS  20
+#define BENCH_LAYOUT_TILES  30
+#define BENCH_TOGGLES       200
+#define BENCH_KILLS         50
+#define BENCH_PAINT_TICKS   60
+#define BENCH_QUERY_FLOATS  300
+#define BENCH_QUERIES       100000
+#define BENCH_CYCLE_STEPS   100
+#define BENCH_CYCLE_MAX     1000
+#define BENCH_DRAG_MOTIONS  120
+#define BENCH_PAINT_LAG     4       /* ticks a slow client takes to paint */
+#define BENCH_XTERMS        8
+#define BENCH_FACTOR_STEPS  500     /* of 0.0002, about 0.4 px */
+#define BENCH_FOCUS_WINDOWS 2000
+#define BENCH_FOCUS_OPS     200
+#define BENCH_RULES         100     /* of each kind; 3x as many exact */
+#define BENCH_HOLD_MS       2000    /* one key held down ... */
+#define BENCH_REPEAT_DELAY  660     /* ... with X's default autorepeat */
+#define BENCH_REPEAT_MS     40
+
+/* One binding's worth of actions, run as separate presses and as a list. */
+static const char *const chain_steps[][2] = {
+    { "workspace", NULL },          /* alternates between 2 and 3 */
+    { "togglefloating", "" },
+    { "grow", "" },
+    { "swapright", "" },
+    { "focusnext", "" },
+    { "layout", "" },
+};
+#define BENCH_CHAIN_STEPS (int)(sizeof chain_steps / sizeof chain_steps[0])
+
+static const char *const request_names[NOVAWM_REQ_COUNT] = {
+    [NOVAWM_REQ_QUERY]      = "query",
+    [NOVAWM_REQ_CONFIGURE]  = "configure",
+    [NOVAWM_REQ_MAP]        = "map",
+    [NOVAWM_REQ_UNMAP]      = "unmap",
+    [NOVAWM_REQ_ATTRIBUTES] = "attributes",
+    [NOVAWM_REQ_FOCUS]      = "focus",
+    [NOVAWM_REQ_GRAB]       = "grab",
+    [NOVAWM_REQ_PROPERTY]   = "property",
+    [NOVAWM_REQ_SEND_EVENT] = "send_event",
+    [NOVAWM_REQ_KILL]       = "kill",
+    [NOVAWM_REQ_ALARM]      = "alarm",
+    [NOVAWM_REQ_FLUSH]      = "flush",
+};
+
+struct bench_phase {
+    uint64_t start_us;
+    uint64_t requests[NOVAWM_REQ_COUNT];
+    uint64_t allocs;            /* by the WM, the fake's own excluded */
+    uint64_t dead;              /* requests for destroyed windows */
+    int      events;
+};
+
+static uint64_t wm_allocs(void) {
+    return novawm_alloc_count() - novawm_fake_allocs();
+}
+
+static void phase_begin(struct bench_phase *ph) {
+    memcpy(ph->requests, novawm_fake_requests(), sizeof ph->requests);
+    ph->dead = novawm_fake_dead_requests(NULL);
+    ph->events = 0;
+    ph->allocs = wm_allocs();
+    ph->start_us = novawm_now_us();
+}
+
+/* Returns the phase's allocations. */
+static uint64_t phase_end(struct bench_phase *ph, const char *name, int ops) {
+    uint64_t us = novawm_now_us() - ph->start_us;
+    uint64_t allocs = wm_allocs() - ph->allocs;
+    const uint64_t *now = novawm_fake_requests();
+
+    printf("  %-8s %6d ops %9.2f ms %8.2f us/op %8d events %6" PRIu64
+           " allocs\n", name, ops, (double)us / 1000.0,
+           ops ? (double)us / ops : 0.0, ph->events, allocs);
+    printf("          ");
+    for (int i = 0; i < NOVAWM_REQ_COUNT; i++)
+        if (now[i] != ph->requests[i])
+            printf(" %s %" PRIu64, request_names[i], now[i] - ph->requests[i]);
+    if (novawm_fake_dead_requests(NULL) != ph->dead)
+        printf(" (%" PRIu64 " for destroyed windows)",
+               novawm_fake_dead_requests(NULL) - ph->dead);
+    printf("\n");
+    return allocs;
+}
+
+/* Requests sent since phase_begin, flushes excluded. */
+static uint64_t requests_since(const struct bench_phase *ph) {
+    const uint64_t *now = novawm_fake_requests();
+    uint64_t n = 0;
+    for (int i = 0; i < NOVAWM_REQ_COUNT; i++)
+        if (i != NOVAWM_REQ_FLUSH)
+            n += now[i] - ph->requests[i];
+    return n;
+}
+
+static void workspace(struct novawm_server *srv, int ws) {
+    char arg[12];
+    snprintf(arg, sizeof arg, "%d", ws + 1);
+    novawm_dispatch_action(srv, "workspace", arg);
+}
+
+/* Returns the requests sent, flushes excluded. As a list, flushes past
+ * the one at its end are added to *early: intermediate states sent. */
+static uint64_t bench_chain(struct novawm_server *srv, struct bench_phase *ph,
+                            bool as_list, uint64_t *early) {
+    uint64_t before = 0, after = 0;
+    const uint64_t *req = novawm_fake_requests();
+
+    for (int i = 0; i < NOVAWM_REQ_COUNT; i++)
+        if (i != NOVAWM_REQ_FLUSH) before += req[i];
+
+    for (int r = 0; r < BENCH_CHAIN_ROUNDS; r++) {
+        char ws[12], list[128];
+        snprintf(ws, sizeof ws, "%d", 2 + r % 2);
+        if (as_list) {
+            int len = 0;
+            for (int s = 0; s < BENCH_CHAIN_STEPS; s++)
+                len += snprintf(list + len, sizeof list - (size_t)len,
+                                "%s%s %s", s ? "; " : "", chain_steps[s][0],
+                                chain_steps[s][1] ? chain_steps[s][1] : ws);
+            uint64_t flushes = req[NOVAWM_REQ_FLUSH];
+            novawm_dispatch_action(srv, "chain", list);
+            if (req[NOVAWM_REQ_FLUSH] - flushes > 1)
+                *early += req[NOVAWM_REQ_FLUSH] - flushes - 1;
+            novawm_x11_commit_frame(srv);
+            ph->events += novawm_fake_dispatch(srv);
+            continue;
+        }
+        /* one key press, and so one frame, per action */
+        for (int s = 0; s < BENCH_CHAIN_STEPS; s++) {
+            novawm_dispatch_action(srv, chain_steps[s][0],
+                                   chain_steps[s][1] ? chain_steps[s][1] : ws);
+            novawm_x11_commit_frame(srv);
+            ph->events += novawm_fake_dispatch(srv);
+        }
+    }
+
+    for (int i = 0; i < NOVAWM_REQ_COUNT; i++)
+        if (i != NOVAWM_REQ_FLUSH) after += req[i];
+    return after - before;
+}
+
+static int moved(struct novawm_client **cs, const int (*geom)[4], int n) {
+    int k = 0;
+    for (int i = 0; i < n; i++)
+        if (cs[i]->x != geom[i][0] || cs[i]->y != geom[i][1] ||
+            cs[i]->w != geom[i][2] || cs[i]->h != geom[i][3])
+            k++;
+    return k;
+}
+
+static void snapshot(struct novawm_client **cs, int (*geom)[4], int n) {
+    for (int i = 0; i < n; i++) {
+        geom[i][0] = cs[i]->x;
+        geom[i][1] = cs[i]->y;
+        geom[i][2] = cs[i]->w;
+        geom[i][3] = cs[i]->h;
+    }
+}
+
+/* On an empty workspace, tile BENCH_LAYOUT_TILES windows with `layout`,
+ * each opened with window (i - 1) / 2 focused so that no tile ends up a
+ * sliver. Then, with each of them focused in turn, open one more window
+ * and close it again. Reports how many of the other tiles each open and
+ * close moved or resized. */
+static void bench_layout(struct novawm_server *srv,
+                         struct novawm_window_info *info,
+                         enum novawm_layout layout, const char *name) {
+    struct novawm_client *cs[BENCH_LAYOUT_TILES];
+    int geom[BENCH_LAYOUT_TILES][4];
+    xcb_window_t wins[BENCH_LAYOUT_TILES];
+    int opened = 0, closed = 0;
+
+    srv->mon.ws[srv->mon.current_ws].layout = layout;
+    for (int i = 0; i < BENCH_LAYOUT_TILES; i++) {
+        if (i > 0)
+            novawm_focus_client(srv, cs[(i - 1) / 2]);
+        wins[i] = novawm_fake_create_window(srv, info);
+        novawm_fake_dispatch(srv);
+        cs[i] = novawm_find_client(srv, wins[i]);
+        if (!cs[i])
+            return;
+    }
+
+    uint64_t t0 = novawm_now_us();
+    for (int i = 0; i < BENCH_LAYOUT_TILES; i++) {
+        novawm_focus_client(srv, cs[i]);
+        novawm_fake_dispatch(srv);
+
+        snapshot(cs, geom, BENCH_LAYOUT_TILES);
+        xcb_window_t extra = novawm_fake_create_window(srv, info);
+        novawm_fake_dispatch(srv);
+        opened += moved(cs, (const int (*)[4])geom, BENCH_LAYOUT_TILES);
+
+        snapshot(cs, geom, BENCH_LAYOUT_TILES);
+        novawm_fake_destroy_window(srv, extra);
+        novawm_fake_dispatch(srv);
+        closed += moved(cs, (const int (*)[4])geom, BENCH_LAYOUT_TILES);
+    }
+    uint64_t us = novawm_now_us() - t0;
+
+    printf("  %-8s %d tiles: %.1f others reconfigured per open, %.1f per "
+           "close, %.1f us per open+close\n", name, BENCH_LAYOUT_TILES,
+           (double)opened / BENCH_LAYOUT_TILES,
+           (double)closed / BENCH_LAYOUT_TILES,
+           (double)us / BENCH_LAYOUT_TILES);
+
+    for (int i = 0; i < BENCH_LAYOUT_TILES; i++)
+        novawm_fake_destroy_window(srv, wins[i]);
+    novawm_fake_dispatch(srv);
+}
+
+/* Clients dying in the middle of things on the current workspace: one
+ * destroys its window while a MapRequest is already queued ahead of its
+ * UnmapNotify, and then the focused one is killed with a resize in the
+ * same action list. The WM cannot help a request that reaches a window
+ * before it could know; anything sent once it knew is counted in `late`.
+ * Returns the phase's allocations. */
+static uint64_t bench_kill(struct novawm_server *srv, struct bench_phase *ph,
+                           struct novawm_window_info *info, uint64_t *late) {
+    struct novawm_workspace *ws = &srv->mon.ws[srv->mon.current_ws];
+    uint64_t late0;
+    novawm_fake_dead_requests(&late0);
+
+    phase_begin(ph);
+    for (int i = 0; i < BENCH_KILLS && ws->clients; i++) {
+        xcb_window_t dying = ws->last->win;
+        novawm_fake_create_window(srv, info);
+        novawm_fake_destroy_window(srv, dying);
+        ph->events += novawm_fake_dispatch(srv);
+
+        novawm_dispatch_action(srv, "chain", "killactive; grow");
+        novawm_x11_commit_frame(srv);
+        ph->events += novawm_fake_dispatch(srv);
+    }
+    uint64_t allocs = phase_end(ph, "kill", 2 * BENCH_KILLS);
+    novawm_fake_dead_requests(late);
+    *late -= late0;
+    return allocs;
+}
+
+/* Hold grow for BENCH_HOLD_MS, then shrink, on the current workspace.
+ * The presses arrive at autorepeat times; the WM reads them in one batch
+ * per `frame_ms`, as when it or the server is that far behind, or one
+ * at a time with coalescing off. Returns the configures sent, each one a
+ * ConfigureNotify for its client. */
+static uint64_t bench_hold(struct novawm_server *srv, int frame_ms,
+                           bool coalesce) {
+    static const char *const actions[] = { "grow", "shrink" };
+
+    /* the same start each time; grow and shrink stop at the limits */
+    srv->cfg.master_factor = 0.5f;
+    novawm_arrange(srv);
+    novawm_fake_dispatch(srv);
+    uint64_t before = novawm_fake_requests()[NOVAWM_REQ_CONFIGURE];
+
+    for (int a = 0; a < 2; a++) {
+        int batch = -1;
+        for (int t = 0; t < BENCH_HOLD_MS;
+             t += t ? BENCH_REPEAT_MS : BENCH_REPEAT_DELAY) {
+            if (!coalesce || (batch >= 0 && t / frame_ms != batch)) {
+                novawm_x11_commit_frame(srv);
+                novawm_fake_dispatch(srv);
+            }
+            batch = t / frame_ms;
+            novawm_dispatch_action(srv, actions[a], "");
+        }
+        novawm_x11_commit_frame(srv);
+        novawm_fake_dispatch(srv);
+    }
+    return novawm_fake_requests()[NOVAWM_REQ_CONFIGURE] - before;
+}
+
+/* Show each workspace in turn for BENCH_PAINT_TICKS ticks, the first
+ * with a floating window the size of the screen over its tiles, as a
+ * maximized browser would be. Every tick
+ * each client paints a frame unless it can tell it is not seen. Returns
+ * the frames painted by clients the WM itself considers hidden. */
+static uint64_t bench_paint(struct novawm_server *srv,
+                            struct novawm_window_info *info) {
+    struct novawm_window_info big = *info;
+    char spec[64];
+    uint64_t hinted = 0, mapped = 0, all = 0, wasted = 0;
+    int ticks = 0;
+
+    snprintf(spec, sizeof spec, "class:BenchFloat, float, size %dx%d",
+             srv->mon.w, srv->mon.h);
+    novawm_rules_add(&srv->cfg.rules, spec);
+    novawm_rules_compile(&srv->cfg.rules);
+    snprintf(big.props.wm_class, sizeof big.props.wm_class, "BenchFloat");
+    workspace(srv, 0);
+    xcb_window_t win = novawm_fake_create_window(srv, &big);
+    novawm_fake_dispatch(srv);
+
+    for (int w = 0; w < NOVAWM_WORKSPACES; w++) {
+        workspace(srv, w);
+        novawm_fake_dispatch(srv);
+
+        int seen = 0;
+        for (struct novawm_client *c = srv->mon.ws[w].clients; c; c = c->next)
+            if (c->mapped && !c->hidden)
+                seen++;
+        for (int t = 0; t < BENCH_PAINT_TICKS; t++, ticks++) {
+            int m, a, n = novawm_fake_paint(&m, &a);
+            hinted += (uint64_t)n;
+            mapped += (uint64_t)m;
+            all += (uint64_t)a;
+            if (n > seen)
+                wasted += (uint64_t)(n - seen);
+        }
+    }
+    printf("  paint    %d ticks: %.1f frames per tick honouring WM_STATE, "
+           "%.1f watching mapping only, %.1f ignoring both\n", ticks,
+           (double)hinted / ticks, (double)mapped / ticks,
+           (double)all / ticks);
+
+    novawm_fake_destroy_window(srv, win);
+    workspace(srv, 0);
+    novawm_fake_dispatch(srv);
+    return wasted;
+}
+
+/* Show and hide a scratchpad over the current, full workspace, one key
+ * press per toggle. Returns the phase's allocations. */
+static uint64_t bench_scratchpad(struct novawm_server *srv,
+                                 struct bench_phase *ph,
+                                 struct novawm_window_info *info) {
+    xcb_window_t win = novawm_fake_create_window(srv, info);
+    novawm_fake_dispatch(srv);
+    novawm_dispatch_action(srv, "movetoscratchpad", "bench");
+    novawm_fake_dispatch(srv);
+
+    phase_begin(ph);
+    for (int i = 0; i < BENCH_TOGGLES; i++) {
+        novawm_dispatch_action(srv, "scratchpad", "bench");
+        novawm_x11_commit_frame(srv);
+        ph->events += novawm_fake_dispatch(srv);
+    }
+    uint64_t allocs = phase_end(ph, "toggle", BENCH_TOGGLES);
+
+    novawm_fake_destroy_window(srv, win);
+    novawm_fake_dispatch(srv);
+    return allocs;
+}
+
+/* Tile `n` windows on the current, empty workspace with `layout` and
+ * press focusnext BENCH_CYCLE_STEPS times, one frame each. Prints the
+ * requests and time per step; the request counts do not depend on the
+ * machine. */
+static void bench_cycle(struct novawm_server *srv,
+                        struct novawm_window_info *info,
+                        enum novawm_layout layout, const char *name, int n) {
+    xcb_window_t *wins = calloc((size_t)n, sizeof *wins);
+    struct bench_phase ph;
+    if (!wins)
+        return;
+
+    srv->mon.ws[srv->mon.current_ws].layout = layout;
+    for (int i = 0; i < n; i++) {
+        wins[i] = novawm_fake_create_window(srv, info);
+        novawm_fake_dispatch(srv);
+    }
+
+    phase_begin(&ph);
+    for (int i = 0; i < BENCH_CYCLE_STEPS; i++) {
+        novawm_dispatch_action(srv, "focusnext", "");
+        novawm_x11_commit_frame(srv);
+        ph.events += novawm_fake_dispatch(srv);
+    }
+    uint64_t us = novawm_now_us() - ph.start_us;
+    const uint64_t *now = novawm_fake_requests();
+    printf("  %-8s %5d tiles: %6.1f requests per focusnext, %7.2f us:",
+           name, n, (double)requests_since(&ph) / BENCH_CYCLE_STEPS,
+           (double)us / BENCH_CYCLE_STEPS);
+    for (int i = 0; i < NOVAWM_REQ_COUNT; i++)
+        if (i != NOVAWM_REQ_FLUSH && now[i] != ph.requests[i])
+            printf(" %s %.1f", request_names[i],
+                   (double)(now[i] - ph.requests[i]) / BENCH_CYCLE_STEPS);
+    printf("\n");
+
+    for (int i = 0; i < n; i++)
+        novawm_fake_destroy_window(srv, wins[i]);
+    novawm_fake_dispatch(srv);
+    srv->mon.ws[srv->mon.current_ws].layout = NOVAWM_LAYOUT_DWINDLE;
+    free(wins);
+}
+
+/* Drag `win` with MOD held and `button` (1 moves, 3 resizes): a press,
+ * BENCH_DRAG_MOTIONS motions one tick apart, and a release, after which
+ * the client gets time to catch up. `before` is called once the press
+ * has been handled, so that the caller can measure the drag alone. */
+static void bench_drag(struct novawm_server *srv, xcb_window_t win,
+                       uint8_t button, void (*before)(void *), void *arg) {
+    struct novawm_client *c = novawm_find_client(srv, win);
+    if (!c)
+        return;
+    int x = c->x + 10, y = c->y + 10;
+
+    novawm_fake_pointer(srv, XCB_BUTTON_PRESS, win, button,
+                        NOVAWM_MOD_MASK, x, y);
+    novawm_fake_dispatch(srv);
+    before(arg);
+    for (int i = 0; i < BENCH_DRAG_MOTIONS; i++) {
+        x += 3;
+        y += 2;
+        novawm_fake_pointer(srv, XCB_MOTION_NOTIFY, win, 0,
+                            NOVAWM_MOD_MASK, x, y);
+        novawm_fake_tick(srv);
+        novawm_fake_dispatch(srv);
+    }
+    novawm_fake_pointer(srv, XCB_BUTTON_RELEASE, win, button,
+                        NOVAWM_MOD_MASK, x, y);
+    novawm_fake_dispatch(srv);
+    for (int i = 0; i <= BENCH_PAINT_LAG; i++) {
+        novawm_fake_tick(srv);
+        novawm_fake_dispatch(srv);
+    }
+}
+
+struct bench_counts {
+    struct novawm_server *srv;
+    uint64_t configures, resizes, deferred;
+};
+
+static void count_drag(void *arg) {
+    struct bench_counts *n = arg;
+    n->configures = n->srv->stats.configures;
+    n->resizes = n->srv->stats.resizes;
+    n->deferred = n->srv->stats.sync_deferred;
+}
+
+/* Move and resize a window on the current, empty workspace by dragging,
+ * with the client configured live and with only an outline following the
+ * pointer. Returns the client configures beyond one per outline drag,
+ * which should be none. */
+static uint64_t bench_drag_modes(struct novawm_server *srv,
+                                 struct novawm_window_info *info) {
+    static const enum novawm_drag_mode modes[] = {
+        NOVAWM_DRAG_LIVE, NOVAWM_DRAG_OUTLINE,
+    };
+    enum novawm_drag_mode move = srv->cfg.drag_move_mode;
+    enum novawm_drag_mode resize = srv->cfg.drag_resize_mode;
+    uint64_t extra = 0;
+
+    xcb_window_t win = novawm_fake_create_window(srv, info);
+    novawm_fake_dispatch(srv);
+    for (int m = 0; m < 2; m++) {
+        uint64_t configures[2];
+        srv->cfg.drag_move_mode = modes[m];
+        srv->cfg.drag_resize_mode = modes[m];
+        for (int b = 0; b < 2; b++) {
+            struct bench_counts n = { .srv = srv };
+            bench_drag(srv, win, b ? 3 : 1, count_drag, &n);
+            configures[b] = srv->stats.configures - n.configures;
+            if (modes[m] == NOVAWM_DRAG_OUTLINE && configures[b] > 1)
+                extra += configures[b] - 1;
+        }
+        printf("  %-8s %d motions: %" PRIu64 " client configures moving, %"
+               PRIu64 " resizing\n", m ? "outline" : "live",
+               BENCH_DRAG_MOTIONS, configures[0], configures[1]);
+    }
+    novawm_fake_destroy_window(srv, win);
+    novawm_fake_dispatch(srv);
+
+    srv->cfg.drag_move_mode = move;
+    srv->cfg.drag_resize_mode = resize;
+    return extra;
+}
+
+/* Resize-drag a window on the current, empty workspace whose client
+ * takes BENCH_PAINT_LAG ticks to paint each size: once with it acking
+ * through _NET_WM_SYNC_REQUEST and once without. Prints the configures
+ * sent, held back for an ack, and the sizes never sent because a newer
+ * one took their place. Returns the resizes that reached the syncing
+ * client while it was still painting, which should be none. */
+static uint64_t bench_sync(struct novawm_server *srv,
+                           struct novawm_window_info *info) {
+    uint64_t overruns = 0;
+
+    for (int sync = 1; sync >= 0; sync--) {
+        struct novawm_window_info w = *info;
+        struct bench_counts n = { .srv = srv };
+        w.sync_counter = (xcb_sync_counter_t)sync;
+        xcb_window_t win = novawm_fake_create_window(srv, &w);
+        novawm_fake_set_paint_ticks(win, BENCH_PAINT_LAG);
+        novawm_fake_dispatch(srv);
+
+        uint64_t over = novawm_fake_sync_overruns();
+        bench_drag(srv, win, 3, count_drag, &n);
+        uint64_t resizes = srv->stats.resizes - n.resizes;
+        if (sync)
+            overruns = novawm_fake_sync_overruns() - over;
+
+        printf("  %-8s %d motions, paints in %d ticks: %" PRIu64
+               " configures, %" PRIu64 " held back, %" PRIu64
+               " sizes dropped\n", sync ? "sync" : "nosync",
+               BENCH_DRAG_MOTIONS, BENCH_PAINT_LAG,
+               srv->stats.configures - n.configures,
+               srv->stats.sync_deferred - n.deferred,
+               (uint64_t)BENCH_DRAG_MOTIONS - resizes);
+
+        novawm_fake_destroy_window(srv, win);
+        novawm_fake_dispatch(srv);
+    }
+    return overruns;
+}
+
+/* Focus changes on the current, empty workspace after filling it with
+ * BENCH_FOCUS_WINDOWS windows in monocle, one key press and frame each:
+ * focusnext, focusprev, focuslast, and closing the focused window so that
+ * the last one focused takes over. Returns how many batches of a
+ * focusnext followed by a focuslast did not end where they started,
+ * which should be none. */
+static uint64_t bench_focus(struct novawm_server *srv,
+                            struct novawm_window_info *info) {
+    static const char *const ops[] = { "focusnext", "focusprev",
+                                       "focuslast", NULL };
+    struct novawm_workspace *ws = &srv->mon.ws[srv->mon.current_ws];
+    xcb_window_t *wins = calloc(BENCH_FOCUS_WINDOWS, sizeof *wins);
+    struct bench_phase ph;
+    uint64_t misordered = 0;
+    if (!wins)
+        return 0;
+
+    ws->layout = NOVAWM_LAYOUT_MONOCLE;
+    for (int i = 0; i < BENCH_FOCUS_WINDOWS; i++) {
+        wins[i] = novawm_fake_create_window(srv, info);
+        novawm_fake_dispatch(srv);
+    }
+
+    for (int o = 0; o < 4; o++) {
+        phase_begin(&ph);
+        for (int i = 0; i < BENCH_FOCUS_OPS; i++) {
+            if (ops[o])
+                novawm_dispatch_action(srv, ops[o], "");
+            else if (ws->focused)
+                novawm_fake_destroy_window(srv, ws->focused->win);
+            novawm_x11_commit_frame(srv);
+            ph.events += novawm_fake_dispatch(srv);
+        }
+        phase_end(&ph, ops[o] ? ops[o] + 5 : "close", BENCH_FOCUS_OPS);
+    }
+
+    /* a step and alt-tab in one batch: back where it started */
+    for (int i = 0; i < BENCH_FOCUS_OPS; i++) {
+        struct novawm_client *start = ws->focused;
+        novawm_dispatch_action(srv, "focusnext", "");
+        novawm_dispatch_action(srv, "focuslast", "");
+        novawm_input_commit(srv);
+        novawm_x11_commit_frame(srv);
+        novawm_fake_dispatch(srv);
+        if (ws->focused != start)
+            misordered++;
+    }
+
+    for (int i = 0; i < BENCH_FOCUS_WINDOWS; i++)
+        novawm_fake_destroy_window(srv, wins[i]);
+    novawm_fake_dispatch(srv);
+    ws->layout = NOVAWM_LAYOUT_DWINDLE;
+    free(wins);
+    return misordered;
+}
+
+/* Cells a client with increments shows, packed for comparison. */
+static long cells(const struct novawm_client *c) {
+    const struct novawm_size_hints *sh = &c->hints;
+    long cols = sh->inc_w > 1 ? (c->w - sh->base_w) / sh->inc_w : c->w;
+    long rows = sh->inc_h > 1 ? (c->h - sh->base_h) / sh->inc_h : c->h;
+    return cols << 16 | rows;
+}
+
+/* Tile BENCH_XTERMS terminals with xterm's resize increments on the
+ * current, empty workspace and move master_factor in steps far smaller
+ * than a character cell. Returns the resizes made by steps after which
+ * every terminal still had the same cell grid, which should be none. */
+static uint64_t bench_xterms(struct novawm_server *srv,
+                             struct novawm_window_info *info) {
+    struct novawm_window_info w = *info;
+    struct novawm_client *cs[BENCH_XTERMS];
+    xcb_window_t wins[BENCH_XTERMS];
+    long grid[BENCH_XTERMS];
+    float factor = srv->cfg.master_factor;
+    uint64_t resizes = 0, flat = 0;
+    int changed = 0;
+
+    w.hints.base_w = 4;
+    w.hints.base_h = 4;
+    w.hints.inc_w = 6;
+    w.hints.inc_h = 13;
+    for (int i = 0; i < BENCH_XTERMS; i++) {
+        wins[i] = novawm_fake_create_window(srv, &w);
+        novawm_fake_dispatch(srv);
+        cs[i] = novawm_find_client(srv, wins[i]);
+        if (!cs[i])
+            return 0;
+    }
+
+    srv->cfg.master_factor = 0.3f;
+    novawm_arrange(srv);
+    novawm_fake_dispatch(srv);
+    for (int i = 0; i < BENCH_XTERMS; i++)
+        grid[i] = cells(cs[i]);
+
+    for (int s = 0; s < BENCH_FACTOR_STEPS; s++) {
+        uint64_t before = srv->stats.resizes;
+        srv->cfg.master_factor += 0.0002f;
+        novawm_arrange(srv);
+        novawm_fake_dispatch(srv);
+        uint64_t r = srv->stats.resizes - before;
+
+        bool same = true;
+        for (int i = 0; i < BENCH_XTERMS; i++) {
+            long g = cells(cs[i]);
+            if (g != grid[i])
+                same = false;
+            grid[i] = g;
+        }
+        if (same)
+            flat += r;
+        else
+            changed++;
+        resizes += r;
+    }
+    printf("  xterm    %d terminals, %d factor steps of 0.0002: %d changed a "
+           "cell grid, %" PRIu64 " resizes\n", BENCH_XTERMS,
+           BENCH_FACTOR_STEPS, changed, resizes);
+
+    srv->cfg.master_factor = factor;
+    for (int i = 0; i < BENCH_XTERMS; i++)
+        novawm_fake_destroy_window(srv, wins[i]);
+    novawm_fake_dispatch(srv);
+    return flat;
+}
+
+/* Small LCG: the same windows and points every run. */
+static uint32_t rnd(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+/* Scatter BENCH_QUERY_FLOATS floating windows of assorted sizes over the
+ * current, empty workspace, then time point queries at random spots and
+ * directional neighbour queries from each window. Returns the grid
+ * updates made by arranges that moved nothing, which should be none. */
+static uint64_t bench_query(struct novawm_server *srv,
+                            struct novawm_window_info *info) {
+    struct novawm_window_info pop = *info;
+    xcb_window_t wins[BENCH_QUERY_FLOATS];
+    struct novawm_client *cs[BENCH_QUERY_FLOATS];
+    char spec[] = "class:BenchPopup, float";
+    uint32_t seed = 1;
+
+    novawm_rules_add(&srv->cfg.rules, spec);
+    novawm_rules_compile(&srv->cfg.rules);
+    snprintf(pop.props.wm_class, sizeof pop.props.wm_class, "BenchPopup");
+    for (int i = 0; i < BENCH_QUERY_FLOATS; i++) {
+        pop.w = 100 + (int)(rnd(&seed) % 400);
+        pop.h = 80 + (int)(rnd(&seed) % 300);
+        pop.x = (int)(rnd(&seed) % (uint32_t)(srv->mon.w - pop.w));
+        pop.y = (int)(rnd(&seed) % (uint32_t)(srv->mon.h - pop.h));
+        wins[i] = novawm_fake_create_window(srv, &pop);
+        novawm_fake_dispatch(srv);
+        cs[i] = novawm_find_client(srv, wins[i]);
+    }
+
+    uint64_t updates = srv->stats.grid_updates;
+    for (int i = 0; i < BENCH_ARRANGES; i++) {
+        novawm_arrange(srv);
+        novawm_fake_dispatch(srv);
+    }
+    updates = srv->stats.grid_updates - updates;
+
+    int hits = 0;
+    uint64_t t0 = novawm_now_us();
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        int x = (int)(rnd(&seed) % (uint32_t)srv->mon.w);
+        int y = (int)(rnd(&seed) % (uint32_t)srv->mon.h);
+        if (novawm_spatial_at(srv, x, y))
+            hits++;
+    }
+    uint64_t point_us = novawm_now_us() - t0;
+
+    int found = 0, dirs = 0;
+    t0 = novawm_now_us();
+    while (dirs < BENCH_QUERIES) {
+        for (int i = 0; i < BENCH_QUERY_FLOATS; i++, dirs++)
+            if (cs[i] && novawm_spatial_neighbor(srv, cs[i],
+                                                 (enum novawm_dir)(dirs % 4)))
+                found++;
+    }
+    uint64_t dir_us = novawm_now_us() - t0;
+
+    printf("  query    %d floating: %.0f ns per point query (%d%% hit), "
+           "%.0f ns per direction (%d%% found), %.1f grid updates per "
+           "arrange\n", BENCH_QUERY_FLOATS,
+           (double)point_us * 1000.0 / BENCH_QUERIES,
+           hits * 100 / BENCH_QUERIES, (double)dir_us * 1000.0 / dirs,
+           (int)((int64_t)found * 100 / dirs),
+           (double)updates / BENCH_ARRANGES);
+
+    for (int i = 0; i < BENCH_QUERY_FLOATS; i++)
+        novawm_fake_destroy_window(srv, wins[i]);
+    novawm_fake_dispatch(srv);
+    return updates;
+}
+
+/* Manage `n` windows under 3 * BENCH_RULES exact class rules and
+ * BENCH_RULES each of glob and regex ones, half the windows with a class
+ * that has a rule. */
+static void bench_rules(struct novawm_server *srv, struct bench_phase *ph,
+                        struct novawm_window_info *info,
+                        xcb_window_t *wins, int n) {
+    struct novawm_rules *rules = &srv->cfg.rules;
+    char spec[128];
+
+    uint64_t t0 = novawm_now_us();
+    for (int i = 0; i < 3 * BENCH_RULES; i++) {
+        snprintf(spec, sizeof spec, "class:App%d, workspace %d", i,
+                 1 + i % NOVAWM_WORKSPACES);
+        novawm_rules_add(rules, spec);
+    }
+    for (int i = 0; i < BENCH_RULES; i++) {
+        snprintf(spec, sizeof spec, "title:*doc%d-*, float", i);
+        novawm_rules_add(rules, spec);
+        snprintf(spec, sizeof spec, "instance:~^term%d(-[a-z]+)?$, size "
+                 "800x600", i);
+        novawm_rules_add(rules, spec);
+    }
+    novawm_rules_compile(rules);
+    uint64_t compile_us = novawm_now_us() - t0;
+
+    struct novawm_window_info w = *info;
+    phase_begin(ph);
+    for (int i = 0; i < n; i++) {
+        snprintf(w.props.wm_class, sizeof w.props.wm_class, "App%d",
+                 i % (6 * BENCH_RULES));
+        snprintf(w.props.instance, sizeof w.props.instance, "term%d",
+                 i % (2 * BENCH_RULES));
+        snprintf(w.props.title, sizeof w.props.title, "doc%d-%d",
+                 i % (2 * BENCH_RULES), i);
+        wins[i] = novawm_fake_create_window(srv, &w);
+        ph->events += novawm_fake_dispatch(srv);
+    }
+    phase_end(ph, "rules", n);
+    printf("          %d rules compiled in %.2f ms\n", rules->len,
+           (double)compile_us / 1000.0);
+
+    for (int i = 0; i < n; i++)
+        novawm_fake_destroy_window(srv, wins[i]);
+    novawm_fake_dispatch(srv);
+}
+
+int novawm_bench(int windows) {
+    static struct novawm_server srv;
+    struct bench_phase ph;
+    uint64_t steady = 0, flip_configures, fullscreen_configures, late;
+    uint64_t hidden_frames, grid_updates, overruns, outline_configures;
+    uint64_t cell_resizes, misordered;
+
+    if (windows <= 0)
+        windows = 1000;
+    xcb_window_t *wins = calloc((size_t)windows, sizeof *wins);
+    if (!wins)
+        return 1;
+
+    novawm_audit_init(&srv);
+    novawm_trace_init(&srv);
+    novawm_config_load(&srv.cfg, "/dev/null"); /* defaults only */
+    srv.cfg.state_shm = false;
+    srv.cfg.client_pool = windows + 1;  /* the kill phase's newcomer */
+    srv.cfg.bar = NOVAWM_BAR_TOP;   /* bookkeeping only, nothing is drawn */
+    novawm_fake_init(&srv, 1920, 1080);
+    if (!novawm_server_init(&srv))
+        return 1;
+    novawm_bar_init(&srv);
+    srv.running = true;
+
+    printf("novawm: bench, %d windows over %d workspaces, %s backend\n",
+           windows, NOVAWM_WORKSPACES, srv.backend->name);
+#if !defined(__GLIBC__) || !defined(NOVAWM_COUNT_ALLOCS)
+    printf("novawm: bench: allocations not counted, steady phases unchecked "
+           "(configure with -DNOVAWM_COUNT_ALLOCS=ON)\n");
+#endif
+
+    /* each window arrives on its own, as if started one after another */
+    int per_ws = (windows + NOVAWM_WORKSPACES - 1) / NOVAWM_WORKSPACES;
+    struct novawm_window_info info = {
+        .w = 640,
+        .h = 480,
+        .props = { .wm_class = "Bench", .instance = "bench", .type = "" },
+    };
+    phase_begin(&ph);
+    for (int i = 0; i < windows; i++) {
+        if (i % per_ws == 0) {
+            workspace(&srv, i / per_ws);
+            ph.events += novawm_fake_dispatch(&srv);
+        }
+        snprintf(info.props.title, sizeof info.props.title, "bench %d", i);
+        wins[i] = novawm_fake_create_window(&srv, &info);
+        ph.events += novawm_fake_dispatch(&srv);
+    }
+    phase_end(&ph, "manage", windows);
+
+    phase_begin(&ph);
+    for (int r = 0; r < BENCH_SWITCH_ROUNDS; r++) {
+        for (int w = 0; w < NOVAWM_WORKSPACES; w++) {
+            workspace(&srv, w);
+            ph.events += novawm_fake_dispatch(&srv);
+        }
+    }
+    steady += phase_end(&ph, "switch", BENCH_SWITCH_ROUNDS * NOVAWM_WORKSPACES);
+
+    /* back and forth between two full workspaces: all cached slots */
+    phase_begin(&ph);
+    uint64_t cached = srv.stats.layouts_cached;
+    for (int i = 0; i < BENCH_FLIPS; i++) {
+        workspace(&srv, i % 2);
+        ph.events += novawm_fake_dispatch(&srv);
+    }
+    flip_configures = novawm_fake_requests()[NOVAWM_REQ_CONFIGURE] -
+                      ph.requests[NOVAWM_REQ_CONFIGURE];
+    steady += phase_end(&ph, "flip", BENCH_FLIPS);
+    printf("          %" PRIu64 " of %d layouts from cached slots, "
+           "%" PRIu64 " configures\n", srv.stats.layouts_cached - cached,
+           BENCH_FLIPS, flip_configures);
+
+    /* the same with a fullscreen window on one of the two */
+    workspace(&srv, 0);
+    novawm_dispatch_action(&srv, "fullscreen", "");
+    novawm_fake_dispatch(&srv);
+    phase_begin(&ph);
+    uint64_t frames = srv.stats.frames;
+    for (int i = 0; i < BENCH_FLIPS; i++) {
+        workspace(&srv, (i + 1) % 2);
+        ph.events += novawm_fake_dispatch(&srv);
+    }
+    fullscreen_configures = novawm_fake_requests()[NOVAWM_REQ_CONFIGURE] -
+                            ph.requests[NOVAWM_REQ_CONFIGURE];
+    frames = srv.stats.frames - frames;
+    uint64_t requests = requests_since(&ph);
+    steady += phase_end(&ph, "fullscr", BENCH_FLIPS);
+    printf("          %.1f requests per frame, %" PRIu64 " configures\n",
+           frames ? (double)requests / frames : 0.0, fullscreen_configures);
+    workspace(&srv, 0);
+    novawm_dispatch_action(&srv, "fullscreen", "");
+    novawm_fake_dispatch(&srv);
+
+    /* nothing changed, so this should cost no requests */
+    phase_begin(&ph);
+    for (int i = 0; i < BENCH_ARRANGES; i++) {
+        novawm_arrange(&srv);
+        ph.events += novawm_fake_dispatch(&srv);
+    }
+    steady += phase_end(&ph, "arrange", BENCH_ARRANGES);
+
+    /* windows closing and new ones taking their place */
+    int churn = windows * BENCH_CHURN_PERCENT / 100;
+    phase_begin(&ph);
+    for (int i = 0; i < churn; i++) {
+        int k = i * (windows / (churn ? churn : 1));
+        novawm_fake_destroy_window(&srv, wins[k]);
+        ph.events += novawm_fake_dispatch(&srv);
+        wins[k] = novawm_fake_create_window(&srv, &info);
+        ph.events += novawm_fake_dispatch(&srv);
+    }
+    steady += phase_end(&ph, "churn", churn);
+
+    hidden_frames = bench_paint(&srv, &info);
+
+    steady += bench_scratchpad(&srv, &ph, &info);
+    steady += bench_kill(&srv, &ph, &info, &late);
+
+    /* a held grow/shrink key, folded into frames or not */
+    int presses = 1 + (BENCH_HOLD_MS - BENCH_REPEAT_DELAY + BENCH_REPEAT_MS
+                       - 1) / BENCH_REPEAT_MS;
+    uint64_t held = bench_hold(&srv, 1, false);
+    uint64_t held16 = bench_hold(&srv, 16, true);
+    uint64_t held100 = bench_hold(&srv, 100, true);
+    printf("  hold     %d s grow then shrink, %d presses each: "
+           "%" PRIu64 " ConfigureNotify uncoalesced, %" PRIu64
+           " in 16 ms frames, %" PRIu64 " in 100 ms frames\n",
+           BENCH_HOLD_MS / 1000, presses, held, held16, held100);
+
+    /* the same actions as separate presses and as one action list */
+    phase_begin(&ph);
+    uint64_t early_flushes = 0;
+    uint64_t separate = bench_chain(&srv, &ph, false, &early_flushes);
+    phase_end(&ph, "presses", BENCH_CHAIN_ROUNDS);
+    phase_begin(&ph);
+    uint64_t listed = bench_chain(&srv, &ph, true, &early_flushes);
+    phase_end(&ph, "list", BENCH_CHAIN_ROUNDS);
+    printf("  %d-action list: %.1f requests as presses, %.1f as one list\n",
+           BENCH_CHAIN_STEPS, (double)separate / BENCH_CHAIN_ROUNDS,
+           (double)listed / BENCH_CHAIN_ROUNDS);
+
+    phase_begin(&ph);
+    for (int i = 0; i < windows; i++) {
+        novawm_fake_destroy_window(&srv, wins[i]);
+        ph.events += novawm_fake_dispatch(&srv);
+    }
+    phase_end(&ph, "destroy", windows);
+
+    bench_layout(&srv, &info, NOVAWM_LAYOUT_DWINDLE, "dwindle");
+    bench_layout(&srv, &info, NOVAWM_LAYOUT_BSP, "bsp");
+    for (int n = 10; n <= BENCH_CYCLE_MAX; n *= 10) {
+        bench_cycle(&srv, &info, NOVAWM_LAYOUT_MONOCLE, "monocle", n);
+        bench_cycle(&srv, &info, NOVAWM_LAYOUT_DWINDLE, "dwindle", n);
+    }
+    grid_updates = bench_query(&srv, &info);
+    overruns = bench_sync(&srv, &info);
+    outline_configures = bench_drag_modes(&srv, &info);
+    cell_resizes = bench_xterms(&srv, &info);
+    misordered = bench_focus(&srv, &info);
+    bench_rules(&srv, &ph, &info, wins, windows);
+
+    if (getenv("NOVAWM_BENCH_TRACE"))
+        novawm_trace_dump(&srv);
+
+    /* what the always-on trace costs: one record, and records per event */
+    double per_event = srv.stats.events
+        ? (double)srv.trace.head / (double)srv.stats.events : 0.0;
+    uint64_t t0 = novawm_now_us();
+    for (uint32_t i = 0; i < BENCH_TRACE_RECORDS; i++)
+        novawm_trace(&srv, NOVAWM_TRACE_FLUSH, 0, i, NULL);
+    double ns = (double)(novawm_now_us() - t0) * 1000.0 / BENCH_TRACE_RECORDS;
+    printf("  trace    %.1f ns/record, %.1f records/event, "
+           "%.1f ns/event\n", ns, per_event, ns * per_event);
+
+    novawm_stats_dump(&srv, stdout);
+    novawm_trace_fini(&srv);
+    novawm_fake_fini();
+    free(wins);
+
+    int status = 0;
+    if (steady) {
+        printf("novawm: bench: %" PRIu64 " allocations in steady state\n",
+               steady);
+        status = 1;
+    }
+    if (flip_configures) {
+        printf("novawm: bench: %" PRIu64 " configures flipping workspaces\n",
+               flip_configures);
+        status = 1;
+    }
+    if (fullscreen_configures) {
+        printf("novawm: bench: %" PRIu64 " configures flipping to a "
+               "fullscreen workspace\n", fullscreen_configures);
+        status = 1;
+    }
+    if (hidden_frames) {
+        printf("novawm: bench: %" PRIu64 " frames painted by hidden "
+               "windows\n", hidden_frames);
+        status = 1;
+    }
+    if (early_flushes) {
+        printf("novawm: bench: %" PRIu64 " flushes before the end of an "
+               "action list\n", early_flushes);
+        status = 1;
+    }
+    if (grid_updates) {
+        printf("novawm: bench: %" PRIu64 " grid updates from arranges that "
+               "moved nothing\n", grid_updates);
+        status = 1;
+    }
+    if (overruns) {
+        printf("novawm: bench: %" PRIu64 " resizes sent to a client still "
+               "painting\n", overruns);
+        status = 1;
+    }
+    if (outline_configures) {
+        printf("novawm: bench: %" PRIu64 " client configures during "
+               "outline drags\n", outline_configures);
+        status = 1;
+    }
+    if (cell_resizes) {
+        printf("novawm: bench: %" PRIu64 " resizes that kept every cell "
+               "grid\n", cell_resizes);
+        status = 1;
+    }
+    if (misordered) {
+        printf("novawm: bench: %" PRIu64 " focusnext+focuslast batches "
+               "that did not return\n", misordered);
+        status = 1;
+    }
+    if (late) {
+        printf("novawm: bench: %" PRIu64 " requests for windows known to "
+               "be gone\n", late);
+        status = 1;
+    }
+    if (srv.audit.violations) {     /* NOVAWM_AUDIT builds only */
+        printf("novawm: bench: %" PRIu64 " events over the audit budget\n",
+               srv.audit.violations);
+        status = 1;
+    }
+    return status;
+}
+
+/* `novawm --bench-boost N`: N busy processes (default twice the CPUs)
+ * compete with an "app". Every BOOST_PERIOD_US the app is woken as if
+ * input arrived, spends BOOST_WORK_US of CPU as if painting, and records
+ * the time from the input to the end of the paint. That is the scheduling
+ * part of input-to-paint latency. The bench runs once with the app
+ * unfocused and once focused, boosted through the same path a focused
+ * window takes. */
+
+#define BOOST_SAMPLES   500
+#define BOOST_PERIOD_US 4000
+#define BOOST_WORK_US   500
+
+static uint64_t cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void boost_hog(void) {
+    novawm_boost_enter_scope();
+    for (volatile uint64_t spin = 0;; spin++)
+        ;
+}
+
+/* Enters its scope, says so on `ready`, waits for `go`, then measures. */
+static void boost_app(int ready, int go, uint32_t *late_us) {
+    char byte = 0;
+    novawm_boost_enter_scope();
+    if (write(ready, &byte, 1) != 1 || read(go, &byte, 1) != 1)
+        _exit(1);
+
+    struct timespec due;
+    clock_gettime(CLOCK_MONOTONIC, &due);
+    for (int i = 0; i < BOOST_SAMPLES; i++) {
+        due.tv_nsec += BOOST_PERIOD_US * 1000;
+        if (due.tv_nsec >= 1000000000) {
+            due.tv_nsec -= 1000000000;
+            due.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+
+        uint64_t paint = cpu_ns() + BOOST_WORK_US * 1000u;
+        while (cpu_ns() < paint)
+            ;
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t ns = (int64_t)(now.tv_sec - due.tv_sec) * 1000000000 +
+                     (now.tv_nsec - due.tv_nsec);
+        late_us[i] = ns > 0 ? (uint32_t)(ns / 1000) : 0;
+    }
+    _exit(0);
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Returns false if the app could not be run or boosted. */
+static bool boost_pass(struct novawm_server *srv, bool focused,
+                       uint32_t *late_us) {
+    int ready[2], go[2];
+    if (pipe(ready) != 0 || pipe(go) != 0)
+        return false;
+
+    pid_t pid = fork();
+    if (pid == 0)
+        boost_app(ready[1], go[0], late_us);
+
+    char byte = 0;
+    bool ok = pid > 0 && read(ready[0], &byte, 1) == 1;
+
+    struct novawm_client app = { .pid = pid };
+    struct novawm_workspace *ws = &srv->mon.ws[srv->mon.current_ws];
+    if (ok && focused) {
+        ws->focused = &app;
+        novawm_boost_update(srv);
+        ok = srv->boost.boosted == pid;
+    }
+
+    if (pid > 0) {
+        if (!ok || write(go[1], &byte, 1) != 1)
+            kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    if (focused) {
+        ws->focused = NULL;
+        novawm_boost_update(srv);
+    }
+    close(ready[0]);
+    close(ready[1]);
+    close(go[0]);
+    close(go[1]);
+    return ok;
+}
+
+static void boost_report(const char *name, uint32_t *late_us) {
+    qsort(late_us, BOOST_SAMPLES, sizeof *late_us, cmp_u32);
+    printf("  %-10s p50 %6" PRIu32 " us  p99 %6" PRIu32 " us  max %6" PRIu32
+           " us\n", name, late_us[BOOST_SAMPLES / 2],
+           late_us[BOOST_SAMPLES * 99 / 100], late_us[BOOST_SAMPLES - 1]);
+}
+
+int novawm_bench_boost(int hogs) {
+    static struct novawm_server srv;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        cpus = 1;
+    if (hogs <= 0)
+        hogs = (int)(2 * cpus);
+
+    novawm_config_load(&srv.cfg, "/dev/null"); /* defaults only */
+    srv.cfg.focus_boost = NOVAWM_BOOST_AUTO;
+    srv.cfg.focus_boost_interval = 0;
+    novawm_boost_init(&srv);
+    if (srv.boost.mode == NOVAWM_BOOST_OFF)
+        return 1;
+
+    /* shared with the app process */
+    uint32_t *late_us = mmap(NULL, BOOST_SAMPLES * sizeof *late_us,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t *hog = calloc((size_t)hogs, sizeof *hog);
+    if (late_us == MAP_FAILED || !hog)
+        return 1;
+
+    printf("novawm: boost bench, %d busy processes on %ld CPUs, %d inputs "
+           "every %d us each painting for %d us, %s boost\n", hogs, cpus,
+           BOOST_SAMPLES, BOOST_PERIOD_US, BOOST_WORK_US,
+           srv.boost.mode == NOVAWM_BOOST_CGROUP ? "cgroup" : "nice");
+
+    for (int i = 0; i < hogs; i++) {
+        hog[i] = fork();
+        if (hog[i] == 0)
+            boost_hog();
+    }
+
+    int status = 0;
+    if (boost_pass(&srv, false, late_us))
+        boost_report("unfocused", late_us);
+    else
+        status = 1;
+    if (boost_pass(&srv, true, late_us))
+        boost_report("focused", late_us);
+    else
+        status = 1;
+
+    for (int i = 0; i < hogs; i++) {
+        if (hog[i] > 0) {
+            kill(hog[i], SIGKILL);
+            waitpid(hog[i], NULL, 0);
+        }
+    }
+    if (status)
+        printf("novawm: bench: could not boost the app (%" PRIu64
+               " failures)\n", srv.boost.failures);
+    free(hog);
+    munmap(late_us, BOOST_SAMPLES * sizeof *late_us);
+    return status;
+}
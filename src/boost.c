@@ -0,0 +1,343 @@
+#include "novawm.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Focus boost: the process owning the focused window (_NET_WM_PID) gets
+ * more CPU than the rest of the session, so a background build does not
+ * starve the application being typed into.
+ *
+ * cgroup: if NovaWM's own cgroup v2 is delegated to it, NovaWM moves
+ * itself into a "wm" leaf, enables the cpu controller and starts every
+ * spawned program in an "app-<pid>" scope beside it. Focus raises that
+ * scope's cpu.weight, so the whole application, helpers included, gains.
+ * nice: otherwise, and for processes outside those scopes, every thread
+ * of the process is reniced. That needs CAP_SYS_NICE or RLIMIT_NICE, and
+ * is only done to processes of our own user: _NET_WM_PID is set by the
+ * client and may name anything.
+ *
+ * Like the bar, the wanted process is derived from the focus once per
+ * frame. It changes at most once per focus_boost_interval, so cycling
+ * through windows costs one change and not one per window. Only plain
+ * system calls are used, so the event loop still does not allocate. */
+
+#define CGROUP_MOUNT    "/sys/fs/cgroup"
+#define CPU_WEIGHT_BASE "100"
+#define NICE_MIN        (-20)
+
+/* our delegated cgroup directory, "" without one; also used by spawned
+ * children between fork and exec */
+static char scope_root[256];
+
+struct boost_dirent {
+    uint64_t       ino;
+    int64_t        off;
+    unsigned short reclen;
+    unsigned char  type;
+    char           name[];
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static bool write_file(const char *path, const char *s) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    size_t len = strlen(s);
+    bool ok = write(fd, s, len) == (ssize_t)len;
+    close(fd);
+    return ok;
+}
+
+static bool read_file(const char *path, char *buf, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0)
+        return false;
+    buf[n] = '\0';
+    return true;
+}
+
+/* Directory of the cgroup v2 `pid` (0 = us) is in, under CGROUP_MOUNT. */
+static bool cgroup_dir(pid_t pid, char *out, size_t size) {
+    char path[64], buf[1024];
+    if (pid)
+        snprintf(path, sizeof path, "/proc/%d/cgroup", (int)pid);
+    else
+        snprintf(path, sizeof path, "/proc/self/cgroup");
+    if (!read_file(path, buf, sizeof buf))
+        return false;
+
+    char *line = strstr(buf, "0::/");
+    if (!line || (line != buf && line[-1] != '\n'))
+        return false;
+    line += 3;
+    line[strcspn(line, "\n")] = '\0';
+    int n = snprintf(out, size, CGROUP_MOUNT "%s", line);
+    return n > 0 && (size_t)n < size;
+}
+
+static bool has_word(const char *list, const char *word) {
+    size_t len = strlen(word);
+    for (const char *p = list; (p = strstr(p, word)); p += len)
+        if ((p == list || p[-1] == ' ') &&
+            (p[len] == '\0' || p[len] == ' ' || p[len] == '\n'))
+            return true;
+    return false;
+}
+
+/* Empty app scopes left by programs that have exited since the last
+ * start; a populated one refuses rmdir. */
+static void remove_stale_scopes(void) {
+    DIR *d = opendir(scope_root);
+    if (!d)
+        return;
+    char path[512];
+    for (struct dirent *e; (e = readdir(d)); ) {
+        if (strncmp(e->d_name, "app-", 4))
+            continue;
+        snprintf(path, sizeof path, "%s/%s", scope_root, e->d_name);
+        rmdir(path);
+    }
+    closedir(d);
+}
+
+/* Take over our cgroup if it is delegated: we go into a "wm" leaf (no
+ * process may sit in a cgroup whose children have controllers) and the
+ * cpu controller is enabled for the scopes. */
+static bool cgroup_setup(void) {
+    char dir[256], path[320], buf[256];
+    if (!cgroup_dir(0, dir, sizeof dir))
+        return false;
+
+    /* restarted in place: already in our own leaf */
+    size_t len = strlen(dir);
+    if (len > 3 && !strcmp(dir + len - 3, "/wm"))
+        dir[len - 3] = '\0';
+    if (!strcmp(dir, CGROUP_MOUNT))
+        return false;   /* the root cgroup is never ours */
+
+    snprintf(path, sizeof path, "%s/cgroup.controllers", dir);
+    if (!read_file(path, buf, sizeof buf) || !has_word(buf, "cpu"))
+        return false;
+
+    snprintf(path, sizeof path, "%s/wm", dir);
+    if (mkdir(path, 0755) != 0 && errno != EEXIST)
+        return false;
+    snprintf(path, sizeof path, "%s/wm/cgroup.procs", dir);
+    if (!write_file(path, "0"))
+        return false;
+    snprintf(path, sizeof path, "%s/cgroup.subtree_control", dir);
+    if (!write_file(path, "+cpu"))
+        return false;
+
+    snprintf(scope_root, sizeof scope_root, "%s", dir);
+    remove_stale_scopes();
+    return true;
+}
+
+void novawm_boost_init(struct novawm_server *srv) {
+    struct novawm_boost *b = &srv->boost;
+    enum novawm_boost_mode mode = srv->cfg.focus_boost;
+
+    memset(b, 0, sizeof *b);
+    if (mode == NOVAWM_BOOST_OFF)
+        return;
+
+    if (mode != NOVAWM_BOOST_NICE)
+        b->cgroup_ok = cgroup_setup();
+    b->nice_ok = mode != NOVAWM_BOOST_CGROUP;
+
+    if (!b->cgroup_ok && !b->nice_ok) {
+        fprintf(stderr, "novawm: focus_boost: no delegated cgroup v2 with "
+                "the cpu controller, boost disabled\n");
+        return;
+    }
+    b->mode = b->cgroup_ok ? NOVAWM_BOOST_CGROUP : NOVAWM_BOOST_NICE;
+}
+
+/* In a spawned child, before exec: a scope of its own, so that focus can
+ * weight it against the rest. */
+void novawm_boost_enter_scope(void) {
+    if (!scope_root[0])
+        return;
+
+    char path[320];
+    int n = snprintf(path, sizeof path, "%s/app-%d", scope_root,
+                     (int)getpid());
+    if (n <= 0 || (size_t)n >= sizeof path - 16)
+        return;
+    if (mkdir(path, 0755) != 0 && errno != EEXIST)
+        return;
+    snprintf(path + n, sizeof path - (size_t)n, "/cgroup.procs");
+    write_file(path, "0");
+}
+
+/* Renice every thread of `pid`: on Linux nice is per thread. */
+static bool renice(pid_t pid, int nice) {
+    char path[64], buf[2048];
+    snprintf(path, sizeof path, "/proc/%d/task", (int)pid);
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    bool ok = true, any = false;
+    long n;
+    while ((n = syscall(SYS_getdents64, fd, buf, sizeof buf)) > 0) {
+        for (long off = 0; off < n; ) {
+            struct boost_dirent *d = (struct boost_dirent *)(buf + off);
+            off += d->reclen;
+            if (d->name[0] < '0' || d->name[0] > '9')
+                continue;
+            if (setpriority(PRIO_PROCESS, (id_t)atoi(d->name), nice) != 0)
+                ok = false;
+            else
+                any = true;
+        }
+    }
+    int err = errno;
+    close(fd);
+    errno = err;
+    return ok && any;
+}
+
+static bool boost_cgroup(struct novawm_server *srv, pid_t pid) {
+    struct novawm_boost *b = &srv->boost;
+    char dir[256], path[320], weight[16];
+
+    /* only our own scopes: anything else is not ours to re-weight */
+    size_t root = strlen(scope_root);
+    if (!b->cgroup_ok || !cgroup_dir(pid, dir, sizeof dir) ||
+        strncmp(dir, scope_root, root) || strncmp(dir + root, "/app-", 5))
+        return false;
+
+    snprintf(path, sizeof path, "%s/cpu.weight", dir);
+    snprintf(weight, sizeof weight, "%d", srv->cfg.focus_boost_weight);
+    if (!write_file(path, weight)) {
+        b->failures++;
+        return false;
+    }
+    snprintf(b->cgroup, sizeof b->cgroup, "%s", dir);
+    b->how = NOVAWM_BOOST_CGROUP;
+    return true;
+}
+
+/* `pid` is a process of ours: /proc/<pid> belongs to our uid. */
+static bool owned(pid_t pid) {
+    char path[32];
+    struct stat st;
+    snprintf(path, sizeof path, "/proc/%d", (int)pid);
+    return stat(path, &st) == 0 && st.st_uid == getuid();
+}
+
+static bool boost_nice(struct novawm_server *srv, pid_t pid) {
+    struct novawm_boost *b = &srv->boost;
+    static bool warned;
+    if (!b->nice_ok || !owned(pid))
+        return false;
+
+    errno = 0;
+    int base = getpriority(PRIO_PROCESS, (id_t)pid);
+    if (base == -1 && errno)
+        return false;   /* gone already */
+
+    int nice = base - srv->cfg.focus_boost_nice;
+    if (nice < NICE_MIN)
+        nice = NICE_MIN;
+    if (!renice(pid, nice)) {
+        int err = errno;
+        b->failures++;
+        renice(pid, base);  /* any thread that did change */
+        /* only this client goes without; the next may be allowed */
+        if ((err == EPERM || err == EACCES) && !warned) {
+            fprintf(stderr, "novawm: focus_boost: cannot lower nice of %d "
+                    "(needs CAP_SYS_NICE or RLIMIT_NICE)\n", (int)pid);
+            warned = true;
+        }
+        return false;
+    }
+    b->base_nice = base;
+    b->how = NOVAWM_BOOST_NICE;
+    return true;
+}
+
+static void unboost(struct novawm_server *srv) {
+    struct novawm_boost *b = &srv->boost;
+    char path[320];
+
+    if (b->how == NOVAWM_BOOST_CGROUP) {
+        snprintf(path, sizeof path, "%s/cpu.weight", b->cgroup);
+        write_file(path, CPU_WEIGHT_BASE);  /* fails only if it is gone */
+    } else if (b->how == NOVAWM_BOOST_NICE && owned(b->boosted)) {
+        /* not if the PID has gone to another user since */
+        renice(b->boosted, b->base_nice);
+    }
+    b->boosted = 0;
+    b->how = NOVAWM_BOOST_OFF;
+}
+
+static pid_t wanted(struct novawm_server *srv) {
+    struct novawm_client *f = srv->scratch_focused
+        ? srv->scratch_focused : srv->mon.ws[srv->mon.current_ws].focused;
+    return f && f->pid != getpid() ? f->pid : 0;
+}
+
+/* Once per frame, and when the poll timeout below expires. */
+void novawm_boost_update(struct novawm_server *srv) {
+    struct novawm_boost *b = &srv->boost;
+    if (b->mode == NOVAWM_BOOST_OFF)
+        return;
+
+    pid_t want = wanted(srv);
+    if (want == b->wanted)
+        return;
+
+    uint64_t now = now_ms();
+    if (b->changed_ms &&
+        now - b->changed_ms < (uint64_t)srv->cfg.focus_boost_interval) {
+        b->deferred++;
+        return;
+    }
+
+    if (b->boosted && b->boosted != want)
+        unboost(srv);
+    if (want && !b->boosted &&
+        (boost_cgroup(srv, want) || boost_nice(srv, want)))
+        b->boosted = want;
+    b->wanted = want;
+    b->changed_ms = now;
+    b->changes++;
+}
+
+/* poll() timeout until a held-back change may be made, -1 if none */
+int novawm_boost_timeout(struct novawm_server *srv) {
+    struct novawm_boost *b = &srv->boost;
+    if (b->mode == NOVAWM_BOOST_OFF || wanted(srv) == b->wanted)
+        return -1;
+
+    uint64_t due = b->changed_ms + (uint64_t)srv->cfg.focus_boost_interval;
+    uint64_t now = now_ms();
+    return due <= now ? 0 : (int)(due - now);
+}
+
+/* Give the boost back; the next update starts over. */
+void novawm_boost_fini(struct novawm_server *srv) {
+    if (srv->boost.boosted)
+        unboost(srv);
+    srv->boost.wanted = 0;
+    srv->boost.changed_ms = 0;
+}
@@ -0,0 +1,209 @@
+#include "novawm.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Persistent split tree for the bsp layout. A new tiled client splits the
+ * leaf of the window focused before it, along that leaf's longer side; a
+ * removed one gives its whole rectangle to its sibling. Everything else in
+ * the tree keeps its rectangle, so opening or closing a window reconfigures
+ * only the windows it shares a split with. Nodes come from a pool sized
+ * with the client pool, so a warmed-up WM does not allocate for them. */
+
+#define BSP_RATIO_MIN 0.05f
+#define BSP_RATIO_MAX 0.95f
+
+bool novawm_bsp_init(struct novawm_server *srv) {
+    struct novawm_bsp_pool *p = &srv->bsp_pool;
+    int size = 2 * srv->cfg.client_pool;
+
+    p->nodes = size ? calloc((size_t)size, sizeof *p->nodes) : NULL;
+    if (size && !p->nodes)
+        return false;
+    p->size = size;
+    p->free = NULL;
+    for (int i = size - 1; i >= 0; i--) {
+        p->nodes[i].parent = p->free;
+        p->free = &p->nodes[i];
+    }
+    return true;
+}
+
+static struct novawm_bsp_node *node_alloc(struct novawm_server *srv) {
+    struct novawm_bsp_pool *p = &srv->bsp_pool;
+    struct novawm_bsp_node *n = p->free;
+    if (!n) {
+        n = calloc(1, sizeof *n);
+        if (n)
+            p->overflow++;
+        return n;
+    }
+    p->free = n->parent;
+    p->used++;
+    memset(n, 0, sizeof *n);
+    return n;
+}
+
+static void node_free(struct novawm_server *srv, struct novawm_bsp_node *n) {
+    struct novawm_bsp_pool *p = &srv->bsp_pool;
+    if (n < p->nodes || n >= p->nodes + p->size) {
+        free(n);
+        return;
+    }
+    n->parent = p->free;
+    p->free = n;
+    p->used--;
+}
+
+/* Put `with` where `old` hangs in the tree. */
+static void node_replace(struct novawm_workspace *ws,
+                         struct novawm_bsp_node *old,
+                         struct novawm_bsp_node *with) {
+    struct novawm_bsp_node *p = old->parent;
+    with->parent = p;
+    if (!p)
+        ws->bsp = with;
+    else
+        p->child[p->child[0] == old ? 0 : 1] = with;
+}
+
+/* Split the leaf of the most recently focused client still in the tree,
+ * or start the tree. */
+static void bsp_insert(struct novawm_server *srv, struct novawm_workspace *ws,
+                       struct novawm_client *c) {
+    struct novawm_bsp_node *leaf = node_alloc(srv);
+    if (!leaf)
+        return;
+    leaf->client = c;
+
+    struct novawm_client *t = ws->mru;
+    while (t && (t == c || !t->leaf))
+        t = t->mru_next;
+    struct novawm_bsp_node *target = t ? t->leaf : ws->bsp;
+    if (!target) {
+        ws->bsp = leaf;
+        c->leaf = leaf;
+        return;
+    }
+    /* the tree can only be non-empty with a leaf somewhere */
+    while (target->child[0])
+        target = target->child[1];
+
+    struct novawm_bsp_node *split = node_alloc(srv);
+    if (!split) {
+        node_free(srv, leaf);
+        return;
+    }
+    struct novawm_client *tc = target->client;
+    split->ratio = 0.5f;
+    split->vertical = !tc->tile_w || tc->tile_w >= tc->tile_h;
+    node_replace(ws, target, split);
+    split->child[0] = target;
+    split->child[1] = leaf;
+    target->parent = split;
+    leaf->parent = split;
+    c->leaf = leaf;
+}
+
+void novawm_bsp_remove(struct novawm_server *srv, struct novawm_workspace *ws,
+                       struct novawm_client *c) {
+    struct novawm_bsp_node *leaf = c->leaf;
+    if (!leaf)
+        return;
+    c->leaf = NULL;
+
+    struct novawm_bsp_node *split = leaf->parent;
+    if (!split) {
+        ws->bsp = NULL;
+    } else {
+        /* the sibling takes over the split's whole rectangle */
+        node_replace(ws, split, split->child[split->child[0] == leaf ? 1 : 0]);
+        node_free(srv, split);
+    }
+    node_free(srv, leaf);
+}
+
+/* Bring the tree in line with the workspace: floating clients leave it,
+ * tiled ones not in it yet are inserted in list order. */
+void novawm_bsp_sync(struct novawm_server *srv, struct novawm_workspace *ws) {
+    for (struct novawm_client *c = ws->clients; c; c = c->next) {
+        if (c->floating)
+            novawm_bsp_remove(srv, ws, c);
+        else if (!c->leaf)
+            bsp_insert(srv, ws, c);
+    }
+}
+
+/* Free a subtree that did not make it into a tree; its clients are
+ * inserted afresh by the next sync. */
+static void bsp_drop(struct novawm_server *srv, struct novawm_bsp_node *n) {
+    if (n->child[0]) {
+        bsp_drop(srv, n->child[0]);
+        bsp_drop(srv, n->child[1]);
+    } else {
+        n->client->leaf = NULL;
+    }
+    node_free(srv, n);
+}
+
+/* Restart builds a saved tree bottom-up: a leaf per client, then the
+ * splits joining them. Joining with a missing side gives the other side
+ * on its own, so windows that went away just drop out. */
+struct novawm_bsp_node *novawm_bsp_leaf(struct novawm_server *srv,
+                                        struct novawm_client *c) {
+    struct novawm_bsp_node *leaf = node_alloc(srv);
+    if (!leaf)
+        return NULL;
+    leaf->client = c;
+    c->leaf = leaf;
+    return leaf;
+}
+
+struct novawm_bsp_node *novawm_bsp_join(struct novawm_server *srv,
+                                        struct novawm_bsp_node *a,
+                                        struct novawm_bsp_node *b,
+                                        bool vertical, float ratio) {
+    if (!a || !b)
+        return a ? a : b;
+
+    struct novawm_bsp_node *split = node_alloc(srv);
+    if (!split) {
+        bsp_drop(srv, b);
+        return a;
+    }
+    if (!(ratio >= BSP_RATIO_MIN)) ratio = BSP_RATIO_MIN;
+    if (ratio > BSP_RATIO_MAX) ratio = BSP_RATIO_MAX;
+    split->ratio = ratio;
+    split->vertical = vertical;
+    split->child[0] = a;
+    split->child[1] = b;
+    a->parent = split;
+    b->parent = split;
+    return split;
+}
+
+/* Two clients trade leaves. */
+void novawm_bsp_swap(struct novawm_client *a, struct novawm_client *b) {
+    struct novawm_bsp_node *la = a->leaf, *lb = b->leaf;
+    if (!la || !lb)
+        return;
+    la->client = b;
+    lb->client = a;
+    a->leaf = lb;
+    b->leaf = la;
+}
+
+/* grow/shrink: move the split next to `c` by `delta` in its favour. */
+bool novawm_bsp_resize(struct novawm_client *c, float delta) {
+    struct novawm_bsp_node *leaf = c->leaf;
+    if (!leaf || !leaf->parent)
+        return false;
+
+    struct novawm_bsp_node *split = leaf->parent;
+    float r = split->ratio + (split->child[0] == leaf ? delta : -delta);
+    if (r < BSP_RATIO_MIN) r = BSP_RATIO_MIN;
+    if (r > BSP_RATIO_MAX) r = BSP_RATIO_MAX;
+    if (r == split->ratio)
+        return false;
+    split->ratio = r;
+    return true;
+}
@@ -65,6 +65,23 @@ bool novawm_config_load(struct novawm_config *cfg, const char *path) {
     cfg->gaps_inner = 5;
     cfg->gaps_outer = 10;
     cfg->focus_follows_mouse = false;
+    cfg->state_shm = true;
+    cfg->layout = NOVAWM_LAYOUT_DWINDLE;
+    cfg->drag_move_mode = NOVAWM_DRAG_LIVE;
+    cfg->drag_resize_mode = NOVAWM_DRAG_LIVE;
+    cfg->audit_budget_us = 1000;
+    cfg->audit_fail = false;
+    cfg->client_pool = 256;
+    cfg->lock_memory = false;
+    cfg->bar = NOVAWM_BAR_OFF;
+    cfg->bar_height = 0;
+    snprintf(cfg->bar_font, sizeof cfg->bar_font, "fixed");
+    cfg->bar_bg = 0x222222;
+    cfg->bar_fg = 0xbbbbbb;
+    cfg->focus_boost = NOVAWM_BOOST_OFF;
+    cfg->focus_boost_weight = 1000;
+    cfg->focus_boost_nice = 5;
+    cfg->focus_boost_interval = 250;
     cfg->binds_len = 0;
     cfg->autostart_len = 0;
 
@@ -127,6 +144,49 @@ bool novawm_config_load(struct novawm_config *cfg, const char *path) {
             continue;
         }
 
+        if (!strncmp(s, "focus_boost_weight", 18)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->focus_boost_weight = atoi(trim(eq+1));
+            if (cfg->focus_boost_weight < 1) cfg->focus_boost_weight = 1;
+            if (cfg->focus_boost_weight > 10000) cfg->focus_boost_weight = 10000;
+            continue;
+        }
+
+        if (!strncmp(s, "focus_boost_nice", 16)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->focus_boost_nice = atoi(trim(eq+1));
+            if (cfg->focus_boost_nice < 0) cfg->focus_boost_nice = 0;
+            if (cfg->focus_boost_nice > 39) cfg->focus_boost_nice = 39;
+            continue;
+        }
+
+        if (!strncmp(s, "focus_boost_interval", 20)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->focus_boost_interval = atoi(trim(eq+1));
+            if (cfg->focus_boost_interval < 0) cfg->focus_boost_interval = 0;
+            if (cfg->focus_boost_interval > 10000) cfg->focus_boost_interval = 10000;
+            continue;
+        }
+
+        if (!strncmp(s, "focus_boost", 11)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            char *val = trim(eq+1);
+            if (!strcasecmp(val, "auto") || !strcasecmp(val, "true") ||
+                !strcasecmp(val, "yes") || !strcmp(val, "1"))
+                cfg->focus_boost = NOVAWM_BOOST_AUTO;
+            else if (!strcasecmp(val, "cgroup"))
+                cfg->focus_boost = NOVAWM_BOOST_CGROUP;
+            else if (!strcasecmp(val, "nice"))
+                cfg->focus_boost = NOVAWM_BOOST_NICE;
+            else
+                cfg->focus_boost = NOVAWM_BOOST_OFF;
+            continue;
+        }
+
         if (!strncmp(s, "focus_follows_mouse", 19)) {
             char *eq = strchr(s, '=');
             if (!eq) continue;
@@ -136,6 +196,120 @@ bool novawm_config_load(struct novawm_config *cfg, const char *path) {
             continue;
         }
 
+        if (!strncmp(s, "drag_move_mode", 14) ||
+            !strncmp(s, "drag_resize_mode", 16)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            enum novawm_drag_mode *mode = !strncmp(s, "drag_move_mode", 14)
+                ? &cfg->drag_move_mode : &cfg->drag_resize_mode;
+            char *val = trim(eq+1);
+            if (!strcasecmp(val, "outline"))
+                *mode = NOVAWM_DRAG_OUTLINE;
+            else if (!strcasecmp(val, "live"))
+                *mode = NOVAWM_DRAG_LIVE;
+            else
+                fprintf(stderr, "novawm: unknown drag mode '%s'\n", val);
+            continue;
+        }
+
+        if (!strncmp(s, "layout", 6)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            if (!novawm_layout_parse(trim(eq+1), &cfg->layout))
+                fprintf(stderr, "novawm: unknown layout '%s'\n", trim(eq+1));
+            continue;
+        }
+
+        if (!strncmp(s, "state_shm", 9)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            char *val = trim(eq+1);
+            cfg->state_shm =
+            (!strcasecmp(val, "true") || !strcasecmp(val, "yes") || !strcmp(val, "1"));
+            continue;
+        }
+
+        if (!strncmp(s, "audit_budget_us", 15)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->audit_budget_us = atoi(trim(eq+1));
+            if (cfg->audit_budget_us < 0) cfg->audit_budget_us = 0;
+            continue;
+        }
+
+        if (!strncmp(s, "audit_fail", 10)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            char *val = trim(eq+1);
+            cfg->audit_fail =
+            (!strcasecmp(val, "true") || !strcasecmp(val, "yes") || !strcmp(val, "1"));
+            continue;
+        }
+
+        if (!strncmp(s, "client_pool", 11)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->client_pool = atoi(trim(eq+1));
+            if (cfg->client_pool < 0) cfg->client_pool = 0;
+            if (cfg->client_pool > 65536) cfg->client_pool = 65536;
+            continue;
+        }
+
+        if (!strncmp(s, "lock_memory", 11)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            char *val = trim(eq+1);
+            cfg->lock_memory =
+            (!strcasecmp(val, "true") || !strcasecmp(val, "yes") || !strcmp(val, "1"));
+            continue;
+        }
+
+        if (!strncmp(s, "bar_height", 10)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->bar_height = atoi(trim(eq+1));
+            if (cfg->bar_height < 0) cfg->bar_height = 0;
+            if (cfg->bar_height > 200) cfg->bar_height = 200;
+            continue;
+        }
+
+        if (!strncmp(s, "bar_font", 8)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            snprintf(cfg->bar_font, sizeof cfg->bar_font, "%s", trim(eq+1));
+            continue;
+        }
+
+        if (!strncmp(s, "bar_bg", 6)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->bar_bg = strtoul(trim(eq+1), NULL, 0);
+            continue;
+        }
+
+        if (!strncmp(s, "bar_fg", 6)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            cfg->bar_fg = strtoul(trim(eq+1), NULL, 0);
+            continue;
+        }
+
+        if (!strncmp(s, "bar", 3)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            char *val = trim(eq+1);
+            if (!strcasecmp(val, "top"))
+                cfg->bar = NOVAWM_BAR_TOP;
+            else if (!strcasecmp(val, "bottom"))
+                cfg->bar = NOVAWM_BAR_BOTTOM;
+            else if (!strcasecmp(val, "off") || !strcasecmp(val, "false") ||
+                     !strcasecmp(val, "no") || !strcmp(val, "0"))
+                cfg->bar = NOVAWM_BAR_OFF;
+            else
+                fprintf(stderr, "novawm: unknown bar position '%s'\n", val);
+            continue;
+        }
+
         if (!strncmp(s, "exec-once", 9)) {
             char *eq = strchr(s, '=');
             if (!eq) continue;
@@ -146,6 +320,17 @@ bool novawm_config_load(struct novawm_config *cfg, const char *path) {
             continue;
         }
 
+        if (!strncmp(s, "rule", 4)) {
+            char *eq = strchr(s, '=');
+            if (!eq) continue;
+            char *spec = trim(eq + 1);
+            char orig[sizeof line];
+            snprintf(orig, sizeof orig, "%s", spec);
+            if (!novawm_rules_add(&cfg->rules, spec))
+                fprintf(stderr, "novawm: ignoring bad rule \"%s\"\n", orig);
+            continue;
+        }
+
         if (!strncmp(s, "bind", 4)) {
             char *eq = strchr(s, '=');
             if (!eq) continue;
@@ -165,13 +350,26 @@ bool novawm_config_load(struct novawm_config *cfg, const char *path) {
             b->mods = novawm_parse_mods(trim(mods));
             b->keysym = parse_keysym_name(trim(key));
 
-            snprintf(b->action, sizeof b->action, "%s", trim(action));
+            action = trim(action);
+            if (strchr(action, ';') || (arg && strchr(arg, ';'))) {
+                /* maybe an action list: the chain action splits it only
+                 * where an action name follows a ';', so "spawn, kitty;
+                 * workspace 3" is two steps and "spawn, sh -c 'a; b'"
+                 * stays one */
+                snprintf(b->action, sizeof b->action, "chain");
+                snprintf(b->arg, sizeof b->arg, "%s%s%s", action,
+                         arg ? ", " : "", arg ? trim(arg) : "");
+                continue;
+            }
+            snprintf(b->action, sizeof b->action, "%s", action);
             if (arg) snprintf(b->arg, sizeof b->arg, "%s", trim(arg));
             continue;
         }
     }
 
     fclose(f);
+
+    novawm_rules_compile(&cfg->rules);
     return true;
 }
 
@@ -0,0 +1,128 @@
+#include "novawm.h"
+
+/* Asynchronous X errors (response_type 0 in the event stream): counted per
+ * (request opcode, error code), each new pair logged once. A BadWindow for
+ * a managed window means the client is gone before its DestroyNotify got
+ * here; it is unmanaged on the spot so nothing more is sent to it. Most
+ * dying clients are caught earlier, by the UnmapNotify that precedes
+ * their DestroyNotify, and killactive drops its client right away. */
+
+static const char *const error_names[] = {
+    [XCB_REQUEST]        = "BadRequest",
+    [XCB_VALUE]          = "BadValue",
+    [XCB_WINDOW]         = "BadWindow",
+    [XCB_PIXMAP]         = "BadPixmap",
+    [XCB_ATOM]           = "BadAtom",
+    [XCB_CURSOR]         = "BadCursor",
+    [XCB_FONT]           = "BadFont",
+    [XCB_MATCH]          = "BadMatch",
+    [XCB_DRAWABLE]       = "BadDrawable",
+    [XCB_ACCESS]         = "BadAccess",
+    [XCB_ALLOC]          = "BadAlloc",
+    [XCB_COLORMAP]       = "BadColormap",
+    [XCB_G_CONTEXT]      = "BadGC",
+    [XCB_ID_CHOICE]      = "BadIDChoice",
+    [XCB_NAME]           = "BadName",
+    [XCB_LENGTH]         = "BadLength",
+    [XCB_IMPLEMENTATION] = "BadImplementation",
+};
+
+/* core requests this WM issues */
+static const char *const request_names[] = {
+    [XCB_CREATE_WINDOW]            = "CreateWindow",
+    [XCB_CHANGE_WINDOW_ATTRIBUTES] = "ChangeWindowAttributes",
+    [XCB_GET_WINDOW_ATTRIBUTES]    = "GetWindowAttributes",
+    [XCB_MAP_WINDOW]               = "MapWindow",
+    [XCB_UNMAP_WINDOW]             = "UnmapWindow",
+    [XCB_CONFIGURE_WINDOW]         = "ConfigureWindow",
+    [XCB_GET_GEOMETRY]             = "GetGeometry",
+    [XCB_QUERY_TREE]               = "QueryTree",
+    [XCB_CHANGE_PROPERTY]          = "ChangeProperty",
+    [XCB_GET_PROPERTY]             = "GetProperty",
+    [XCB_SEND_EVENT]               = "SendEvent",
+    [XCB_GRAB_KEY]                 = "GrabKey",
+    [XCB_SET_INPUT_FOCUS]          = "SetInputFocus",
+    [XCB_KILL_CLIENT]              = "KillClient",
+};
+
+static const char *const event_names[] = {
+    [XCB_KEY_PRESS]         = "KeyPress",
+    [XCB_KEY_RELEASE]       = "KeyRelease",
+    [XCB_BUTTON_PRESS]      = "ButtonPress",
+    [XCB_BUTTON_RELEASE]    = "ButtonRelease",
+    [XCB_MOTION_NOTIFY]     = "MotionNotify",
+    [XCB_ENTER_NOTIFY]      = "EnterNotify",
+    [XCB_LEAVE_NOTIFY]      = "LeaveNotify",
+    [XCB_FOCUS_IN]          = "FocusIn",
+    [XCB_FOCUS_OUT]         = "FocusOut",
+    [XCB_EXPOSE]            = "Expose",
+    [XCB_CREATE_NOTIFY]     = "CreateNotify",
+    [XCB_DESTROY_NOTIFY]    = "DestroyNotify",
+    [XCB_UNMAP_NOTIFY]      = "UnmapNotify",
+    [XCB_MAP_NOTIFY]        = "MapNotify",
+    [XCB_MAP_REQUEST]       = "MapRequest",
+    [XCB_CONFIGURE_NOTIFY]  = "ConfigureNotify",
+    [XCB_CONFIGURE_REQUEST] = "ConfigureRequest",
+    [XCB_PROPERTY_NOTIFY]   = "PropertyNotify",
+    [XCB_CLIENT_MESSAGE]    = "ClientMessage",
+    [XCB_MAPPING_NOTIFY]    = "MappingNotify",
+};
+
+const char *novawm_event_name(struct novawm_server *srv, int type) {
+    if (type == 0)
+        return "X error";
+    if (srv->have_sync && type == srv->sync_event_base + XCB_SYNC_ALARM_NOTIFY)
+        return "AlarmNotify";
+    if (type < (int)(sizeof event_names / sizeof *event_names) &&
+        event_names[type])
+        return event_names[type];
+    return "other event";
+}
+
+const char *novawm_error_name(uint8_t code) {
+    if (code < sizeof error_names / sizeof *error_names && error_names[code])
+        return error_names[code];
+    return "extension error";
+}
+
+const char *novawm_request_name(uint8_t major) {
+    if (major < sizeof request_names / sizeof *request_names &&
+        request_names[major])
+        return request_names[major];
+    return major >= 128 ? "extension request" : "core request";
+}
+
+void novawm_x11_error(struct novawm_server *srv, xcb_generic_error_t *err) {
+    struct novawm_stats *st = &srv->stats;
+    st->errors++;
+
+    struct novawm_error_count *e = NULL;
+    for (int i = 0; i < st->error_kinds; i++) {
+        if (st->error_counts[i].major == err->major_code &&
+            st->error_counts[i].code == err->error_code) {
+            e = &st->error_counts[i];
+            break;
+        }
+    }
+    if (!e && st->error_kinds < NOVAWM_ERROR_KINDS) {
+        e = &st->error_counts[st->error_kinds++];
+        e->major = err->major_code;
+        e->code = err->error_code;
+        e->count = 0;
+        fprintf(stderr, "novawm: X error %s (%u) from %s (%u.%u), "
+                "resource 0x%x\n",
+                novawm_error_name(err->error_code), err->error_code,
+                novawm_request_name(err->major_code), err->major_code,
+                err->minor_code, err->resource_id);
+    }
+    if (e)
+        e->count++;
+
+    if (err->error_code == XCB_WINDOW) {
+        struct novawm_client *c = novawm_find_client(srv, err->resource_id);
+        if (c) {
+            st->dead_unmanaged++;
+            novawm_unmanage_window(srv, c);
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#include "novawm.h"
+#include <string.h>
+
+/* ICCCM WM_STATE values */
+#define WM_STATE_NORMAL 1
+#define WM_STATE_ICONIC 3
+
+/* Atoms advertised in _NET_SUPPORTED */
+static const enum novawm_atom supported[] = {
+    NOVAWM_ATOM_NET_SUPPORTED,
+    NOVAWM_ATOM_NET_SUPPORTING_WM_CHECK,
+    NOVAWM_ATOM_NET_WM_NAME,
+    NOVAWM_ATOM_NET_WM_WINDOW_TYPE,
+    NOVAWM_ATOM_NET_WM_STATE,
+    NOVAWM_ATOM_NET_WM_STATE_HIDDEN,
+    NOVAWM_ATOM_NET_WM_STATE_FULLSCREEN,
+    NOVAWM_ATOM_NET_WM_BYPASS_COMPOSITOR,
+    NOVAWM_ATOM_NET_WM_SYNC_REQUEST,
+    NOVAWM_ATOM_NET_WM_SYNC_REQUEST_COUNTER,
+};
+
+/* WM_SIZE_HINTS flags and layout (ICCCM 4.1.2.3) */
+#define SIZE_HINT_P_MIN_SIZE    (1u << 4)
+#define SIZE_HINT_P_MAX_SIZE    (1u << 5)
+#define SIZE_HINT_P_RESIZE_INC  (1u << 6)
+#define SIZE_HINT_P_BASE_SIZE   (1u << 8)
+#define SIZE_HINTS_LEN          18
+
+/* _NET_WM_STATE client message actions */
+#define NET_WM_STATE_REMOVE 0
+#define NET_WM_STATE_ADD    1
+#define NET_WM_STATE_TOGGLE 2
+
+void novawm_ewmh_init(struct novawm_server *srv) {
+    xcb_atom_t atoms[sizeof supported / sizeof *supported];
+    for (size_t i = 0; i < sizeof supported / sizeof *supported; i++)
+        atoms[i] = srv->atoms[supported[i]];
+
+    xcb_change_property(srv->conn, XCB_PROP_MODE_REPLACE, srv->root,
+                        srv->atoms[NOVAWM_ATOM_NET_SUPPORTED], XCB_ATOM_ATOM,
+                        32, sizeof atoms / sizeof *atoms, atoms);
+
+    /* _NET_SUPPORTING_WM_CHECK: apps look for it before trusting EWMH */
+    xcb_window_t check = xcb_generate_id(srv->conn);
+    xcb_create_window(srv->conn, XCB_COPY_FROM_PARENT, check, srv->root,
+                      -1, -1, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_ONLY,
+                      XCB_COPY_FROM_PARENT, 0, NULL);
+
+    xcb_atom_t wm_check = srv->atoms[NOVAWM_ATOM_NET_SUPPORTING_WM_CHECK];
+    xcb_change_property(srv->conn, XCB_PROP_MODE_REPLACE, srv->root,
+                        wm_check, XCB_ATOM_WINDOW, 32, 1, &check);
+    xcb_change_property(srv->conn, XCB_PROP_MODE_REPLACE, check,
+                        wm_check, XCB_ATOM_WINDOW, 32, 1, &check);
+    xcb_change_property(srv->conn, XCB_PROP_MODE_REPLACE, check,
+                        srv->atoms[NOVAWM_ATOM_NET_WM_NAME],
+                        srv->atoms[NOVAWM_ATOM_UTF8_STRING],
+                        8, strlen("NovaWM"), "NovaWM");
+}
+
+/* Rewrite _NET_WM_STATE from the client's flags. */
+void novawm_ewmh_update_state(struct novawm_server *srv,
+                              struct novawm_client *c) {
+    xcb_atom_t state[2];
+    uint32_t n = 0;
+
+    if (c->hidden)
+        state[n++] = srv->atoms[NOVAWM_ATOM_NET_WM_STATE_HIDDEN];
+    if (c->fullscreen)
+        state[n++] = srv->atoms[NOVAWM_ATOM_NET_WM_STATE_FULLSCREEN];
+
+    srv->backend->set_property(srv, c->win,
+                               srv->atoms[NOVAWM_ATOM_NET_WM_STATE],
+                               XCB_ATOM_ATOM, 32, n, state);
+}
+
+/* Keep WM_STATE (Normal/Iconic) and _NET_WM_STATE_HIDDEN in line with
+ * what the user can see, so apps can stop rendering while hidden. Only
+ * changes are written; the requests go out with the caller's flush. */
+void novawm_client_set_hidden(struct novawm_server *srv,
+                              struct novawm_client *c, bool hidden) {
+    uint8_t wm_state = hidden ? WM_STATE_ICONIC : WM_STATE_NORMAL;
+    if (c->wm_state == wm_state)
+        return;
+
+    c->hidden = hidden;
+    c->wm_state = wm_state;
+
+    uint32_t data[2] = { wm_state, XCB_NONE };
+    srv->backend->set_property(srv, c->win,
+                               srv->atoms[NOVAWM_ATOM_WM_STATE],
+                               srv->atoms[NOVAWM_ATOM_WM_STATE], 32, 2, data);
+
+    novawm_ewmh_update_state(srv, c);
+}
+
+void novawm_ewmh_client_message(struct novawm_server *srv,
+                                xcb_client_message_event_t *ev) {
+    if (ev->format != 32 ||
+        ev->type != srv->atoms[NOVAWM_ATOM_NET_WM_STATE])
+        return;
+
+    struct novawm_client *c = novawm_find_client(srv, ev->window);
+    if (!c)
+        return;
+
+    xcb_atom_t fs = srv->atoms[NOVAWM_ATOM_NET_WM_STATE_FULLSCREEN];
+    if (ev->data.data32[1] != fs && ev->data.data32[2] != fs)
+        return;
+
+    switch (ev->data.data32[0]) {
+    case NET_WM_STATE_REMOVE: novawm_set_fullscreen(srv, c, false); break;
+    case NET_WM_STATE_ADD:    novawm_set_fullscreen(srv, c, true); break;
+    case NET_WM_STATE_TOGGLE:
+        novawm_set_fullscreen(srv, c, !c->fullscreen);
+        break;
+    }
+}
+
+/* Cache the size-related parts of WM_NORMAL_HINTS. A missing base size
+ * falls back to the minimum size and vice versa, as ICCCM says. */
+void novawm_size_hints_update(struct novawm_size_hints *sh,
+                              const xcb_get_property_reply_t *r) {
+    memset(sh, 0, sizeof *sh);
+
+    if (!r || r->format != 32 ||
+        xcb_get_property_value_length(r) < SIZE_HINTS_LEN * 4)
+        return;
+
+    const uint32_t *v = xcb_get_property_value(r);
+    uint32_t flags = v[0];
+
+    if (flags & SIZE_HINT_P_MIN_SIZE) {
+        sh->min_w = (int32_t)v[5];
+        sh->min_h = (int32_t)v[6];
+    }
+    if (flags & SIZE_HINT_P_MAX_SIZE) {
+        sh->max_w = (int32_t)v[7];
+        sh->max_h = (int32_t)v[8];
+    }
+    if (flags & SIZE_HINT_P_RESIZE_INC) {
+        sh->inc_w = (int32_t)v[9];
+        sh->inc_h = (int32_t)v[10];
+    }
+    if (flags & SIZE_HINT_P_BASE_SIZE) {
+        sh->base_w = (int32_t)v[15];
+        sh->base_h = (int32_t)v[16];
+    } else {
+        sh->base_w = sh->min_w;
+        sh->base_h = sh->min_h;
+    }
+    if (!(flags & SIZE_HINT_P_MIN_SIZE)) {
+        sh->min_w = sh->base_w;
+        sh->min_h = sh->base_h;
+    }
+}
+
+/* Round a size down to the client's increments, then clamp it to its
+ * minimum and maximum. */
+void novawm_size_hints_apply(const struct novawm_size_hints *sh,
+                             int *w, int *h) {
+    if (sh->inc_w > 1 && *w > sh->base_w)
+        *w = sh->base_w + (*w - sh->base_w) / sh->inc_w * sh->inc_w;
+    if (sh->inc_h > 1 && *h > sh->base_h)
+        *h = sh->base_h + (*h - sh->base_h) / sh->inc_h * sh->inc_h;
+
+    if (*w < sh->min_w) *w = sh->min_w;
+    if (*h < sh->min_h) *h = sh->min_h;
+    if (sh->max_w > 0 && *w > sh->max_w) *w = sh->max_w;
+    if (sh->max_h > 0 && *h > sh->max_h) *h = sh->max_h;
+    if (*w < 1) *w = 1;
+    if (*h < 1) *h = 1;
+}
@@ -0,0 +1,694 @@
+#include "novawm.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* In-memory stand-in for the X server, behind the same backend interface
+ * as x11.c. It keeps what the WM can change about each window (geometry,
+ * border, mapping, selected events), counts every request, and queues the
+ * events a real server would send back; novawm_fake_dispatch() feeds them
+ * through the normal event handler. Used by `novawm --bench`.
+ *
+ * A destroyed window stays in the table until its DestroyNotify has been
+ * handled. Every request for it in the meantime gets a BadWindow error
+ * queued, as a server would send, and is counted as a dead request; one
+ * made after the WM was told (the error or the DestroyNotify handled, or
+ * the WM killed it itself) is also counted as late.
+ *
+ * A window created with a sync_counter speaks _NET_WM_SYNC_REQUEST: its
+ * counter and alarm share its XID, and after a resize that followed a
+ * sync request the client paints for paint_ticks ticks of
+ * novawm_fake_tick() before it acks. A resize that reaches it while it is
+ * still painting is counted as an overrun. The counter starts at
+ * FAKE_SYNC_START, as if an earlier window manager had synced the client,
+ * and an alarm fires at once when created or set at or below it, as a
+ * server's does. */
+
+#define FAKE_ROOT       1
+#define FAKE_FIRST_XID  0x00200001u
+#define FAKE_FIRST_ATOM 0x1000u
+#define FAKE_DEAD       0xffffffffu     /* deleted hash slot */
+#define FAKE_ICONIC     3u              /* WM_STATE IconicState */
+#define FAKE_SYNC_BASE  90              /* first XSync event code */
+#define FAKE_SYNC_START 1000u           /* counter value at creation */
+
+struct fake_window {
+    xcb_window_t win;                   /* 0 = empty slot */
+    int16_t      x, y;
+    uint16_t     w, h, bw;
+    bool         mapped;
+    bool         gone;                  /* destroyed, DestroyNotify due */
+    bool         told;                  /* ... and the WM knows */
+    bool         iconic;                /* WM_STATE says IconicState */
+    int          paint_ticks;           /* to paint a new size */
+    bool         painting;
+    uint64_t     sync_next;             /* asked for by a sync request */
+    uint64_t     sync_painting;         /* value of the size being painted */
+    uint64_t     sync_value;            /* the counter; set once painted */
+    uint64_t     paint_done;            /* tick painting is done at */
+    uint32_t     border_pixel;
+    uint32_t     event_mask;
+    struct novawm_window_info info;
+};
+
+static struct {
+    struct fake_window  *slots;         /* open addressing, power of two */
+    size_t               cap, used;     /* used counts deleted slots too */
+    xcb_generic_event_t *events;        /* FIFO, events[head..len) */
+    size_t               head, len, events_cap;
+    xcb_window_t         next_xid;
+    xcb_window_t         focus;
+    uint64_t             requests[NOVAWM_REQ_COUNT];
+    uint64_t             dead, late;    /* requests for destroyed windows */
+    uint64_t             tick;
+    uint64_t             overruns;  /* resizes while the client painted */
+    uint64_t             allocs;    /* the fake's own, not the WM's */
+} fake;
+
+/* --- window table --- */
+
+static size_t slot_of(xcb_window_t win, size_t cap) {
+    return (size_t)(win * 2654435761u) & (cap - 1);
+}
+
+static struct fake_window *lookup(xcb_window_t win) {
+    if (!fake.cap)
+        return NULL;
+    for (size_t i = slot_of(win, fake.cap);; i = (i + 1) & (fake.cap - 1)) {
+        if (fake.slots[i].win == win)
+            return &fake.slots[i];
+        if (!fake.slots[i].win)
+            return NULL;
+    }
+}
+
+static bool grow(void) {
+    size_t cap = fake.cap ? fake.cap * 2 : 1024;
+    struct fake_window *slots = calloc(cap, sizeof *slots);
+    if (!slots)
+        return false;
+    fake.allocs++;
+
+    size_t used = 0;
+    for (size_t i = 0; i < fake.cap; i++) {
+        struct fake_window *w = &fake.slots[i];
+        if (!w->win || w->win == FAKE_DEAD)
+            continue;
+        size_t j = slot_of(w->win, cap);
+        while (slots[j].win)
+            j = (j + 1) & (cap - 1);
+        slots[j] = *w;
+        used++;
+    }
+    free(fake.slots);
+    fake.slots = slots;
+    fake.cap = cap;
+    fake.used = used;
+    return true;
+}
+
+static struct fake_window *insert(xcb_window_t win) {
+    if ((fake.used + 1) * 2 > fake.cap && !grow())
+        return NULL;
+
+    size_t i = slot_of(win, fake.cap);
+    while (fake.slots[i].win && fake.slots[i].win != FAKE_DEAD)
+        i = (i + 1) & (fake.cap - 1);
+    if (!fake.slots[i].win)
+        fake.used++;
+
+    struct fake_window *w = &fake.slots[i];
+    memset(w, 0, sizeof *w);
+    w->win = win;
+    return w;
+}
+
+/* --- event queue --- */
+
+static void push(const void *ev) {
+    if (fake.head == fake.len)
+        fake.head = fake.len = 0;
+    if (fake.len == fake.events_cap) {
+        size_t cap = fake.events_cap ? fake.events_cap * 2 : 256;
+        xcb_generic_event_t *e = realloc(fake.events, cap * sizeof *e);
+        if (!e)
+            return;
+        fake.allocs++;
+        fake.events = e;
+        fake.events_cap = cap;
+    }
+    memcpy(&fake.events[fake.len++], ev, sizeof *fake.events);
+}
+
+static void push_unmap(xcb_window_t win) {
+    xcb_unmap_notify_event_t ev = {
+        .response_type = XCB_UNMAP_NOTIFY,
+        .event         = FAKE_ROOT,
+        .window        = win,
+    };
+    push(&ev);
+}
+
+static void push_property(struct fake_window *w, xcb_atom_t atom,
+                          uint8_t state) {
+    if (!(w->event_mask & XCB_EVENT_MASK_PROPERTY_CHANGE))
+        return;
+    xcb_property_notify_event_t ev = {
+        .response_type = XCB_PROPERTY_NOTIFY,
+        .window        = w->win,
+        .atom          = atom,
+        .state         = state,
+    };
+    push(&ev);
+}
+
+static void push_focus(xcb_window_t win, uint8_t type) {
+    struct fake_window *w = lookup(win);
+    if (!w || !(w->event_mask & XCB_EVENT_MASK_FOCUS_CHANGE))
+        return;
+    xcb_focus_in_event_t ev = {
+        .response_type = type,
+        .event         = win,
+        .mode          = XCB_NOTIFY_MODE_NORMAL,
+    };
+    push(&ev);
+}
+
+static void push_bad_window(xcb_window_t win, uint8_t major) {
+    xcb_generic_error_t err = {
+        .response_type = 0,
+        .error_code    = XCB_WINDOW,
+        .resource_id   = win,
+        .major_code    = major,
+    };
+    push(&err);
+}
+
+static void destroy(struct fake_window *w) {
+    if (w->gone)
+        return;
+    if (w->mapped)
+        push_unmap(w->win);
+    w->mapped = false;
+    xcb_destroy_notify_event_t ev = {
+        .response_type = XCB_DESTROY_NOTIFY,
+        .event         = FAKE_ROOT,
+        .window        = w->win,
+    };
+    push(&ev);
+    if (fake.focus == w->win)
+        fake.focus = FAKE_ROOT;
+    w->gone = true;
+}
+
+/* The live window a request made with opcode `major` is for; NULL for
+ * the root, and for a destroyed window after queueing its BadWindow (no
+ * error for queries: their replies just fail). */
+static struct fake_window *target(xcb_window_t win, uint8_t major) {
+    if (win == FAKE_ROOT || win == XCB_NONE)
+        return NULL;
+    struct fake_window *w = lookup(win);
+    if (w && !w->gone)
+        return w;
+    fake.dead++;
+    if (!w || w->told)
+        fake.late++;
+    if (major)
+        push_bad_window(win, major);
+    return NULL;
+}
+
+/* --- backend requests --- */
+
+static bool
+fake_query_window(struct novawm_server *srv, xcb_window_t win,
+                  struct novawm_window_info *out) {
+    NOVAWM_AUDIT_QUERY(srv);
+    fake.requests[NOVAWM_REQ_QUERY]++;
+    struct fake_window *w = target(win, 0);
+    if (!w)
+        return false;
+    *out = w->info;
+    out->sync_counter = w->info.sync_counter ? win : XCB_NONE;
+    out->x = w->x;
+    out->y = w->y;
+    out->w = w->w;
+    out->h = w->h;
+    return true;
+}
+
+static bool
+fake_size_hints(struct novawm_server *srv, xcb_window_t win,
+                struct novawm_size_hints *out) {
+    NOVAWM_AUDIT_QUERY(srv);
+    fake.requests[NOVAWM_REQ_QUERY]++;
+    struct fake_window *w = target(win, 0);
+    if (!w)
+        return false;
+    *out = w->info.hints;
+    return true;
+}
+
+static bool
+fake_title(struct novawm_server *srv, xcb_window_t win, char *out,
+           size_t outsz) {
+    NOVAWM_AUDIT_QUERY(srv);
+    fake.requests[NOVAWM_REQ_QUERY]++;
+    struct fake_window *w = target(win, 0);
+    if (!w)
+        return false;
+    snprintf(out, outsz, "%s", w->info.props.title);
+    return true;
+}
+
+static void
+fake_configure(struct novawm_server *srv, xcb_window_t win,
+               uint16_t mask, const uint32_t *values) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_CONFIGURE]++;
+    struct fake_window *w = target(win, XCB_CONFIGURE_WINDOW);
+    if (!w)
+        return;
+
+    uint16_t w0 = w->w, h0 = w->h;
+    /* value list order is bit order */
+    const uint32_t *v = values;
+    if (mask & XCB_CONFIG_WINDOW_X)            w->x = (int16_t)*v++;
+    if (mask & XCB_CONFIG_WINDOW_Y)            w->y = (int16_t)*v++;
+    if (mask & XCB_CONFIG_WINDOW_WIDTH)        w->w = (uint16_t)*v++;
+    if (mask & XCB_CONFIG_WINDOW_HEIGHT)       w->h = (uint16_t)*v++;
+    if (mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) w->bw = (uint16_t)*v++;
+
+    if (w->w != w0 || w->h != h0) {
+        if (w->painting)
+            fake.overruns++;
+        if (w->sync_next) {
+            /* the client paints the new size, then acks */
+            w->painting = true;
+            w->sync_painting = w->sync_next;
+            w->sync_next = 0;
+            w->paint_done = fake.tick + (uint64_t)w->paint_ticks;
+        }
+    }
+
+    xcb_configure_notify_event_t ev = {
+        .response_type = XCB_CONFIGURE_NOTIFY,
+        .event         = FAKE_ROOT,
+        .window        = win,
+        .x             = w->x,
+        .y             = w->y,
+        .width         = w->w,
+        .height        = w->h,
+        .border_width  = w->bw,
+    };
+    push(&ev);
+}
+
+static void
+fake_map(struct novawm_server *srv, xcb_window_t win) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_MAP]++;
+    struct fake_window *w = target(win, XCB_MAP_WINDOW);
+    if (!w || w->mapped)
+        return;
+    w->mapped = true;
+    xcb_map_notify_event_t ev = {
+        .response_type = XCB_MAP_NOTIFY,
+        .event         = FAKE_ROOT,
+        .window        = win,
+    };
+    push(&ev);
+}
+
+static void
+fake_unmap(struct novawm_server *srv, xcb_window_t win) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_UNMAP]++;
+    struct fake_window *w = target(win, XCB_UNMAP_WINDOW);
+    if (!w || !w->mapped)
+        return;
+    w->mapped = false;
+    push_unmap(win);
+}
+
+static void
+fake_set_attributes(struct novawm_server *srv, xcb_window_t win,
+                    uint32_t mask, const uint32_t *values) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_ATTRIBUTES]++;
+    struct fake_window *w = target(win, XCB_CHANGE_WINDOW_ATTRIBUTES);
+    if (!w)
+        return;
+
+    const uint32_t *v = values;
+    for (uint32_t bit = 1; bit && bit <= mask; bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        if (bit == XCB_CW_BORDER_PIXEL)
+            w->border_pixel = *v;
+        else if (bit == XCB_CW_EVENT_MASK)
+            w->event_mask = *v;
+        v++;
+    }
+}
+
+static void
+fake_focus(struct novawm_server *srv, xcb_window_t win) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_FOCUS]++;
+    if (win != FAKE_ROOT && !target(win, XCB_SET_INPUT_FOCUS))
+        return;
+    if (win == fake.focus)
+        return;
+    push_focus(fake.focus, XCB_FOCUS_OUT);
+    fake.focus = win;
+    push_focus(win, XCB_FOCUS_IN);
+}
+
+static void
+fake_grab_key(struct novawm_server *srv, uint16_t mods, xcb_keycode_t key) {
+    (void)srv;
+    (void)mods;
+    (void)key;
+    fake.requests[NOVAWM_REQ_GRAB]++;
+}
+
+static void
+fake_ungrab_keys(struct novawm_server *srv) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_GRAB]++;
+}
+
+static void
+fake_set_property(struct novawm_server *srv, xcb_window_t win,
+                  xcb_atom_t prop, xcb_atom_t type, uint8_t format,
+                  uint32_t len, const void *data) {
+    (void)type;
+    fake.requests[NOVAWM_REQ_PROPERTY]++;
+    struct fake_window *w = target(win, XCB_CHANGE_PROPERTY);
+    if (!w)
+        return;
+    if (prop == srv->atoms[NOVAWM_ATOM_WM_STATE] && format == 32 && len)
+        w->iconic = *(const uint32_t *)data == FAKE_ICONIC;
+    push_property(w, prop, XCB_PROPERTY_NEW_VALUE);
+}
+
+static void
+fake_delete_property(struct novawm_server *srv, xcb_window_t win,
+                     xcb_atom_t prop) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_PROPERTY]++;
+    struct fake_window *w = target(win, XCB_DELETE_PROPERTY);
+    if (w)
+        push_property(w, prop, XCB_PROPERTY_DELETE);
+}
+
+/* Of what is sent to clients only sync requests are modelled. */
+static void
+fake_send_event(struct novawm_server *srv, xcb_window_t win, uint32_t mask,
+                const void *ev) {
+    (void)mask;
+    fake.requests[NOVAWM_REQ_SEND_EVENT]++;
+    struct fake_window *w = target(win, XCB_SEND_EVENT);
+    const xcb_client_message_event_t *cm = ev;
+    if (!w || !w->info.sync_counter ||
+        (cm->response_type & 0x7f) != XCB_CLIENT_MESSAGE ||
+        cm->type != srv->atoms[NOVAWM_ATOM_WM_PROTOCOLS] ||
+        cm->data.data32[0] != srv->atoms[NOVAWM_ATOM_NET_WM_SYNC_REQUEST])
+        return;
+    w->sync_next = (uint64_t)cm->data.data32[3] << 32 | cm->data.data32[2];
+}
+
+static void
+fake_kill(struct novawm_server *srv, xcb_window_t win) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_KILL]++;
+    struct fake_window *w = target(win, XCB_KILL_CLIENT);
+    if (w) {
+        destroy(w);
+        w->told = true;         /* the WM did it */
+    }
+}
+
+static void push_alarm(struct novawm_server *srv, struct fake_window *w) {
+    xcb_sync_alarm_notify_event_t ev = {
+        .response_type = (uint8_t)(srv->sync_event_base +
+                                   XCB_SYNC_ALARM_NOTIFY),
+        .alarm         = w->win,
+        .counter_value = {
+            .hi = (int32_t)(w->sync_value >> 32),
+            .lo = (uint32_t)w->sync_value,
+        },
+    };
+    push(&ev);
+}
+
+/* counter and alarm are the window's own XID; created at 0, the alarm is
+ * already reached */
+static xcb_sync_alarm_t
+fake_alarm_create(struct novawm_server *srv, xcb_sync_counter_t counter) {
+    fake.requests[NOVAWM_REQ_ALARM]++;
+    struct fake_window *w = target(counter, 0);
+    if (!w)
+        return XCB_NONE;
+    push_alarm(srv, w);
+    return counter;
+}
+
+static void
+fake_alarm_set(struct novawm_server *srv, xcb_sync_alarm_t alarm,
+               uint64_t value) {
+    fake.requests[NOVAWM_REQ_ALARM]++;
+    struct fake_window *w = target(alarm, 0);
+    if (w && w->sync_value >= value)
+        push_alarm(srv, w);
+}
+
+static void
+fake_alarm_destroy(struct novawm_server *srv, xcb_sync_alarm_t alarm) {
+    (void)srv;
+    (void)alarm;
+    fake.requests[NOVAWM_REQ_ALARM]++;
+}
+
+static void
+fake_flush(struct novawm_server *srv) {
+    (void)srv;
+    fake.requests[NOVAWM_REQ_FLUSH]++;
+}
+
+const struct novawm_backend novawm_backend_fake = {
+    .name            = "fake",
+    .query_window    = fake_query_window,
+    .size_hints      = fake_size_hints,
+    .title           = fake_title,
+    .configure       = fake_configure,
+    .map             = fake_map,
+    .unmap           = fake_unmap,
+    .set_attributes  = fake_set_attributes,
+    .focus           = fake_focus,
+    .grab_key        = fake_grab_key,
+    .ungrab_keys     = fake_ungrab_keys,
+    .set_property    = fake_set_property,
+    .delete_property = fake_delete_property,
+    .send_event      = fake_send_event,
+    .kill            = fake_kill,
+    .alarm_create    = fake_alarm_create,
+    .alarm_set       = fake_alarm_set,
+    .alarm_destroy   = fake_alarm_destroy,
+    .flush           = fake_flush,
+};
+
+/* --- driving it --- */
+
+/* Point `srv` at an empty fake screen of w x h. */
+void novawm_fake_init(struct novawm_server *srv, int w, int h) {
+    novawm_fake_fini();
+    fake.next_xid = FAKE_FIRST_XID;
+    fake.focus = FAKE_ROOT;
+
+    srv->backend = &novawm_backend_fake;
+    srv->conn = NULL;
+    srv->screen = NULL;
+    srv->root = FAKE_ROOT;
+    for (int i = 0; i < NOVAWM_ATOM_COUNT; i++)
+        srv->atoms[i] = FAKE_FIRST_ATOM + (xcb_atom_t)i;
+
+    srv->have_sync = true;
+    srv->sync_event_base = FAKE_SYNC_BASE;
+
+    srv->mon.x = 0;
+    srv->mon.y = 0;
+    srv->mon.w = w;
+    srv->mon.h = h;
+}
+
+/* A client creates a window and asks for it to be mapped. */
+xcb_window_t novawm_fake_create_window(struct novawm_server *srv,
+                                       const struct novawm_window_info *info) {
+    (void)srv;
+    xcb_window_t win = fake.next_xid++;
+    struct fake_window *w = insert(win);
+    if (!w)
+        return XCB_NONE;
+
+    w->info = *info;
+    w->x = (int16_t)info->x;
+    w->y = (int16_t)info->y;
+    w->w = (uint16_t)info->w;
+    w->h = (uint16_t)info->h;
+    w->sync_value = FAKE_SYNC_START;
+
+    xcb_map_request_event_t ev = {
+        .response_type = XCB_MAP_REQUEST,
+        .parent        = FAKE_ROOT,
+        .window        = win,
+    };
+    push(&ev);
+    return win;
+}
+
+/* The client goes away on its own. Its UnmapNotify and DestroyNotify
+ * queue up behind whatever is queued already. */
+void novawm_fake_destroy_window(struct novawm_server *srv, xcb_window_t win) {
+    (void)srv;
+    struct fake_window *w = lookup(win);
+    if (w)
+        destroy(w);
+}
+
+/* The client of `win` takes `ticks` to paint each new size. */
+void novawm_fake_set_paint_ticks(xcb_window_t win, int ticks) {
+    struct fake_window *w = lookup(win);
+    if (w)
+        w->paint_ticks = ticks;
+}
+
+/* The user does something with the pointer: a button press or release
+ * on `win`, or a motion, with modifiers `state` held. */
+void novawm_fake_pointer(struct novawm_server *srv, uint8_t type,
+                         xcb_window_t win, uint8_t button, uint16_t state,
+                         int x, int y) {
+    (void)srv;
+    xcb_button_press_event_t ev = {
+        .response_type = type,
+        .detail        = type == XCB_MOTION_NOTIFY ? 0 : button,
+        .root          = FAKE_ROOT,
+        .event         = win,
+        .root_x        = (int16_t)x,
+        .root_y        = (int16_t)y,
+        .state         = state,
+        .same_screen   = 1,
+    };
+    push(&ev);
+}
+
+/* Time passes: clients that are done painting ack their sync request.
+ * Returns the number of acks queued. */
+int novawm_fake_tick(struct novawm_server *srv) {
+    int acks = 0;
+    fake.tick++;
+    for (size_t i = 0; i < fake.cap; i++) {
+        struct fake_window *w = &fake.slots[i];
+        if (!w->win || w->win == FAKE_DEAD || w->gone || !w->painting ||
+            w->paint_done > fake.tick)
+            continue;
+        w->painting = false;
+        w->sync_value = w->sync_painting;
+        push_alarm(srv, w);
+        acks++;
+    }
+    return acks;
+}
+
+/* Resizes that reached a client still painting an earlier one. */
+uint64_t novawm_fake_sync_overruns(void) {
+    return fake.overruns;
+}
+
+/* The destroyed window `ev` tells the WM about, if any. */
+static xcb_window_t tells(const xcb_generic_event_t *ev) {
+    uint8_t type = ev->response_type & 0x7f;
+    const xcb_generic_error_t *err = (const xcb_generic_error_t *)ev;
+    if (type == 0 && err->error_code == XCB_WINDOW)
+        return err->resource_id;
+    if (type == XCB_DESTROY_NOTIFY)
+        return ((const xcb_destroy_notify_event_t *)ev)->window;
+    return XCB_NONE;
+}
+
+/* Deliver queued events as the run loop would: a batch, then a frame
+ * commit, until the commits stop producing events. Returns the number of
+ * events handled. */
+int novawm_fake_dispatch(struct novawm_server *srv) {
+    int n = 0;
+    while (fake.head < fake.len) {
+        while (fake.head < fake.len) {
+            /* handlers may queue more events and move the array */
+            xcb_generic_event_t ev = fake.events[fake.head++];
+            xcb_window_t told = tells(&ev);
+            struct fake_window *w = told ? lookup(told) : NULL;
+            if (w && w->gone)
+                w->told = true;
+            novawm_x11_handle_event(srv, &ev);
+            /* the XID is free for reuse once its DestroyNotify is out */
+            if (w && w->gone &&
+                (ev.response_type & 0x7f) == XCB_DESTROY_NOTIFY)
+                w->win = FAKE_DEAD;
+            n++;
+        }
+        novawm_x11_commit_frame(srv);
+    }
+    return n;
+}
+
+/* Every client paints a frame if it thinks it is seen. Returns how many
+ * paint when clients honour WM_STATE; `mapped` gets how many would if they
+ * only watched their mapping, `all` how many windows there are. */
+int novawm_fake_paint(int *mapped, int *all) {
+    int n = 0, m = 0, a = 0;
+    for (size_t i = 0; i < fake.cap; i++) {
+        struct fake_window *w = &fake.slots[i];
+        if (!w->win || w->win == FAKE_DEAD || w->gone)
+            continue;
+        a++;
+        if (!w->mapped)
+            continue;
+        m++;
+        if (!w->iconic)
+            n++;
+    }
+    if (mapped)
+        *mapped = m;
+    if (all)
+        *all = a;
+    return n;
+}
+
+/* Heap allocations the fake server made for itself; 0 when
+ * novawm_alloc_count() does not count them either. */
+uint64_t novawm_fake_allocs(void) {
+#if defined(__GLIBC__) && defined(NOVAWM_COUNT_ALLOCS)
+    return fake.allocs;
+#else
+    return 0;
+#endif
+}
+
+/* Requests for destroyed windows since novawm_fake_init; `late` gets
+ * those made after the WM had been told. */
+uint64_t novawm_fake_dead_requests(uint64_t *late) {
+    if (late)
+        *late = fake.late;
+    return fake.dead;
+}
+
+/* Requests by enum novawm_request since novawm_fake_init. */
+const uint64_t *novawm_fake_requests(void) {
+    return fake.requests;
+}
+
+void novawm_fake_fini(void) {
+    free(fake.slots);
+    free(fake.events);
+    memset(&fake, 0, sizeof fake);
+}
@@ -11,9 +11,9 @@ static struct novawm_workspace *current_ws(struct novawm_server *srv) {
 /* ------ Actions ------ */
 
 static void action_spawn(struct novawm_server *srv, const char *arg) {
-    (void)srv;
-    if (arg && *arg)
-        novawm_spawn(arg);
+    pid_t pid = novawm_spawn(arg);
+    if (pid > 0)
+        novawm_trace(srv, NOVAWM_TRACE_SPAWN, 0, (uint32_t)pid, NULL);
 }
 
 static void action_kill(struct novawm_server *srv, const char *arg) {
@@ -21,42 +21,128 @@ static void action_kill(struct novawm_server *srv, const char *arg) {
     novawm_kill_focused(srv);
 }
 
-static void focus_move(struct novawm_server *srv, int dir) {
-    struct novawm_workspace *ws = current_ws(srv);
+/* Client `steps` positions away from the focused one, wrapping around. */
+static struct novawm_client *focus_step(struct novawm_workspace *ws,
+                                        int steps) {
     struct novawm_client *c = ws->focused;
-    if (!c) return;
+    if (!c) return NULL;
 
-    if (dir > 0) {
-        if (c->next)
-            novawm_focus_client(srv, c->next);
-        else
-            novawm_focus_client(srv, ws->clients); /* wrap */
-    } else {
-        struct novawm_client *p = NULL, *it = ws->clients;
-        while (it && it != c) {
-            p = it;
-            it = it->next;
-        }
-        if (p)
-            novawm_focus_client(srv, p);
-        else {
-            /* go to last */
-            it = ws->clients;
-            if (!it) return;
-            while (it->next) it = it->next;
-            novawm_focus_client(srv, it);
-        }
+    while (steps > 0) {
+        c = c->next ? c->next : ws->clients; /* wrap */
+        steps--;
     }
+    while (steps < 0) {
+        c = c->prev ? c->prev : ws->last; /* wrap */
+        steps++;
+    }
+    return c;
 }
 
+/* focusnext/focusprev/grow/shrink only accumulate into srv->pending;
+ * novawm_input_commit() applies the sum once per event batch. */
 static void action_focusnext(struct novawm_server *srv, const char *arg) {
     (void)arg;
-    focus_move(srv, +1);
+    srv->pending.focus_steps++;
 }
 
 static void action_focusprev(struct novawm_server *srv, const char *arg) {
     (void)arg;
-    focus_move(srv, -1);
+    srv->pending.focus_steps--;
+}
+
+/* alt-tab: back to the window focused before this one. Steps folded
+ * earlier in the batch are applied first, so that "before" means before
+ * them too. */
+static void action_focuslast(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    novawm_input_commit(srv);
+    struct novawm_workspace *ws = current_ws(srv);
+    struct novawm_client *c = ws->mru;
+    if (c && c == ws->focused)
+        c = c->mru_next;
+    if (c)
+        novawm_focus_client(srv, c);
+}
+
+static void txn_plan(struct novawm_server *srv);
+
+/* Directional steps look at where tiles are, so inside a transaction the
+ * pending arrange is planned first. */
+static void focus_dir(struct novawm_server *srv, enum novawm_dir dir) {
+    txn_plan(srv);
+    struct novawm_client *c = current_ws(srv)->focused;
+    struct novawm_client *n = novawm_spatial_neighbor(srv, c, dir);
+    if (n)
+        novawm_focus_client(srv, n);
+}
+
+static void swap_dir(struct novawm_server *srv, enum novawm_dir dir) {
+    txn_plan(srv);
+    struct novawm_client *c = current_ws(srv)->focused;
+    struct novawm_client *n = novawm_spatial_neighbor(srv, c, dir);
+    if (n && !n->scratch) {
+        novawm_swap_clients(srv, c, n);
+        novawm_arrange(srv);
+    }
+}
+
+static void action_focusleft(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    focus_dir(srv, NOVAWM_DIR_LEFT);
+}
+
+static void action_focusright(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    focus_dir(srv, NOVAWM_DIR_RIGHT);
+}
+
+static void action_focusup(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    focus_dir(srv, NOVAWM_DIR_UP);
+}
+
+static void action_focusdown(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    focus_dir(srv, NOVAWM_DIR_DOWN);
+}
+
+static void action_swapleft(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    swap_dir(srv, NOVAWM_DIR_LEFT);
+}
+
+static void action_swapright(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    swap_dir(srv, NOVAWM_DIR_RIGHT);
+}
+
+static void action_swapup(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    swap_dir(srv, NOVAWM_DIR_UP);
+}
+
+static void action_swapdown(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    swap_dir(srv, NOVAWM_DIR_DOWN);
+}
+
+/* action "layout": arg "dwindle" or "monocle", or none to toggle */
+static void action_layout(struct novawm_server *srv, const char *arg) {
+    struct novawm_workspace *ws = current_ws(srv);
+    enum novawm_layout l;
+
+    /* no argument: monocle and back to the configured tiling layout */
+    if (!arg || !*arg)
+        l = ws->layout != NOVAWM_LAYOUT_MONOCLE ? NOVAWM_LAYOUT_MONOCLE
+          : srv->cfg.layout != NOVAWM_LAYOUT_MONOCLE ? srv->cfg.layout
+          : NOVAWM_LAYOUT_DWINDLE;
+    else if (!novawm_layout_parse(arg, &l))
+        return;
+
+    if (l == ws->layout)
+        return;
+    ws->layout = l;
+    novawm_arrange(srv);
 }
 
 static void action_togglefloating(struct novawm_server *srv, const char *arg) {
@@ -64,18 +150,21 @@ static void action_togglefloating(struct novawm_server *srv, const char *arg) {
     novawm_toggle_floating(srv);
 }
 
+static void action_fullscreen(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    struct novawm_client *c = current_ws(srv)->focused;
+    if (c)
+        novawm_set_fullscreen(srv, c, !c->fullscreen);
+}
+
 static void action_grow(struct novawm_server *srv, const char *arg) {
     (void)arg;
-    srv->cfg.master_factor += 0.05f;
-    if (srv->cfg.master_factor > 0.95f) srv->cfg.master_factor = 0.95f;
-    novawm_arrange(srv);
+    srv->pending.factor_delta += 0.05f;
 }
 
 static void action_shrink(struct novawm_server *srv, const char *arg) {
     (void)arg;
-    srv->cfg.master_factor -= 0.05f;
-    if (srv->cfg.master_factor < 0.05f) srv->cfg.master_factor = 0.05f;
-    novawm_arrange(srv);
+    srv->pending.factor_delta -= 0.05f;
 }
 
 static void action_quit(struct novawm_server *srv, const char *arg) {
@@ -83,7 +172,119 @@ static void action_quit(struct novawm_server *srv, const char *arg) {
     srv->running = false;
 }
 
+static void action_scratchpad(struct novawm_server *srv, const char *arg) {
+    novawm_scratchpad_toggle(srv, arg);
+}
+
+static void action_movetoscratchpad(struct novawm_server *srv,
+                                    const char *arg) {
+    novawm_scratchpad_move_focused(srv, arg);
+}
+
+static void action_restart(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    novawm_restart(srv);
+}
+
+static void action_stats(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    novawm_stats_dump(srv, stderr);
+}
+
+static void action_trace(struct novawm_server *srv, const char *arg) {
+    (void)arg;
+    novawm_trace_dump(srv);
+}
+
 /* workspace switch: action "workspace", arg "1".."10" */
+static void hide_workspace(struct novawm_server *srv, int idx) {
+    for (struct novawm_client *c = srv->mon.ws[idx].clients; c; c = c->next) {
+        novawm_client_set_mapped(srv, c, false);
+        novawm_client_set_hidden(srv, c, true);
+        novawm_spatial_remove(srv, c);
+    }
+}
+
+/* Bring the spatial grid up to date with what the open transaction has
+ * held back, without sending anything: workspaces switched away from
+ * leave the grid and the current one is indexed where the arrange will
+ * put it. */
+static void txn_plan(struct novawm_server *srv) {
+    struct novawm_txn *t = &srv->txn;
+    int cur = srv->mon.current_ws;
+    if (!t->depth || !t->arrange)
+        return;
+
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        if (i == cur || (i != t->shown_ws && !(t->planned & (1u << i))))
+            continue;
+        for (struct novawm_client *c = srv->mon.ws[i].clients; c; c = c->next)
+            novawm_spatial_remove(srv, c);
+    }
+    novawm_layout_plan(srv);
+    t->planned |= 1u << cur;
+}
+
+/* Planned geometry is only a guess at what the arrange will do; drop it
+ * before the real one runs. Workspaces planned but no longer current were
+ * never shown, so their clients leave the grid again. */
+static void txn_unplan(struct novawm_server *srv) {
+    struct novawm_txn *t = &srv->txn;
+    for (int i = 0; t->planned; i++) {
+        if (!(t->planned & (1u << i)))
+            continue;
+        t->planned &= ~(1u << i);
+        for (struct novawm_client *c = srv->mon.ws[i].clients; c; c = c->next) {
+            if (c->planned) {
+                c->planned = false;
+                c->grid_dirty = true;
+            }
+            if (i != srv->mon.current_ws)
+                novawm_spatial_remove(srv, c);
+        }
+    }
+}
+
+/* Do what the transaction has held back. It is still open, so nothing
+ * is flushed yet. */
+static void txn_settle(struct novawm_server *srv) {
+    struct novawm_txn *t = &srv->txn;
+
+    txn_unplan(srv);
+    if (t->shown_ws >= 0 && t->shown_ws != srv->mon.current_ws)
+        hide_workspace(srv, t->shown_ws);
+    t->shown_ws = -1;
+    if (t->arrange)
+        novawm_arrange_held(srv);
+    t->arrange = false;
+}
+
+static void txn_begin(struct novawm_server *srv) {
+    if (srv->txn.depth++)
+        return;
+    srv->txn.arrange = false;
+    srv->txn.focus = false;
+    srv->txn.shown_ws = -1;
+    srv->txn.planned = 0;
+}
+
+static void txn_commit(struct novawm_server *srv) {
+    if (srv->txn.depth > 1) {
+        srv->txn.depth--;
+        return;
+    }
+    txn_settle(srv);
+    srv->txn.depth = 0;
+
+    if (srv->txn.focus) {
+        struct novawm_client *f = srv->scratch_focused
+            ? srv->scratch_focused : current_ws(srv)->focused;
+        novawm_set_focus(srv, f ? f->win : srv->root);
+        srv->txn.focus = false;
+    }
+    novawm_flush(srv);
+}
+
 static void action_workspace(struct novawm_server *srv, const char *arg) {
     if (!arg || !*arg) return;
     int idx = atoi(arg);
@@ -93,62 +294,225 @@ static void action_workspace(struct novawm_server *srv, const char *arg) {
     if (srv->mon.current_ws == idx)
         return;
 
+    int old = srv->mon.current_ws;
     srv->mon.current_ws = idx;
-
-    /* map current, unmap others */
-    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
-        struct novawm_client *c = srv->mon.ws[i].clients;
-        while (c) {
-            if (i == idx) {
-                /* show windows on the new workspace */
-                xcb_map_window(srv->conn, c->win);
-            } else {
-                /* hide windows from other workspaces – we now ignore UnmapNotify */
-                xcb_unmap_window(srv->conn, c->win);
-            }
-            c = c->next;
-        }
+    novawm_stack_invalidate(srv);
+
+    /* Only the two workspaces involved change state; arrange maps what
+     * the new layout shows, and the map/unmap and hint requests all go
+     * out with its flush. In a transaction the workspace that is on
+     * screen is only hidden at the end, if it is not shown again. */
+    if (srv->txn.depth) {
+        if (srv->txn.shown_ws < 0)
+            srv->txn.shown_ws = old;
+    } else {
+        hide_workspace(srv, old);
     }
 
     struct novawm_workspace *ws = &srv->mon.ws[idx];
-    if (ws->focused)
-        novawm_focus_client(srv, ws->focused);
-    else if (ws->clients)
-        novawm_focus_client(srv, ws->clients);
+    if (!ws->focused)
+        ws->focused = ws->mru;
+    srv->scratch_focused = NULL;
 
-    novawm_arrange(srv);
+    novawm_arrange(srv); /* also maps and marks the new workspace visible */
+
+    if (ws->focused) {
+        novawm_set_focus(srv, ws->focused->win);
+        novawm_flush(srv);
+    }
+}
+
+/* Actions that make sense to auto-repeat and can be folded together. */
+static bool action_is_repeatable(const char *action) {
+    return !strcmp(action, "focusnext") ||
+           !strcmp(action, "focusprev") ||
+           !strcmp(action, "grow")      ||
+           !strcmp(action, "shrink");
+}
+
+static void action_chain(struct novawm_server *srv, const char *arg);
+
+static const struct {
+    const char *name;
+    void (*fn)(struct novawm_server *srv, const char *arg);
+} actions[] = {
+    { "spawn",            action_spawn },
+    { "killactive",       action_kill },
+    { "focusnext",        action_focusnext },
+    { "focusprev",        action_focusprev },
+    { "focuslast",        action_focuslast },
+    { "focusleft",        action_focusleft },
+    { "focusright",       action_focusright },
+    { "focusup",          action_focusup },
+    { "focusdown",        action_focusdown },
+    { "swapleft",         action_swapleft },
+    { "swapright",        action_swapright },
+    { "swapup",           action_swapup },
+    { "swapdown",         action_swapdown },
+    { "layout",           action_layout },
+    { "togglefloating",   action_togglefloating },
+    { "fullscreen",       action_fullscreen },
+    { "grow",             action_grow },
+    { "shrink",           action_shrink },
+    { "quit",             action_quit },
+    { "workspace",        action_workspace },
+    { "scratchpad",       action_scratchpad },
+    { "movetoscratchpad", action_movetoscratchpad },
+    { "restart",          action_restart },
+    { "stats",            action_stats },
+    { "trace",            action_trace },
+    { "chain",            action_chain },
+};
+
+/* Does `s` start with an action name, as a whole word? */
+static bool starts_with_action(const char *s) {
+    s += strspn(s, " \t");
+    size_t n = strcspn(s, " \t,;");
+    for (size_t i = 0; i < sizeof actions / sizeof actions[0]; i++)
+        if (strlen(actions[i].name) == n && !strncmp(actions[i].name, s, n))
+            return true;
+    return false;
+}
+
+/* Cut the step at the start of `s` off the list. A ';' only ends it when
+ * an action name follows, so "spawn, sh -c 'a; b'" stays one step; "\;"
+ * is a literal ';' either way and is unescaped in place. Returns the rest
+ * of the list, or NULL after the last step. */
+static char *next_step(char *s) {
+    char *out = s;
+    for (char *p = s; *p; p++) {
+        if (p[0] == '\\' && p[1] == ';') {
+            *out++ = *++p;
+        } else if (*p == ';' && starts_with_action(p + 1)) {
+            *out = '\0';
+            return p + 1;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+    return NULL;
 }
 
-static void dispatch_action(struct novawm_server *srv,
+/* "workspace 3; togglefloating; spawn, kitty": each step is an action
+ * and its argument, separated by a space or a comma. The steps run in
+ * order against the in-memory state and the result goes to the server in
+ * one batch, with one arrange. */
+static void action_chain(struct novawm_server *srv, const char *arg) {
+    if (!arg || !*arg) return;
+    char buf[256];
+    snprintf(buf, sizeof buf, "%s", arg);
+
+    txn_begin(srv);
+    for (char *step = buf, *rest; step; step = rest) {
+        rest = next_step(step);
+        char *name = step + strspn(step, " \t");
+        if (!*name)
+            continue;
+        char *sarg = name + strcspn(name, " \t,");
+        if (*sarg) {
+            *sarg++ = '\0';
+            sarg += strspn(sarg, " \t,");
+        }
+        size_t n = strlen(sarg);
+        while (n && (sarg[n - 1] == ' ' || sarg[n - 1] == '\t'))
+            sarg[--n] = '\0';
+
+        /* folded steps still apply in order, just not on the wire */
+        if (!action_is_repeatable(name))
+            novawm_input_commit(srv);
+        novawm_dispatch_action(srv, name, sarg);
+    }
+    novawm_input_commit(srv);
+    txn_commit(srv);
+}
+
+void novawm_dispatch_action(struct novawm_server *srv,
                             const char *action, const char *arg) {
-    if (!strcmp(action, "spawn"))               action_spawn(srv, arg);
-    else if (!strcmp(action, "killactive"))     action_kill(srv, arg);
-    else if (!strcmp(action, "focusnext"))      action_focusnext(srv, arg);
-    else if (!strcmp(action, "focusprev"))      action_focusprev(srv, arg);
-    else if (!strcmp(action, "togglefloating")) action_togglefloating(srv, arg);
-    else if (!strcmp(action, "grow"))           action_grow(srv, arg);
-    else if (!strcmp(action, "shrink"))         action_shrink(srv, arg);
-    else if (!strcmp(action, "quit"))           action_quit(srv, arg);
-    else if (!strcmp(action, "workspace"))      action_workspace(srv, arg);
+    for (size_t i = 0; i < sizeof actions / sizeof actions[0]; i++) {
+        if (!strcmp(action, actions[i].name)) {
+            actions[i].fn(srv, arg);
+            return;
+        }
+    }
+}
+
+void novawm_input_commit(struct novawm_server *srv) {
+    struct novawm_pending p = srv->pending;
+    srv->pending.factor_delta = 0.0f;
+    srv->pending.focus_steps = 0;
+
+    bool rearrange = false;
+    struct novawm_workspace *cur = current_ws(srv);
+
+    if (p.factor_delta != 0.0f && cur->layout == NOVAWM_LAYOUT_BSP &&
+        cur->focused && cur->focused->leaf) {
+        /* bsp: only the split next to the focused tile moves */
+        rearrange = novawm_bsp_resize(cur->focused, p.factor_delta);
+    } else if (p.factor_delta != 0.0f) {
+        float f = srv->cfg.master_factor + p.factor_delta;
+        if (f > 0.95f) f = 0.95f;
+        if (f < 0.05f) f = 0.05f;
+        rearrange = (f != srv->cfg.master_factor);
+        srv->cfg.master_factor = f;
+    }
+
+    if (p.focus_steps) {
+        struct novawm_workspace *ws = current_ws(srv);
+        struct novawm_client *c = focus_step(ws, p.focus_steps);
+        if (c && c != ws->focused) {
+            novawm_focus_client(srv, c); /* arranges */
+            rearrange = false;
+        }
+    }
+
+    if (rearrange)
+        novawm_arrange(srv);
 }
 
 /* ------ Keyboard ------ */
 
 void novawm_handle_key_press(struct novawm_server *srv,
                              xcb_key_press_event_t *ev) {
+    /* With detectable autorepeat there is no KeyRelease between repeats,
+     * so a press of the key that is still held is a repeat. */
+    bool repeat = (ev->detail == srv->held_key);
+    srv->held_key = ev->detail;
+    if (repeat)
+        srv->stats.key_repeats++;
+
     uint16_t mods = novawm_clean_mods(ev->state);
     xcb_keysym_t ks = novawm_keycode_to_keysym(srv, ev->detail);
     if (ks == XCB_NO_SYMBOL) return;
 
     for (int i = 0; i < srv->cfg.binds_len; i++) {
         struct novawm_bind *b = &srv->cfg.binds[i];
-        if (b->mods == mods && b->keysym == ks) {
-            dispatch_action(srv, b->action, b->arg);
-            break;
+        if (b->mods != mods || b->keysym != ks)
+            continue;
+
+        if (action_is_repeatable(b->action)) {
+            if (srv->pending.factor_delta != 0.0f ||
+                srv->pending.focus_steps != 0)
+                srv->stats.coalesced++;
+        } else {
+            /* holding Super+Return must not spawn a terminal per repeat */
+            if (repeat)
+                break;
+            /* keep ordering: folded actions land before this one */
+            novawm_input_commit(srv);
         }
+
+        novawm_dispatch_action(srv, b->action, b->arg);
+        break;
     }
 }
 
+void novawm_handle_key_release(struct novawm_server *srv,
+                               xcb_key_release_event_t *ev) {
+    if (ev->detail == srv->held_key)
+        srv->held_key = 0;
+}
+
 /* ------ Mouse ------ */
 
 void novawm_handle_button_press(struct novawm_server *srv,
@@ -167,8 +531,16 @@ void novawm_handle_button_press(struct novawm_server *srv,
     if (!(ev->state & NOVAWM_MOD_MASK))
         return;
 
-    /* when we start dragging, treat the window as floating */
-    c->floating = true;
+    /* MOD+SHIFT+left on a tile: drop it onto another tile to swap them */
+    srv->drag.swapping = !c->floating && !c->scratch && ev->detail == 1 &&
+                         (ev->state & XCB_MOD_MASK_SHIFT);
+
+    if (!srv->drag.swapping) {
+        /* when we start dragging, treat the window as floating */
+        c->floating = true;
+        novawm_layout_invalidate(srv, c->ws);
+        novawm_stack_raise(srv, c);
+    }
 
     srv->drag.active = true;
     srv->drag.client = c;
@@ -179,49 +551,100 @@ void novawm_handle_button_press(struct novawm_server *srv,
     srv->drag.start_w = c->w;
     srv->drag.start_h = c->h;
     srv->drag.resizing = (ev->detail == 3); /* 1 = left, 3 = right */
+    srv->stats.drags++;
+
+    enum novawm_drag_mode mode = srv->drag.resizing
+        ? srv->cfg.drag_resize_mode : srv->cfg.drag_move_mode;
+    srv->drag.outline = !srv->drag.swapping && mode == NOVAWM_DRAG_OUTLINE;
+    if (srv->drag.outline) {
+        srv->drag.ox = c->x;
+        srv->drag.oy = c->y;
+        srv->drag.ow = c->w;
+        srv->drag.oh = c->h;
+        novawm_outline_show(srv, c->x, c->y, c->w, c->h);
+        novawm_flush(srv);
+    }
 }
 
 void novawm_handle_button_release(struct novawm_server *srv,
                                   xcb_button_release_event_t *ev) {
-    (void)ev;
+    struct novawm_client *c = srv->drag.client;
+    bool swapping = srv->drag.active && srv->drag.swapping;
+
+    bool outline = srv->drag.active && srv->drag.outline;
+
     srv->drag.active = false;
+    srv->drag.swapping = false;
+    srv->drag.outline = false;
+
+    if (outline && c) {
+        /* the only configure of the whole drag */
+        uint64_t before = srv->stats.configures;
+        novawm_outline_hide(srv);
+        novawm_client_configure(srv, c, srv->drag.ox, srv->drag.oy,
+                                srv->drag.ow, srv->drag.oh);
+        srv->stats.drag_configures += srv->stats.configures - before;
+        novawm_spatial_update(srv, c);
+        novawm_flush(srv);
+    }
+
+    if (swapping && c) {
+        struct novawm_client *t = novawm_spatial_at(srv, ev->root_x,
+                                                    ev->root_y);
+        if (t && t != c && !t->floating && t->ws == c->ws) {
+            novawm_swap_clients(srv, c, t);
+            novawm_arrange(srv);
+        }
+    }
 }
 
 void novawm_handle_motion_notify(struct novawm_server *srv,
                                  xcb_motion_notify_event_t *ev) {
-    if (!srv->drag.active || !srv->drag.client)
+    if (!srv->drag.active || !srv->drag.client || srv->drag.swapping)
         return;
 
     int dx = ev->root_x - srv->drag.start_root_x;
     int dy = ev->root_y - srv->drag.start_root_y;
 
     struct novawm_client *c = srv->drag.client;
+    int nx = c->x, ny = c->y, nw = c->w, nh = c->h;
+
+    if (srv->drag.outline) {
+        nx = srv->drag.ox;
+        ny = srv->drag.oy;
+        nw = srv->drag.ow;
+        nh = srv->drag.oh;
+    }
 
     if (!srv->drag.resizing) {
         /* Move */
-        int nx = srv->drag.start_x + dx;
-        int ny = srv->drag.start_y + dy;
-        uint32_t values[2] = { (uint32_t)nx, (uint32_t)ny };
-        xcb_configure_window(srv->conn, c->win,
-                             XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y,
-                             values);
-        c->x = nx;
-        c->y = ny;
+        nx = srv->drag.start_x + dx;
+        ny = srv->drag.start_y + dy;
     } else {
-        /* Resize */
-        int nw = srv->drag.start_w + dx;
-        int nh = srv->drag.start_h + dy;
+        /* Resize; throttled to the client's paint rate if it supports
+         * _NET_WM_SYNC_REQUEST */
+        nw = srv->drag.start_w + dx;
+        nh = srv->drag.start_h + dy;
         if (nw < 50) nw = 50;
         if (nh < 50) nh = 50;
-        uint32_t values[2] = { (uint32_t)nw, (uint32_t)nh };
-        xcb_configure_window(srv->conn, c->win,
-                             XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                             values);
-        c->w = nw;
-        c->h = nh;
+        novawm_size_hints_apply(&c->hints, &nw, &nh);
+    }
+
+    if (srv->drag.outline) {
+        /* only the wireframe follows the pointer */
+        srv->drag.ox = nx;
+        srv->drag.oy = ny;
+        srv->drag.ow = nw;
+        srv->drag.oh = nh;
+        novawm_outline_show(srv, nx, ny, nw, nh);
+    } else {
+        uint64_t before = srv->stats.configures;
+        novawm_client_configure(srv, c, nx, ny, nw, nh);
+        srv->stats.drag_configures += srv->stats.configures - before;
+        novawm_spatial_update(srv, c);
     }
 
-    xcb_flush(srv->conn);
+    novawm_flush(srv);
 }
 
 void novawm_handle_enter_notify(struct novawm_server *srv,
@@ -253,5 +676,5 @@ xcb_keysym_t novawm_keycode_to_keysym(struct novawm_server *srv,
                                       xcb_keycode_t code) {
     if (!srv || !srv->keysyms)
         return XCB_NO_SYMBOL;
-    return xcb_key_symbols_get_keysym(srv->keysyms, code, 0);
+    return NOVAWM_REPLY(srv, xcb_key_symbols_get_keysym(srv->keysyms, code, 0));
 }
\ No newline at end of file
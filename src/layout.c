@@ -1,52 +1,94 @@
 #include "novawm.h"
 #include <xcb/xcb.h>
 #include <stdlib.h>
+#include <strings.h>
+
+/* Set while novawm_layout_plan() runs: geometry is recorded in plan_*,
+ * nothing is sent. */
+static bool planning;
+
+/* Border width and colour, sent only when they differ from what the
+ * window already has. */
+static void apply_border(struct novawm_server *srv,
+                         struct novawm_workspace *ws,
+                         struct novawm_client *c) {
+    if (planning)
+        return;
+    int width = c->fullscreen ? 0 : srv->cfg.border_width;
+    if (c->border_w != width) {
+        uint32_t bw = (uint32_t)width;
+        srv->backend->configure(
+            srv,
+            c->win,
+            XCB_CONFIG_WINDOW_BORDER_WIDTH,
+            &bw
+        );
+        c->border_w = width;
+    }
+
+    uint32_t color = (c == ws->focused)
+        ? srv->cfg.border_color_active
+        : srv->cfg.border_color_inactive;
+
+    if (!c->border_set || c->border_color != color) {
+        srv->backend->set_attributes(
+            srv,
+            c->win,
+            XCB_CW_BORDER_PIXEL,
+            &color
+        );
+        c->border_color = color;
+        c->border_set = true;
+    }
+}
+
+static void plan_client(struct novawm_client *c, int x, int y, int w, int h) {
+    c->plan_x = x;
+    c->plan_y = y;
+    c->plan_w = w;
+    c->plan_h = h;
+    c->planned = true;
+    c->grid_dirty = true;
+}
 
 static void apply_client_geometry(struct novawm_server *srv,
                                   struct novawm_client *c,
                                   int x, int y, int w, int h) {
     struct novawm_workspace *ws = &srv->mon.ws[srv->mon.current_ws];
 
-    uint32_t geom[4] = {
-        (uint32_t)x,
-        (uint32_t)y,
-        (uint32_t)w,
-        (uint32_t)h
-    };
+    c->tile_x = x;
+    c->tile_y = y;
+    c->tile_w = w;
+    c->tile_h = h;
 
-    xcb_configure_window(
-        srv->conn,
-        c->win,
-        XCB_CONFIG_WINDOW_X |
-        XCB_CONFIG_WINDOW_Y |
-        XCB_CONFIG_WINDOW_WIDTH |
-        XCB_CONFIG_WINDOW_HEIGHT,
-        geom
-    );
-
-    c->x = x;
-    c->y = y;
-    c->w = w;
-    c->h = h;
-
-    uint32_t bw = srv->cfg.border_width;
-    xcb_configure_window(
-        srv->conn,
-        c->win,
-        XCB_CONFIG_WINDOW_BORDER_WIDTH,
-        &bw
-    );
+    /* Snap to the client's resize increments and centre it in the slot,
+     * the leftover pixels becoming padding. */
+    int cw = w, ch = h;
+    novawm_size_hints_apply(&c->hints, &cw, &ch);
+    if (cw > w) cw = w;
+    if (ch > h) ch = h;
 
-    uint32_t color = (c == ws->focused)
-        ? srv->cfg.border_color_active
-        : srv->cfg.border_color_inactive;
+    int cx = x + (w - cw) / 2;
+    int cy = y + (h - ch) / 2;
+
+    /* Same cell grid and still inside its slot: leave it alone, so a small
+     * factor change does not reflow every terminal. */
+    if (c->w == cw && c->h == ch &&
+        c->x >= x && c->y >= y &&
+        c->x + cw <= x + w && c->y + ch <= y + h) {
+        cx = c->x;
+        cy = c->y;
+    }
+
+    if (planning) {
+        plan_client(c, cx, cy, cw, ch);
+        return;
+    }
 
-    xcb_change_window_attributes(
-        srv->conn,
-        c->win,
-        XCB_CW_BORDER_PIXEL,
-        &color
-    );
+    /* no-op if it is already there (e.g. adopted after restart) */
+    novawm_client_configure(srv, c, cx, cy, cw, ch);
+
+    apply_border(srv, ws, c);
 }
 
 /* Recursive dwindle tiling:
@@ -126,10 +168,185 @@ static void dwindle_place(struct novawm_server *srv,
     }
 }
 
-void novawm_arrange(struct novawm_server *srv) {
+/* Each leaf gets its node's rectangle, inner gaps inside it as in
+ * dwindle; a split divides it by its own ratio, leaving each side at
+ * least a pixel. A split only 1 px across gives both sides that pixel, so
+ * no leaf is left with an empty rectangle and its old geometry. */
+static void bsp_place(struct novawm_server *srv, struct novawm_bsp_node *n,
+                      int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0)
+        return;
+
+    if (!n->child[0]) {
+        int inner = srv->cfg.gaps_inner;
+        int gw = w - 2 * inner;
+        int gh = h - 2 * inner;
+        if (gw < 1) gw = 1;
+        if (gh < 1) gh = 1;
+        apply_client_geometry(srv, n->client, x + inner, y + inner, gw, gh);
+        return;
+    }
+
+    if (n->vertical) {
+        int w1 = (int)(w * n->ratio);
+        if (w1 > w - 1) w1 = w - 1;
+        if (w1 < 1) w1 = 1;
+        int w2 = w - w1 < 1 ? 1 : w - w1;
+        bsp_place(srv, n->child[0], x, y, w1, h);
+        bsp_place(srv, n->child[1], x + w - w2, y, w2, h);
+    } else {
+        int h1 = (int)(h * n->ratio);
+        if (h1 > h - 1) h1 = h - 1;
+        if (h1 < 1) h1 = 1;
+        int h2 = h - h1 < 1 ? 1 : h - h1;
+        bsp_place(srv, n->child[0], x, y, w, h1);
+        bsp_place(srv, n->child[1], x, y + h - h2, w, h2);
+    }
+}
+
+static bool rect_covers(const struct novawm_client *ca,
+                        const struct novawm_client *cb) {
+    struct novawm_box a = novawm_client_box(ca);
+    struct novawm_box b = novawm_client_box(cb);
+    return a.x <= b.x && a.y <= b.y &&
+           a.x + a.w >= b.x + b.w &&
+           a.y + a.h >= b.y + b.h;
+}
+
+/* A tiled client is hidden when a floating one on the same workspace
+ * covers it completely, and everything is hidden behind a fullscreen
+ * client; the rest on screen is visible. In monocle only `shown` of the
+ * tiled clients stays mapped, so the others stop rendering and stop
+ * getting ConfigureNotify. They learn it from their UnmapNotify, and
+ * their hints are left as they were: a focus step is one map and one
+ * unmap, with no property writes. */
+static void update_visibility(struct novawm_server *srv,
+                              struct novawm_workspace *ws,
+                              struct novawm_client *shown) {
+    bool monocle = ws->layout == NOVAWM_LAYOUT_MONOCLE;
+
+    /* only floating clients can cover a tile: tiles times floats, not n^2 */
+    int nfloat = 0;
+    for (struct novawm_client *c = ws->clients; c; c = c->next)
+        if (c->floating)
+            nfloat++;
+    struct novawm_client *floats[nfloat ? nfloat : 1];
+    nfloat = 0;
+    for (struct novawm_client *c = ws->clients; c; c = c->next)
+        if (c->floating)
+            floats[nfloat++] = c;
+
+    for (struct novawm_client *c = ws->clients; c; c = c->next) {
+        bool hidden = false;
+        bool unmap = monocle && !c->floating && c != shown &&
+                     c != ws->fullscreen;
+        if (!planning)
+            novawm_client_set_mapped(srv, c, !unmap);
+
+        if (ws->fullscreen) {
+            hidden = (c != ws->fullscreen);
+        } else if (unmap) {
+            hidden = true;
+        } else if (!c->floating) {
+            for (int i = 0; i < nfloat; i++) {
+                if (rect_covers(floats[i], c)) {
+                    hidden = true;
+                    break;
+                }
+            }
+        }
+        if (!unmap && !planning)
+            novawm_client_set_hidden(srv, c, hidden);
+
+        if (hidden)
+            novawm_spatial_remove(srv, c);
+        else if (c->grid_dirty || !c->indexed)
+            novawm_spatial_update(srv, c);
+    }
+}
+
+/* Whole monitor, no border. Like any other geometry it goes through
+ * novawm_client_configure, so an arrange that changes nothing sends
+ * nothing. The fullscreen layer puts it above the rest at the next stack
+ * commit. */
+static void apply_fullscreen(struct novawm_server *srv,
+                             struct novawm_workspace *ws,
+                             struct novawm_client *c) {
+    struct novawm_monitor *m = &srv->mon;
+
+    if (planning) {
+        plan_client(c, m->x, m->y, m->w, m->h);
+        return;
+    }
+    apply_border(srv, ws, c);
+    novawm_client_configure(srv, c, m->x, m->y, m->w, m->h);
+}
+
+bool novawm_layout_parse(const char *name, enum novawm_layout *out) {
+    if (!strcasecmp(name, "dwindle"))
+        *out = NOVAWM_LAYOUT_DWINDLE;
+    else if (!strcasecmp(name, "monocle"))
+        *out = NOVAWM_LAYOUT_MONOCLE;
+    else if (!strcasecmp(name, "bsp"))
+        *out = NOVAWM_LAYOUT_BSP;
+    else
+        return false;
+    return true;
+}
+
+/* The tiled client monocle shows: the focused one, or whichever tile was
+ * on screen while focus sits on a floating window. */
+static struct novawm_client *monocle_pick(struct novawm_workspace *ws) {
+    struct novawm_client *first = NULL;
+
+    if (ws->focused && !ws->focused->floating)
+        return ws->focused;
+    for (struct novawm_client *c = ws->clients; c; c = c->next) {
+        if (c->floating)
+            continue;
+        if (c->mapped)
+            return c;
+        if (!first)
+            first = c;
+    }
+    return first;
+}
+
+/* The tiles' slots change when the clients, their order, floating flags
+ * or size hints on a workspace change; everything else that goes into the
+ * layout is in struct novawm_layout_key. */
+void novawm_layout_invalidate(struct novawm_server *srv, int ws) {
+    if (ws >= 0 && ws < NOVAWM_WORKSPACES)
+        srv->mon.ws[ws].layout_gen++;
+}
+
+static bool layout_key_equal(const struct novawm_layout_key *a,
+                             const struct novawm_layout_key *b) {
+    return a->valid && b->valid && a->gen == b->gen &&
+           a->focused == b->focused && a->factor == b->factor &&
+           a->gaps_inner == b->gaps_inner &&
+           a->x == b->x && a->y == b->y && a->w == b->w && a->h == b->h;
+}
+
+static void arrange(struct novawm_server *srv) {
     struct novawm_monitor   *m  = &srv->mon;
     struct novawm_workspace *ws = &m->ws[m->current_ws];
 
+    if (!planning)
+        srv->stats.arranges++;
+
+    /* only the dwindle path below records and reuses slots */
+    struct novawm_layout_key key = ws->layout_key;
+    ws->layout_key.valid = false;
+
+    /* fast path: nothing else on this workspace is visible */
+    if (ws->fullscreen) {
+        apply_fullscreen(srv, ws, ws->fullscreen);
+        update_visibility(srv, ws, NULL);
+        novawm_flush(srv);
+        return;
+    }
+
     /* Count tiled (non-floating) clients and collect them. */
     int tiled = 0;
     for (struct novawm_client *c = ws->clients; c; c = c->next) {
@@ -140,31 +357,68 @@ void novawm_arrange(struct novawm_server *srv) {
     int outer = srv->cfg.gaps_outer;
 
     int mx = m->x + outer;
-    int my = m->y + outer;
+    int my = m->y + outer + (srv->bar.bottom ? 0 : srv->bar.h);
     int mw = m->w - 2 * outer;
-    int mh = m->h - 2 * outer;
+    int mh = m->h - 2 * outer - srv->bar.h;
 
     if (tiled <= 0) {
         /* No tiled clients – still update borders of floating ones */
+        for (struct novawm_client *c = ws->clients; c; c = c->next)
+            apply_border(srv, ws, c);
+        update_visibility(srv, ws, NULL);
+        novawm_flush(srv);
+        return;
+    }
+
+    /* Monocle: one tile, and the hidden ones keep their old geometry */
+    if (ws->layout == NOVAWM_LAYOUT_MONOCLE) {
+        struct novawm_client *shown = monocle_pick(ws);
+        dwindle_place(srv, ws, &shown, 0, 1, mx, my, mw, mh, 0);
+        for (struct novawm_client *c = ws->clients; c; c = c->next)
+            if (c->floating)
+                apply_border(srv, ws, c);
+        update_visibility(srv, ws, shown);
+        novawm_flush(srv);
+        return;
+    }
+
+    /* bsp: the tree, not the list order, decides the slots */
+    if (ws->layout == NOVAWM_LAYOUT_BSP) {
+        novawm_bsp_sync(srv, ws);
+        if (ws->bsp)
+            bsp_place(srv, ws->bsp, mx, my, mw, mh);
+        for (struct novawm_client *c = ws->clients; c; c = c->next)
+            if (c->floating)
+                apply_border(srv, ws, c);
+        update_visibility(srv, ws, NULL);
+        novawm_flush(srv);
+        return;
+    }
+
+    /* Same inputs as last time (typically a workspace shown again): put
+     * every tile back into its slot, which sends nothing to the ones that
+     * are still there. */
+    struct novawm_layout_key now = {
+        .valid = true,
+        .gen = ws->layout_gen,
+        .focused = ws->focused,
+        .factor = srv->cfg.master_factor,
+        .gaps_inner = srv->cfg.gaps_inner,
+        .x = mx, .y = my, .w = mw, .h = mh,
+    };
+    ws->layout_key = now;
+    if (layout_key_equal(&key, &now)) {
+        if (!planning)
+            srv->stats.layouts_cached++;
         for (struct novawm_client *c = ws->clients; c; c = c->next) {
-            uint32_t bw = srv->cfg.border_width;
-            xcb_configure_window(
-                srv->conn,
-                c->win,
-                XCB_CONFIG_WINDOW_BORDER_WIDTH,
-                &bw
-            );
-            uint32_t color = (c == ws->focused)
-                ? srv->cfg.border_color_active
-                : srv->cfg.border_color_inactive;
-            xcb_change_window_attributes(
-                srv->conn,
-                c->win,
-                XCB_CW_BORDER_PIXEL,
-                &color
-            );
+            if (c->floating)
+                apply_border(srv, ws, c);
+            else
+                apply_client_geometry(srv, c, c->tile_x, c->tile_y,
+                                      c->tile_w, c->tile_h);
         }
-        xcb_flush(srv->conn);
+        update_visibility(srv, ws, NULL);
+        novawm_flush(srv);
         return;
     }
 
@@ -196,27 +450,38 @@ void novawm_arrange(struct novawm_server *srv) {
     dwindle_place(srv, ws, arr, 0, tiled, mx, my, mw, mh, 0);
 
     /* update borders for floating clients as well */
-    for (struct novawm_client *c = ws->clients; c; c = c->next) {
-        if (!c->floating)
-            continue;
+    for (struct novawm_client *c = ws->clients; c; c = c->next)
+        if (c->floating)
+            apply_border(srv, ws, c);
 
-        uint32_t bw = srv->cfg.border_width;
-        xcb_configure_window(
-            srv->conn,
-            c->win,
-            XCB_CONFIG_WINDOW_BORDER_WIDTH,
-            &bw
-        );
-        uint32_t color = (c == ws->focused)
-            ? srv->cfg.border_color_active
-            : srv->cfg.border_color_inactive;
-        xcb_change_window_attributes(
-            srv->conn,
-            c->win,
-            XCB_CW_BORDER_PIXEL,
-            &color
-        );
+    update_visibility(srv, ws, NULL);
+    novawm_flush(srv);
+}
+
+void novawm_arrange(struct novawm_server *srv) {
+    if (srv->txn.depth) {
+        srv->txn.arrange = true;
+        return;
     }
+    novawm_trace(srv, NOVAWM_TRACE_ARRANGE_BEGIN, 0, 0, NULL);
+    arrange(srv);
+    novawm_trace(srv, NOVAWM_TRACE_ARRANGE_END, 0, 0, NULL);
+}
 
-    xcb_flush(srv->conn);
-}
\ No newline at end of file
+/* The arrange a transaction held back, run before it closes; its flush
+ * is a no-op until then. */
+void novawm_arrange_held(struct novawm_server *srv) {
+    novawm_trace(srv, NOVAWM_TRACE_ARRANGE_BEGIN, 0, 0, NULL);
+    arrange(srv);
+    novawm_trace(srv, NOVAWM_TRACE_ARRANGE_END, 0, 0, NULL);
+}
+
+/* Inside a transaction: work out where the held-back arrange will put the
+ * current workspace's tiles and index them there. Nothing is sent and
+ * the clients keep their real geometry; the flush is a no-op while the
+ * transaction is open. The plans are dropped again when it settles. */
+void novawm_layout_plan(struct novawm_server *srv) {
+    planning = true;
+    arrange(srv);
+    planning = false;
+}
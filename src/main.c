@@ -1,21 +1,71 @@
 #include "novawm.h"
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main(void) {
-    struct novawm_server srv;
+/* Parses the config while the main thread waits on the X server. */
+static void *load_config(void *arg) {
+    struct novawm_server *srv = arg;
+    uint64_t t = novawm_now_us();
 
-    const char *cfg_path = novawm_get_config_path();
-    novawm_config_load(&srv.cfg, cfg_path);
+    novawm_config_load(&srv->cfg, novawm_get_config_path());
+    novawm_startup_phase(srv, NOVAWM_PHASE_CONFIG, t);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && !strcmp(argv[1], "--bench"))
+        return novawm_bench(argc > 2 ? atoi(argv[2]) : 0);
+    if (argc > 1 && !strcmp(argv[1], "--bench-boost"))
+        return novawm_bench_boost(argc > 2 ? atoi(argv[2]) : 0);
+
+    struct novawm_server srv = {0};
+    srv.argv = argv;
+    srv.startup.start_us = novawm_now_us();
+    novawm_audit_init(&srv);
+    novawm_trace_init(&srv);
+
+    pthread_t cfg_thread;
+    bool threaded = pthread_create(&cfg_thread, NULL, load_config, &srv) == 0;
+    if (!threaded)
+        load_config(&srv);
+
+    bool connected = novawm_x11_connect(&srv);
+    uint64_t t = novawm_startup_phase(&srv, NOVAWM_PHASE_CONNECT,
+                                      srv.startup.start_us);
+    if (threaded)
+        pthread_join(cfg_thread, NULL);
+    if (!connected)
+        return 1;
+    t = novawm_now_us(); /* any wait for the config is counted there */
+    novawm_memory_lock(&srv);
+    novawm_boost_init(&srv);   /* before anything is spawned */
 
     if (!novawm_x11_init(&srv))
         return 1;
+    novawm_state_init(&srv);
+    t = novawm_startup_phase(&srv, NOVAWM_PHASE_INIT, t);
 
     novawm_x11_grab_keys(&srv);
-    novawm_x11_scan_existing(&srv);
+    t = novawm_startup_phase(&srv, NOVAWM_PHASE_GRAB, t);
 
-    novawm_run_autostart(&srv.cfg);
+    /* The root is already redirected, so windows the autostart programs
+     * map before the scan arrive as MapRequests and are managed then.
+     * After a restart in place they are still running. */
+    if (!srv.restarted)
+        novawm_run_autostart(&srv.cfg);
+    t = novawm_startup_phase(&srv, NOVAWM_PHASE_AUTOSTART, t);
+
+    novawm_x11_scan_existing(&srv);
+    novawm_startup_phase(&srv, NOVAWM_PHASE_SCAN, t);
 
     novawm_x11_run(&srv);
+    novawm_boost_fini(&srv);
+    novawm_state_fini(&srv);
+    novawm_trace_fini(&srv);
 
+    if (srv.cfg.audit_fail && srv.audit.violations)
+        return 2;
     return 0;
-}
\ No newline at end of file
+}
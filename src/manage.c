@@ -1,6 +1,7 @@
 #include "novawm.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <xcb/xcb.h>
 
 struct novawm_client *novawm_find_client(struct novawm_server *srv,
@@ -13,110 +14,439 @@ struct novawm_client *novawm_find_client(struct novawm_server *srv,
             c = c->next;
         }
     }
+    for (int i = 0; i < srv->scratch_len; i++) {
+        struct novawm_client *c = srv->scratch[i].client;
+        if (c && c->win == win)
+            return c;
+    }
     return NULL;
 }
 
+static bool pool_init(struct novawm_client_pool *p, int size) {
+    p->slots = size ? calloc((size_t)size, sizeof *p->slots) : NULL;
+    if (size && !p->slots)
+        return false;
+    p->size = size;
+    p->free = NULL;
+    for (int i = size - 1; i >= 0; i--) {
+        p->slots[i].next = p->free;
+        p->free = &p->slots[i];
+    }
+    return true;
+}
+
+static struct novawm_client *client_alloc(struct novawm_server *srv) {
+    struct novawm_client_pool *p = &srv->pool;
+    struct novawm_client *c = p->free;
+    if (!c) {
+        c = calloc(1, sizeof *c);
+        if (c)
+            p->overflow++;
+        return c;
+    }
+    p->free = c->next;
+    p->used++;
+    memset(c, 0, sizeof *c);
+    return c;
+}
+
+static void client_free(struct novawm_server *srv, struct novawm_client *c) {
+    struct novawm_client_pool *p = &srv->pool;
+    if (c < p->slots || c >= p->slots + p->size) {
+        free(c);
+        return;
+    }
+    c->next = p->free;
+    p->free = c;
+    p->used--;
+}
+
+/* Backend-independent state, once the monitor size and config are known. */
+bool novawm_server_init(struct novawm_server *srv) {
+    if (!novawm_spatial_init(srv)) {
+        fprintf(stderr, "novawm: cannot alloc spatial index\n");
+        return false;
+    }
+    if (!pool_init(&srv->pool, srv->cfg.client_pool)) {
+        fprintf(stderr, "novawm: cannot alloc client pool\n");
+        return false;
+    }
+    if (!novawm_bsp_init(srv)) {
+        fprintf(stderr, "novawm: cannot alloc bsp nodes\n");
+        return false;
+    }
+    if (!novawm_stack_init(srv)) {
+        fprintf(stderr, "novawm: cannot alloc stacking slots\n");
+        return false;
+    }
+
+    /* workspaces init */
+    srv->mon.current_ws = 0;
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        srv->mon.ws[i].layout = srv->cfg.layout;
+        srv->mon.ws[i].clients = NULL;
+        srv->mon.ws[i].focused = NULL;
+    }
+
+    srv->drag.active = false;
+    srv->drag.client = NULL;
+    return true;
+}
+
+/* Flush, unless a transaction will do it once at its end. */
+void novawm_flush(struct novawm_server *srv) {
+    if (!srv->txn.depth)
+        srv->backend->flush(srv);
+}
+
+/* SetInputFocus; inside a transaction only the final focus is sent. */
+void novawm_set_focus(struct novawm_server *srv, xcb_window_t win) {
+    if (srv->txn.depth) {
+        srv->txn.focus = true;
+        return;
+    }
+    srv->backend->focus(srv, win);
+}
+
 void novawm_focus_client(struct novawm_server *srv, struct novawm_client *c) {
     if (!c)
         return;
 
+    /* focusnext/focusprev folded earlier in the batch step from the focus
+     * they saw, not from this one */
+    novawm_input_commit(srv);
+
+    if (c->scratch) {
+        /* floats above every workspace; never a workspace's focus */
+        srv->scratch_focused = c;
+        novawm_set_focus(srv, c->win);
+        novawm_flush(srv);
+        return;
+    }
+    srv->scratch_focused = NULL;
+
     /* focus per current workspace */
     struct novawm_workspace *ws = &srv->mon.ws[srv->mon.current_ws];
     if (ws->focused == c)
         return;
 
     ws->focused = c;
+    if (c->ws == srv->mon.current_ws)
+        novawm_mru_touch(ws, c);
+    srv->stats.focus_changes++;
 
-    uint32_t values[1] = { XCB_STACK_MODE_ABOVE };
-    xcb_configure_window(
-        srv->conn,
-        c->win,
-        XCB_CONFIG_WINDOW_STACK_MODE,
-        values
-    );
+    /* tiled windows don't overlap, so only floating ones need raising */
+    if (c->floating)
+        novawm_stack_raise(srv, c);
 
-    xcb_set_input_focus(
-        srv->conn,
-        XCB_INPUT_FOCUS_POINTER_ROOT,
-        c->win,
-        XCB_CURRENT_TIME
-    );
+    /* a monocle tile may be unmapped; it has to be viewable first (a
+     * transaction's closing arrange maps it) */
+    if (!srv->txn.depth)
+        novawm_client_set_mapped(srv, c, true);
+    novawm_set_focus(srv, c->win);
 
     novawm_arrange(srv);
 }
 
 void novawm_manage_window(struct novawm_server *srv, xcb_window_t win) {
-    /* get attributes */
-    xcb_get_window_attributes_cookie_t ac =
-        xcb_get_window_attributes(srv->conn, win);
-    xcb_get_window_attributes_reply_t *ar =
-        xcb_get_window_attributes_reply(srv->conn, ac, NULL);
-    if (!ar)
+    struct novawm_client *c = novawm_find_client(srv, win);
+    if (c) {
+        /* the client unmapped and re-mapped itself; let the layout
+         * decide whether it is on screen */
+        c->mapped = false;
+        if (c->scratch)
+            novawm_client_set_mapped(srv, c, true);
+        else if (c->ws == srv->mon.current_ws)
+            novawm_arrange(srv);
+        novawm_flush(srv);
         return;
+    }
 
-    if (ar->override_redirect) {
-        free(ar);
+    struct novawm_window_info info;
+    if (!srv->backend->query_window(srv, win, &info) ||
+        info.override_redirect)
         return;
-    }
 
-    free(ar);
+    struct novawm_rule_result rule;
+    novawm_rules_match(&srv->cfg.rules, &info.props, &rule);
 
-    struct novawm_client *c = calloc(1, sizeof *c);
+    struct novawm_scratchpad *sp =
+        novawm_scratchpad_get(srv, rule.scratchpad, true);
+    if (sp && sp->client)
+        sp = NULL;  /* already filled: manage this one normally */
+
+    int ws_idx = rule.workspace >= 0 ? rule.workspace : srv->mon.current_ws;
+
+    c = novawm_attach_client(srv, win, sp ? -1 : ws_idx);
     if (!c)
         return;
 
+    novawm_sync_setup(srv, c, info.sync_counter);
+    c->hints = info.hints;
+    c->pid = info.pid;
+    snprintf(c->title, sizeof c->title, "%s", info.props.title);
+    c->title_stale = false;
+    c->x = info.x;
+    c->y = info.y;
+    c->w = info.w;
+    c->h = info.h;
+
+    if (sp) {
+        if (rule.w > 0) {
+            c->w = rule.w;
+            c->h = rule.h;
+            uint32_t size[2] = { (uint32_t)c->w, (uint32_t)c->h };
+            srv->backend->configure(srv, win,
+                                    XCB_CONFIG_WINDOW_WIDTH |
+                                    XCB_CONFIG_WINDOW_HEIGHT, size);
+        }
+        novawm_scratchpad_capture(srv, sp, c);
+        return;
+    }
+
+    c->floating = (rule.floating == 1);
+    if (c->floating && rule.w > 0) {
+        /* sized by rule: centre it, one configure before it is mapped */
+        c->w = rule.w;
+        c->h = rule.h;
+        c->x = srv->mon.x + (srv->mon.w - c->w) / 2;
+        c->y = srv->mon.y + (srv->mon.h - c->h) / 2;
+
+        uint32_t geom[4] = {
+            (uint32_t)c->x, (uint32_t)c->y, (uint32_t)c->w, (uint32_t)c->h
+        };
+        srv->backend->configure(
+            srv,
+            win,
+            XCB_CONFIG_WINDOW_X |
+            XCB_CONFIG_WINDOW_Y |
+            XCB_CONFIG_WINDOW_WIDTH |
+            XCB_CONFIG_WINDOW_HEIGHT,
+            geom
+        );
+        srv->stats.configures++;
+    }
+
+    if (info.fullscreen)
+        novawm_set_fullscreen(srv, c, true);
+
+    if (ws_idx != srv->mon.current_ws) {
+        /* stays unmapped until its workspace is shown */
+        struct novawm_workspace *ws = &srv->mon.ws[ws_idx];
+        if (!ws->focused) {
+            ws->focused = c;
+            novawm_mru_touch(ws, c);
+        }
+        novawm_client_set_hidden(srv, c, true);
+        novawm_flush(srv);
+        return;
+    }
+
+    /* ensure window is mapped */
+    novawm_client_set_mapped(srv, c, true);
+
+    novawm_focus_client(srv, c);
+}
+
+/* Map or unmap a client unless it is already in that state; the
+ * UnmapNotify this causes is ignored. */
+void novawm_client_set_mapped(struct novawm_server *srv,
+                              struct novawm_client *c, bool mapped) {
+    if (c->mapped == mapped)
+        return;
+    if (mapped) {
+        srv->backend->map(srv, c->win);
+        srv->stats.maps++;
+    } else {
+        srv->backend->unmap(srv, c->win);
+        srv->stats.unmaps++;
+        c->unmaps_pending++;
+    }
+    c->mapped = mapped;
+}
+
+/* Workspace list and focus history are both intrusive doubly-linked
+ * lists; a NULL `pos` means the head. */
+static void ws_link_after(struct novawm_workspace *ws, struct novawm_client *c,
+                          struct novawm_client *pos) {
+    ws->layout_gen++;
+    c->prev = pos;
+    c->next = pos ? pos->next : ws->clients;
+    if (c->next)
+        c->next->prev = c;
+    else
+        ws->last = c;
+    if (pos)
+        pos->next = c;
+    else
+        ws->clients = c;
+}
+
+static void ws_unlink(struct novawm_workspace *ws, struct novawm_client *c) {
+    if (c->prev)
+        c->prev->next = c->next;
+    else if (ws->clients == c)
+        ws->clients = c->next;
+    else
+        return; /* not on this workspace */
+    ws->layout_gen++;
+    if (c->next)
+        c->next->prev = c->prev;
+    else
+        ws->last = c->prev;
+    c->next = c->prev = NULL;
+}
+
+static void mru_link_after(struct novawm_workspace *ws,
+                           struct novawm_client *c,
+                           struct novawm_client *pos) {
+    c->mru_prev = pos;
+    c->mru_next = pos ? pos->mru_next : ws->mru;
+    if (c->mru_next)
+        c->mru_next->mru_prev = c;
+    else
+        ws->mru_last = c;
+    if (pos)
+        pos->mru_next = c;
+    else
+        ws->mru = c;
+}
+
+static void mru_unlink(struct novawm_workspace *ws, struct novawm_client *c) {
+    if (c->mru_prev)
+        c->mru_prev->mru_next = c->mru_next;
+    else if (ws->mru == c)
+        ws->mru = c->mru_next;
+    else
+        return;
+    if (c->mru_next)
+        c->mru_next->mru_prev = c->mru_prev;
+    else
+        ws->mru_last = c->mru_prev;
+    c->mru_next = c->mru_prev = NULL;
+}
+
+/* Move `c` to the front of its workspace's focus history. */
+void novawm_mru_touch(struct novawm_workspace *ws, struct novawm_client *c) {
+    if (ws->mru == c)
+        return;
+    mru_unlink(ws, c);
+    mru_link_after(ws, c, NULL);
+}
+
+/* Allocate a client for `win`, link it at the head of workspace `ws` (or
+ * nowhere if `ws` is negative, for scratchpads) and select the events we
+ * need on it. Mapping and focus are up to the caller. */
+struct novawm_client *novawm_attach_client(struct novawm_server *srv,
+                                           xcb_window_t win, int ws_idx) {
+    struct novawm_client *c = client_alloc(srv);
+    if (!c)
+        return NULL;
+
     c->win = win;
     c->floating = false;
-    c->ws = srv->mon.current_ws;
+    c->ws = ws_idx;
     c->ignore_unmap = false;
+    c->border_w = -1;
+    c->title_stale = true;      /* unless the caller already knows it */
     c->next = NULL;
 
-    struct novawm_workspace *ws = &srv->mon.ws[c->ws];
+    if (ws_idx >= 0) {
+        struct novawm_workspace *ws = &srv->mon.ws[c->ws];
 
-    /* insert at head of workspace list */
-    c->next = ws->clients;
-    ws->clients = c;
+        /* insert at head of workspace list, at the end of its history
+         * until it is focused */
+        ws_link_after(ws, c, NULL);
+        mru_link_after(ws, c, ws->mru_last);
+    }
+    novawm_stack_insert(srv, c);
 
-    /* ensure window is mapped and we receive enter events */
+    /* we want enter events */
     uint32_t mask = XCB_EVENT_MASK_ENTER_WINDOW |
                     XCB_EVENT_MASK_FOCUS_CHANGE |
                     XCB_EVENT_MASK_PROPERTY_CHANGE;
     uint32_t val = mask;
-    xcb_change_window_attributes(
-        srv->conn,
+    srv->backend->set_attributes(
+        srv,
         win,
         XCB_CW_EVENT_MASK,
         &val
     );
-    xcb_map_window(srv->conn, win);
 
-    novawm_focus_client(srv, c);
+    return c;
 }
 
-void novawm_unmanage_window(struct novawm_server *srv, struct novawm_client *c) {
-    if (!c)
-        return;
-
+/* Unlink `c` from its workspace list, fixing up that workspace's focus. */
+void novawm_detach_client(struct novawm_server *srv, struct novawm_client *c) {
     int ws_idx = c->ws;
     if (ws_idx < 0 || ws_idx >= NOVAWM_WORKSPACES)
         ws_idx = srv->mon.current_ws;
 
     struct novawm_workspace *ws = &srv->mon.ws[ws_idx];
 
-    struct novawm_client **pp = &ws->clients;
-    while (*pp && *pp != c) {
-        pp = &(*pp)->next;
-    }
-    if (*pp == c) {
-        *pp = c->next;
+    ws_unlink(ws, c);
+    mru_unlink(ws, c);
+    novawm_bsp_remove(srv, ws, c);
+
+    /* a planned slot was on this workspace */
+    if (c->planned) {
+        c->planned = false;
+        c->grid_dirty = true;
     }
 
+    /* the window focused before it, without searching */
     if (ws->focused == c)
-        ws->focused = ws->clients;
+        ws->focused = ws->mru;
+    if (ws->fullscreen == c)
+        ws->fullscreen = NULL;
+}
 
-    free(c);
+void novawm_unmanage_window(struct novawm_server *srv, struct novawm_client *c) {
+    if (!c)
+        return;
+
+    if (c->scratch) {
+        bool had_focus = (srv->scratch_focused == c);
+        novawm_scratchpad_release(srv, c);
+        novawm_stack_remove(srv, c);
+        novawm_spatial_remove(srv, c);
+        novawm_sync_release(srv, c);
+        if (srv->drag.client == c) {
+            novawm_outline_hide(srv);
+            srv->drag.active = false;
+            srv->drag.client = NULL;
+        }
+        client_free(srv, c);
+
+        struct novawm_client *f = srv->mon.ws[srv->mon.current_ws].focused;
+        if (had_focus && f) {
+            novawm_set_focus(srv, f->win);
+            novawm_flush(srv);
+        }
+        return;
+    }
+
+    struct novawm_workspace *cur = &srv->mon.ws[srv->mon.current_ws];
+    bool had_focus = !srv->scratch_focused && cur->focused == c;
+    novawm_detach_client(srv, c);
+    novawm_stack_remove(srv, c);
+    novawm_spatial_remove(srv, c);
+    novawm_sync_release(srv, c);
+    if (srv->drag.client == c) {
+        novawm_outline_hide(srv);
+        srv->drag.active = false;
+        srv->drag.client = NULL;
+    }
+    client_free(srv, c);
 
     novawm_arrange(srv);
+
+    /* the window focused before it takes over; after the arrange, which
+     * maps it if monocle had it unmapped */
+    if (had_focus && cur->focused) {
+        novawm_set_focus(srv, cur->focused->win);
+        novawm_flush(srv);
+    }
 }
 
 void novawm_toggle_floating(struct novawm_server *srv) {
@@ -126,15 +456,107 @@ void novawm_toggle_floating(struct novawm_server *srv) {
         return;
 
     c->floating = !c->floating;
+    novawm_layout_invalidate(srv, c->ws);
+    novawm_stack_invalidate(srv);
+    novawm_arrange(srv);
+}
+
+/* Exchange the list positions of two clients on the same workspace (and
+ * their places, if both float). */
+void novawm_swap_clients(struct novawm_server *srv,
+                         struct novawm_client *a, struct novawm_client *b) {
+    if (!a || !b || a == b || a->ws != b->ws || a->ws < 0)
+        return;
+
+    struct novawm_workspace *ws = &srv->mon.ws[a->ws];
+
+    /* order them so that b never directly precedes a */
+    if (b->next == a) {
+        struct novawm_client *t = a;
+        a = b;
+        b = t;
+    }
+    if (a->next == b) {
+        ws_unlink(ws, a);
+        ws_link_after(ws, a, b);
+    } else {
+        struct novawm_client *pa = a->prev, *pb = b->prev;
+        ws_unlink(ws, a);
+        ws_unlink(ws, b);
+        ws_link_after(ws, b, pa);
+        ws_link_after(ws, a, pb);
+    }
+
+    novawm_bsp_swap(a, b);
+
+    if (a->floating && b->floating) {
+        int ax = a->x, ay = a->y;
+        novawm_client_configure(srv, a, b->x, b->y, a->w, a->h);
+        novawm_client_configure(srv, b, ax, ay, b->w, b->h);
+        novawm_spatial_update(srv, a);
+        novawm_spatial_update(srv, b);
+    }
+}
+
+static void fullscreen_leave(struct novawm_server *srv,
+                             struct novawm_client *c) {
+    c->fullscreen = false;
+    novawm_stack_invalidate(srv);
+    srv->backend->delete_property(
+        srv, c->win, srv->atoms[NOVAWM_ATOM_NET_WM_BYPASS_COMPOSITOR]);
+    novawm_ewmh_update_state(srv, c);
+
+    /* tiled clients are put back by arrange, floating ones by us */
+    if (c->floating)
+        novawm_client_configure(srv, c, c->saved_x, c->saved_y,
+                                c->saved_w, c->saved_h);
+}
+
+/* Fullscreen clients cover the whole monitor without border or gaps and
+ * ask compositors to unredirect them; arrange skips the rest of the
+ * workspace while one is active. */
+void novawm_set_fullscreen(struct novawm_server *srv,
+                           struct novawm_client *c, bool on) {
+    if (!c || c->scratch || c->fullscreen == on)
+        return;
+
+    struct novawm_workspace *ws = &srv->mon.ws[c->ws];
+
+    if (on) {
+        if (ws->fullscreen)
+            fullscreen_leave(srv, ws->fullscreen);
+
+        c->saved_x = c->x;
+        c->saved_y = c->y;
+        c->saved_w = c->w;
+        c->saved_h = c->h;
+        c->fullscreen = true;
+        ws->fullscreen = c;
+        novawm_stack_invalidate(srv);
+
+        uint32_t bypass = 1;
+        srv->backend->set_property(
+            srv, c->win, srv->atoms[NOVAWM_ATOM_NET_WM_BYPASS_COMPOSITOR],
+            XCB_ATOM_CARDINAL, 32, 1, &bypass);
+        novawm_ewmh_update_state(srv, c);
+    } else {
+        fullscreen_leave(srv, c);
+        ws->fullscreen = NULL;
+    }
+
     novawm_arrange(srv);
 }
 
 void novawm_kill_focused(struct novawm_server *srv) {
     struct novawm_workspace *ws = &srv->mon.ws[srv->mon.current_ws];
-    struct novawm_client *c = ws->focused;
+    struct novawm_client *c =
+        srv->scratch_focused ? srv->scratch_focused : ws->focused;
     if (!c)
         return;
 
-    xcb_kill_client(srv->conn, c->win);
-    xcb_flush(srv->conn);
+    /* the window is as good as gone: drop it now instead of configuring
+     * it until its DestroyNotify arrives */
+    srv->backend->kill(srv, c->win);
+    novawm_unmanage_window(srv, c);
+    novawm_flush(srv);
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "novawm.h"
+
+/* Wireframe for outline drags: four thin override-redirect windows forming
+ * the edges of the rectangle. Only these move while dragging; the client
+ * itself is configured once, on release. Without an X connection (the
+ * bench) nothing is drawn. */
+
+enum { EDGE_TOP, EDGE_BOTTOM, EDGE_LEFT, EDGE_RIGHT, EDGE_COUNT };
+
+static xcb_window_t edges[EDGE_COUNT];
+static bool         shown;
+
+static void outline_create(struct novawm_server *srv) {
+    uint32_t vals[2] = {
+        srv->cfg.border_color_active,
+        1, /* override-redirect */
+    };
+
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        edges[i] = xcb_generate_id(srv->conn);
+        xcb_create_window(srv->conn, XCB_COPY_FROM_PARENT, edges[i],
+                          srv->root, 0, 0, 1, 1, 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          srv->screen->root_visual,
+                          XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT,
+                          vals);
+    }
+}
+
+/* Outer rectangle of a client at x,y with inner size w,h. */
+void novawm_outline_show(struct novawm_server *srv,
+                         int x, int y, int w, int h) {
+    if (!srv->conn)
+        return;
+    if (!edges[0])
+        outline_create(srv);
+
+    int t = srv->cfg.border_width > 2 ? srv->cfg.border_width : 2;
+    int ow = w + 2 * srv->cfg.border_width;
+    int oh = h + 2 * srv->cfg.border_width;
+
+    int32_t r[EDGE_COUNT][4] = {
+        [EDGE_TOP]    = { x,          y,          ow, t  },
+        [EDGE_BOTTOM] = { x,          y + oh - t, ow, t  },
+        [EDGE_LEFT]   = { x,          y,          t,  oh },
+        [EDGE_RIGHT]  = { x + ow - t, y,          t,  oh },
+    };
+
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        uint32_t vals[5] = {
+            (uint32_t)r[i][0], (uint32_t)r[i][1],
+            (uint32_t)r[i][2], (uint32_t)r[i][3],
+            XCB_STACK_MODE_ABOVE,
+        };
+        /* restack only when it appears; nothing of ours goes above it
+         * during the drag */
+        xcb_configure_window(srv->conn, edges[i],
+                             XCB_CONFIG_WINDOW_X |
+                             XCB_CONFIG_WINDOW_Y |
+                             XCB_CONFIG_WINDOW_WIDTH |
+                             XCB_CONFIG_WINDOW_HEIGHT |
+                             (shown ? 0 : XCB_CONFIG_WINDOW_STACK_MODE),
+                             vals);
+        if (!shown)
+            xcb_map_window(srv->conn, edges[i]);
+    }
+    shown = true;
+}
+
+void novawm_outline_hide(struct novawm_server *srv) {
+    if (!shown)
+        return;
+    for (int i = 0; i < EDGE_COUNT; i++)
+        xcb_unmap_window(srv->conn, edges[i]);
+    shown = false;
+}
@@ -0,0 +1,362 @@
+#include "novawm.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Snapshot handed from the old process to the re-exec'd one, stored as a
+ * CARDINAL/32 property on the root window:
+ *
+ *   header:  magic, version, current_ws, master_factor (float bits),
+ *            client count, scratchpad count, focused window of each
+ *            workspace, layout of each workspace
+ *   clients: window, workspace, flags, x, y, w, h   (workspace list order;
+ *            scratchpad clients store their scratchpad index instead)
+ *   names:   one 32-byte name per scratchpad
+ *   trees:   per workspace, its bsp node count and then the nodes in
+ *            preorder, two words each: flags and the split's ratio (float
+ *            bits), or SNAP_BSP_LEAF and the leaf's window
+ */
+#define SNAP_MAGIC      0x4e4f5641u /* "NOVA" */
+#define SNAP_VERSION    4u
+#define SNAP_HDR        (6 + 2 * NOVAWM_WORKSPACES)
+#define SNAP_REC        7
+#define SNAP_NAME       (sizeof ((struct novawm_scratchpad *)0)->name / 4)
+#define SNAP_FLOATING   (1u << 0)
+#define SNAP_SCRATCHPAD (1u << 1)
+#define SNAP_VISIBLE    (1u << 2)
+#define SNAP_FULLSCREEN (1u << 3)
+#define SNAP_BSP_LEAF     (1u << 0)
+#define SNAP_BSP_VERTICAL (1u << 1)
+
+struct snap_index {
+    xcb_window_t          win;
+    int                   child;
+    struct novawm_client *client; /* once adopted */
+};
+
+static int snap_index_cmp(const void *a, const void *b) {
+    xcb_window_t wa = ((const struct snap_index *)a)->win;
+    xcb_window_t wb = ((const struct snap_index *)b)->win;
+    return (wa > wb) - (wa < wb);
+}
+
+static uint32_t tree_nodes(const struct novawm_bsp_node *n) {
+    if (!n)
+        return 0;
+    return 1 + tree_nodes(n->child[0]) + tree_nodes(n->child[1]);
+}
+
+static uint32_t *tree_save(const struct novawm_bsp_node *n, uint32_t *r) {
+    if (!n->child[0]) {
+        r[0] = SNAP_BSP_LEAF;
+        r[1] = n->client->win;
+        return r + 2;
+    }
+    r[0] = n->vertical ? SNAP_BSP_VERTICAL : 0;
+    memcpy(&r[1], &n->ratio, sizeof r[1]);
+    r = tree_save(n->child[0], r + 2);
+    return tree_save(n->child[1], r);
+}
+
+/* The node at v[*at] and its subtree, built from the adopted clients of
+ * workspace `ws`. NULL for leaves whose window did not come back, and
+ * for anything past the end of the snapshot or deeper than a tree of
+ * the pool's clients can be. */
+static struct novawm_bsp_node *tree_load(struct novawm_server *srv, int ws,
+                                         const uint32_t *v, uint32_t end,
+                                         uint32_t *at, int depth,
+                                         struct snap_index *index, int len) {
+    if (*at + 2 > end || depth > srv->cfg.client_pool)
+        return NULL;
+    uint32_t flags = v[*at], val = v[*at + 1];
+    *at += 2;
+
+    if (flags & SNAP_BSP_LEAF) {
+        struct snap_index key = { .win = val };
+        struct snap_index *hit =
+            bsearch(&key, index, (size_t)len, sizeof *index, snap_index_cmp);
+        struct novawm_client *c = hit ? hit->client : NULL;
+        if (!c || c->ws != ws || c->floating || c->leaf)
+            return NULL;
+        return novawm_bsp_leaf(srv, c);
+    }
+
+    struct novawm_bsp_node *a =
+        tree_load(srv, ws, v, end, at, depth + 1, index, len);
+    struct novawm_bsp_node *b =
+        tree_load(srv, ws, v, end, at, depth + 1, index, len);
+    float ratio;
+    memcpy(&ratio, &val, sizeof ratio);
+    return novawm_bsp_join(srv, a, b, flags & SNAP_BSP_VERTICAL, ratio);
+}
+
+static void snapshot_save(struct novawm_server *srv) {
+    uint32_t count = 0, nodes = 0;
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        for (struct novawm_client *c = srv->mon.ws[i].clients; c; c = c->next)
+            count++;
+        nodes += tree_nodes(srv->mon.ws[i].bsp);
+    }
+    for (int i = 0; i < srv->scratch_len; i++)
+        if (srv->scratch[i].client)
+            count++;
+
+    uint32_t len = SNAP_HDR + count * SNAP_REC +
+                   (uint32_t)srv->scratch_len * SNAP_NAME +
+                   NOVAWM_WORKSPACES + 2 * nodes;
+    uint32_t *buf = malloc(len * sizeof *buf);
+    if (!buf)
+        return;
+
+    uint32_t factor;
+    memcpy(&factor, &srv->cfg.master_factor, sizeof factor);
+
+    buf[0] = SNAP_MAGIC;
+    buf[1] = SNAP_VERSION;
+    buf[2] = (uint32_t)srv->mon.current_ws;
+    buf[3] = factor;
+    buf[4] = count;
+    buf[5] = (uint32_t)srv->scratch_len;
+
+    uint32_t *r = buf + SNAP_HDR;
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        struct novawm_workspace *ws = &srv->mon.ws[i];
+        buf[6 + i] = ws->focused ? ws->focused->win : XCB_NONE;
+        buf[6 + NOVAWM_WORKSPACES + i] = (uint32_t)ws->layout;
+
+        for (struct novawm_client *c = ws->clients; c; c = c->next) {
+            r[0] = c->win;
+            r[1] = (uint32_t)i;
+            r[2] = (c->floating ? SNAP_FLOATING : 0) |
+                   (c->fullscreen ? SNAP_FULLSCREEN : 0);
+            r[3] = (uint32_t)c->x;
+            r[4] = (uint32_t)c->y;
+            r[5] = (uint32_t)c->w;
+            r[6] = (uint32_t)c->h;
+            r += SNAP_REC;
+        }
+    }
+
+    for (int i = 0; i < srv->scratch_len; i++) {
+        struct novawm_scratchpad *sp = &srv->scratch[i];
+        if (!sp->client)
+            continue;
+        r[0] = sp->client->win;
+        r[1] = (uint32_t)i;
+        r[2] = SNAP_FLOATING | SNAP_SCRATCHPAD |
+               (sp->visible ? SNAP_VISIBLE : 0);
+        r[3] = (uint32_t)sp->client->x;
+        r[4] = (uint32_t)sp->client->y;
+        r[5] = (uint32_t)sp->client->w;
+        r[6] = (uint32_t)sp->client->h;
+        r += SNAP_REC;
+    }
+    for (int i = 0; i < srv->scratch_len; i++) {
+        memcpy(r, srv->scratch[i].name, SNAP_NAME * 4);
+        r += SNAP_NAME;
+    }
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        struct novawm_bsp_node *root = srv->mon.ws[i].bsp;
+        *r++ = tree_nodes(root);
+        if (root)
+            r = tree_save(root, r);
+    }
+
+    xcb_change_property(
+        srv->conn, XCB_PROP_MODE_REPLACE, srv->root,
+        srv->atoms[NOVAWM_ATOM_STATE], XCB_ATOM_CARDINAL, 32,
+        len, buf
+    );
+    free(buf);
+}
+
+void novawm_restart(struct novawm_server *srv) {
+    if (!srv->argv || !srv->argv[0])
+        return;
+
+    snapshot_save(srv);
+
+    /* Give up SubstructureRedirect ourselves and wait for the server to
+     * process it, so the new process cannot race our connection close. */
+    uint32_t none = XCB_EVENT_MASK_NO_EVENT;
+    xcb_change_window_attributes(srv->conn, srv->root,
+                                 XCB_CW_EVENT_MASK, &none);
+    free(NOVAWM_REPLY(srv, xcb_get_input_focus_reply(
+        srv->conn, xcb_get_input_focus(srv->conn), NULL)));
+
+    int fd = xcb_get_file_descriptor(srv->conn);
+    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+
+    novawm_boost_fini(srv);    /* the new process decides afresh */
+    setenv("NOVAWM_RESTART", "1", 1);
+    execvp(srv->argv[0], srv->argv);
+    perror("novawm: restart");
+
+    /* exec failed: keep running as we were */
+    unsetenv("NOVAWM_RESTART");
+    xcb_delete_property(srv->conn, srv->root, srv->atoms[NOVAWM_ATOM_STATE]);
+    uint32_t mask = NOVAWM_ROOT_EVENT_MASK;
+    xcb_change_window_attributes(srv->conn, srv->root,
+                                 XCB_CW_EVENT_MASK, &mask);
+    xcb_flush(srv->conn);
+}
+
+/* Re-adopt the windows listed in a snapshot left by novawm_restart().
+ * `map_state` holds the GetWindowAttributes map state of each child, or
+ * 0xff for windows that must not be managed; adopted ones are set to 0xff
+ * so the caller can pick up whatever is left. */
+bool novawm_restart_restore(struct novawm_server *srv,
+                            xcb_get_property_reply_t *snap,
+                            xcb_window_t *children, int len,
+                            uint8_t *map_state) {
+    if (!snap || snap->format != 32)
+        return false;
+
+    uint32_t n = (uint32_t)xcb_get_property_value_length(snap) / 4;
+    const uint32_t *v = xcb_get_property_value(snap);
+    if (n < SNAP_HDR || v[0] != SNAP_MAGIC || v[1] != SNAP_VERSION)
+        return false;
+
+    uint32_t count = v[4];
+    uint32_t pads = v[5];
+    if (pads > NOVAWM_MAX_SCRATCHPADS ||
+        pads * SNAP_NAME > n - SNAP_HDR ||
+        count > (n - SNAP_HDR - pads * SNAP_NAME) / SNAP_REC)
+        return false;
+    const uint32_t *names = v + SNAP_HDR + count * SNAP_REC;
+
+    int cur = (int)v[2];
+    if (cur < 0 || cur >= NOVAWM_WORKSPACES)
+        cur = 0;
+
+    struct snap_index *index = malloc((size_t)(len ? len : 1) * sizeof *index);
+    if (!index)
+        return false;
+    for (int i = 0; i < len; i++) {
+        index[i].win = children[i];
+        index[i].child = i;
+        index[i].client = NULL;
+    }
+    qsort(index, (size_t)len, sizeof *index, snap_index_cmp);
+
+    srv->mon.current_ws = cur;
+    memcpy(&srv->cfg.master_factor, &v[3], sizeof srv->cfg.master_factor);
+    if (!(srv->cfg.master_factor >= 0.05f && srv->cfg.master_factor <= 0.95f))
+        srv->cfg.master_factor = 0.5f;
+
+    /* attach inserts at the head, so walk backwards to keep list order */
+    for (uint32_t i = count; i-- > 0; ) {
+        const uint32_t *r = v + SNAP_HDR + i * SNAP_REC;
+
+        struct snap_index key = { .win = r[0] };
+        struct snap_index *hit =
+            bsearch(&key, index, (size_t)len, sizeof *index, snap_index_cmp);
+        if (!hit || map_state[hit->child] == 0xff)
+            continue;
+
+        bool viewable = map_state[hit->child] == XCB_MAP_STATE_VIEWABLE;
+
+        if (r[2] & SNAP_SCRATCHPAD) {
+            if (r[1] >= pads)
+                continue;
+            char name[SNAP_NAME * 4 + 1];
+            memcpy(name, names + r[1] * SNAP_NAME, SNAP_NAME * 4);
+            name[SNAP_NAME * 4] = '\0';
+
+            struct novawm_scratchpad *sp =
+                novawm_scratchpad_get(srv, name, true);
+            if (!sp || sp->client)
+                continue;
+
+            struct novawm_client *c = novawm_attach_client(srv, r[0], -1);
+            if (!c)
+                continue;
+            c->w = (int32_t)r[5];
+            c->h = (int32_t)r[6];
+            sp->show_on_map = (r[2] & SNAP_VISIBLE) != 0;
+            novawm_scratchpad_capture(srv, sp, c);
+            hit->client = c;
+            map_state[hit->child] = 0xff;
+            continue;
+        }
+
+        int ws = (int)r[1];
+        if (ws < 0 || ws >= NOVAWM_WORKSPACES)
+            ws = cur;
+
+        struct novawm_client *c = novawm_attach_client(srv, r[0], ws);
+        if (!c)
+            continue;
+
+        c->floating = (r[2] & SNAP_FLOATING) != 0;
+        c->x = (int32_t)r[3];
+        c->y = (int32_t)r[4];
+        c->w = (int32_t)r[5];
+        c->h = (int32_t)r[6];
+
+        if (r[2] & SNAP_FULLSCREEN) {
+            /* the window still carries its fullscreen hints */
+            struct novawm_workspace *w = &srv->mon.ws[ws];
+            if (w->fullscreen)
+                w->fullscreen->fullscreen = false;
+            c->fullscreen = true;
+            c->saved_x = c->x;
+            c->saved_y = c->y;
+            c->saved_w = c->w;
+            c->saved_h = c->h;
+            w->fullscreen = c;
+        }
+
+        /* arrange maps what the current workspace shows */
+        c->mapped = viewable;
+        if (ws != cur) {
+            novawm_client_set_mapped(srv, c, false);
+            novawm_client_set_hidden(srv, c, true);
+        }
+
+        hit->client = c;
+        map_state[hit->child] = 0xff;
+    }
+
+    /* the split trees as they were, so bsp workspaces get their old
+     * rectangles back instead of being split again in list order */
+    uint32_t at = SNAP_HDR + count * SNAP_REC + pads * SNAP_NAME;
+    for (int i = 0; i < NOVAWM_WORKSPACES && at < n; i++) {
+        uint32_t end = at + 1 + 2 * (v[at] < n ? v[at] : n);
+        if (end > n)
+            end = n;
+        at++;
+        srv->mon.ws[i].bsp = tree_load(srv, i, v, end, &at, 0, index, len);
+        at = end;
+    }
+
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        struct novawm_workspace *ws = &srv->mon.ws[i];
+        if (v[6 + NOVAWM_WORKSPACES + i] <= NOVAWM_LAYOUT_BSP)
+            ws->layout = (enum novawm_layout)v[6 + NOVAWM_WORKSPACES + i];
+        ws->focused = ws->clients;
+        for (struct novawm_client *c = ws->clients; c; c = c->next) {
+            if (c->win == v[6 + i]) {
+                ws->focused = c;
+                break;
+            }
+        }
+        if (ws->focused)
+            novawm_mru_touch(ws, ws->focused);
+    }
+
+    free(index);
+
+    /* geometry matches what the old process left, so this sends nothing
+     * but borders */
+    novawm_arrange(srv);
+
+    struct novawm_client *f = srv->mon.ws[cur].focused;
+    if (f) {
+        xcb_set_input_focus(srv->conn, XCB_INPUT_FOCUS_POINTER_ROOT,
+                            f->win, XCB_CURRENT_TIME);
+        xcb_flush(srv->conn);
+    }
+    return true;
+}
@@ -0,0 +1,325 @@
+#include "novawm.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+
+/* Window rules:
+ *
+ *   rule = class:firefox, workspace 2
+ *   rule = class:Pavucontrol type:dialog, float, size 800x600
+ *   rule = title:*YouTube*, float
+ *   rule = instance:~^(scratch|drop)term$, float
+ *   rule = instance:dropterm, scratchpad term
+ *
+ * The first field holds space-separated key:pattern matchers (class,
+ * instance, title, type); all given ones must match. The remaining
+ * fields are effects. Later rules override earlier ones. */
+
+static const char *const field_names[NOVAWM_RULE_FIELDS] = {
+    [NOVAWM_RULE_CLASS]    = "class",
+    [NOVAWM_RULE_INSTANCE] = "instance",
+    [NOVAWM_RULE_TITLE]    = "title",
+    [NOVAWM_RULE_TYPE]     = "type",
+};
+
+static uint32_t hash_str(const char *s) {
+    uint32_t h = 2166136261u; /* FNV-1a */
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    size_t n = strlen(s);
+    while (n && isspace((unsigned char)s[n-1])) s[--n] = '\0';
+    return s;
+}
+
+/* One glob element at `p` against character `c`: the pattern after it
+ * if it matches, else NULL. Brackets take ranges and a leading ! or ^. */
+static const char *glob_one(const char *p, char c) {
+    if (*p == '?')
+        return p + 1;
+    if (*p != '[')
+        return *p == c ? p + 1 : NULL;
+
+    p++;
+    bool neg = *p == '!' || *p == '^';
+    if (neg)
+        p++;
+    bool hit = false;
+    for (bool first = true; *p && (*p != ']' || first); first = false) {
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            hit |= c >= p[0] && c <= p[2];
+            p += 3;
+        } else {
+            hit |= c == *p++;
+        }
+    }
+    return *p && hit != neg ? p + 1 : NULL;
+}
+
+/* Shell glob against the whole of `s`. Unlike glibc's regexec this never
+ * allocates, so a MapRequest that only meets globs does not either. */
+static bool glob_match(const char *p, const char *s) {
+    const char *star = NULL, *resume = NULL;
+    while (*s) {
+        if (*p == '*') {
+            star = ++p;
+            resume = s;
+            continue;
+        }
+        const char *next = *p ? glob_one(p, *s) : NULL;
+        if (next) {
+            p = next;
+            s++;
+        } else if (star) {
+            p = star;
+            s = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*p == '*')
+        p++;
+    return !*p;
+}
+
+/* Every bracket is closed. */
+static bool glob_valid(const char *p) {
+    for (; *p; p++) {
+        if (*p != '[')
+            continue;
+        p++;
+        if (*p == '!' || *p == '^')
+            p++;
+        if (*p == ']')
+            p++;
+        while (*p && *p != ']')
+            p++;
+        if (!*p)
+            return false;
+    }
+    return true;
+}
+
+static bool compile_match(struct novawm_rule_match *m, const char *pat) {
+    if (pat[0] == '~') {
+        if (regcomp(&m->re, pat + 1, REG_EXTENDED | REG_NOSUB) != 0)
+            return false;
+        m->is_regex = true;
+    } else if (strpbrk(pat, "*?[")) {
+        if (!glob_valid(pat))
+            return false;
+        m->glob = strdup(pat);
+        if (!m->glob)
+            return false;
+    } else {
+        m->exact = strdup(pat);
+        if (!m->exact)
+            return false;
+    }
+
+    m->used = true;
+    return true;
+}
+
+static bool parse_effect(struct novawm_rule *r, char *eff) {
+    if (!strcasecmp(eff, "float") || !strcasecmp(eff, "floating")) {
+        r->floating = 1;
+        return true;
+    }
+    if (!strcasecmp(eff, "tile") || !strcasecmp(eff, "tiled")) {
+        r->floating = 0;
+        return true;
+    }
+    if (!strncasecmp(eff, "workspace", 9)) {
+        int ws = atoi(trim(eff + 9));
+        if (ws <= 0 || ws > NOVAWM_WORKSPACES)
+            return false;
+        r->workspace = ws - 1;
+        return true;
+    }
+    if (!strncasecmp(eff, "size", 4)) {
+        int w = 0, h = 0;
+        if (sscanf(trim(eff + 4), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+            return false;
+        r->w = w;
+        r->h = h;
+        return true;
+    }
+    if (!strncasecmp(eff, "scratchpad", 10)) {
+        const char *name = trim(eff + 10);
+        if (!*name)
+            return false;
+        snprintf(r->scratchpad, sizeof r->scratchpad, "%s", name);
+        return true;
+    }
+    return false;
+}
+
+static void rule_free(struct novawm_rule *r) {
+    for (int f = 0; f < NOVAWM_RULE_FIELDS; f++) {
+        struct novawm_rule_match *m = &r->match[f];
+        if (!m->used) continue;
+        if (m->is_regex) regfree(&m->re);
+        free(m->exact);
+        free(m->glob);
+    }
+}
+
+bool novawm_rules_add(struct novawm_rules *rules, char *spec) {
+    char *save = NULL;
+    char *matchers = strtok_r(spec, ",", &save);
+    if (!matchers)
+        return false;
+
+    struct novawm_rule r;
+    memset(&r, 0, sizeof r);
+    r.workspace = -1;
+    r.floating = -1;
+
+    bool ok = true;
+    bool any = false;
+    char *msave = NULL;
+    for (char *tok = strtok_r(matchers, " \t", &msave); tok && ok;
+         tok = strtok_r(NULL, " \t", &msave)) {
+        char *colon = strchr(tok, ':');
+        if (!colon) { ok = false; break; }
+        *colon = '\0';
+
+        int f;
+        for (f = 0; f < NOVAWM_RULE_FIELDS; f++)
+            if (!strcasecmp(tok, field_names[f]))
+                break;
+        if (f == NOVAWM_RULE_FIELDS || r.match[f].used ||
+            !compile_match(&r.match[f], colon + 1)) {
+            ok = false;
+            break;
+        }
+        any = true;
+    }
+
+    for (char *eff = strtok_r(NULL, ",", &save); eff && ok;
+         eff = strtok_r(NULL, ",", &save))
+        ok = parse_effect(&r, trim(eff));
+
+    if (!ok || !any) {
+        rule_free(&r);
+        return false;
+    }
+
+    if (rules->len == rules->cap) {
+        int cap = rules->cap ? rules->cap * 2 : 16;
+        struct novawm_rule *v = realloc(rules->v, (size_t)cap * sizeof *v);
+        if (!v) {
+            rule_free(&r);
+            return false;
+        }
+        rules->v = v;
+        rules->cap = cap;
+    }
+    rules->v[rules->len++] = r;
+    return true;
+}
+
+/* Build the class hash chains and the generic list. Rules are pushed in
+ * reverse so every chain stays in config order. */
+void novawm_rules_compile(struct novawm_rules *rules) {
+    memset(rules->buckets, 0, sizeof rules->buckets);
+    free(rules->generic);
+    rules->generic = NULL;
+    rules->generic_len = 0;
+
+    if (!rules->len)
+        return;
+
+    rules->generic = malloc((size_t)rules->len * sizeof *rules->generic);
+    if (!rules->generic) {
+        int lost = 0;
+        for (int i = 0; i < rules->len; i++) {
+            if (!rules->v[i].match[NOVAWM_RULE_CLASS].exact)
+                lost++;
+        }
+        if (lost)
+            fprintf(stderr, "novawm: out of memory compiling rules, %d "
+                    "without an exact class ignored\n", lost);
+    }
+
+    for (int i = rules->len - 1; i >= 0; i--) {
+        struct novawm_rule *r = &rules->v[i];
+        struct novawm_rule_match *m = &r->match[NOVAWM_RULE_CLASS];
+        if (m->exact) {
+            uint32_t b = hash_str(m->exact) % NOVAWM_RULE_BUCKETS;
+            r->next = rules->buckets[b];
+            rules->buckets[b] = i + 1;
+        }
+    }
+
+    for (int i = 0; i < rules->len && rules->generic; i++)
+        if (!rules->v[i].match[NOVAWM_RULE_CLASS].exact)
+            rules->generic[rules->generic_len++] = i;
+}
+
+static bool match_one(const struct novawm_rule_match *m, const char *val) {
+    if (!m->used)
+        return true;
+    if (m->is_regex)
+        return regexec(&m->re, val, 0, NULL, 0) == 0;
+    if (m->glob)
+        return glob_match(m->glob, val);
+    return !strcmp(m->exact, val);
+}
+
+static void apply_rule(const struct novawm_rule *r,
+                       const struct novawm_window_props *p,
+                       struct novawm_rule_result *out) {
+    if (!match_one(&r->match[NOVAWM_RULE_CLASS], p->wm_class) ||
+        !match_one(&r->match[NOVAWM_RULE_INSTANCE], p->instance) ||
+        !match_one(&r->match[NOVAWM_RULE_TITLE], p->title) ||
+        !match_one(&r->match[NOVAWM_RULE_TYPE], p->type))
+        return;
+
+    if (r->workspace >= 0) out->workspace = r->workspace;
+    if (r->floating >= 0)  out->floating = r->floating;
+    if (r->w > 0) {
+        out->w = r->w;
+        out->h = r->h;
+    }
+    if (r->scratchpad[0]) out->scratchpad = r->scratchpad;
+}
+
+/* Only the class bucket and the generic rules are visited; both lists are
+ * sorted by rule index, so merging them keeps config order. */
+void novawm_rules_match(const struct novawm_rules *rules,
+                        const struct novawm_window_props *props,
+                        struct novawm_rule_result *out) {
+    out->workspace = -1;
+    out->floating = -1;
+    out->w = out->h = 0;
+    out->scratchpad = NULL;
+
+    if (!rules->len)
+        return;
+
+    int b = rules->buckets[hash_str(props->wm_class) % NOVAWM_RULE_BUCKETS];
+    int g = 0;
+
+    while (b || g < rules->generic_len) {
+        int bi = b ? b - 1 : rules->len;
+        int gi = g < rules->generic_len ? rules->generic[g] : rules->len;
+
+        if (bi < gi) {
+            apply_rule(&rules->v[bi], props, out);
+            b = rules->v[bi].next;
+        } else {
+            apply_rule(&rules->v[gi], props, out);
+            g++;
+        }
+    }
+}
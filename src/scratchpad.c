@@ -0,0 +1,215 @@
+#include "novawm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Far enough left to be off every monitor; X coordinates are int16. */
+#define SCRATCH_PARK_X (-30000)
+
+/* A toggle this long after the spawn, with still no window captured,
+ * gives up on it and spawns again. */
+#define SCRATCH_SPAWN_TIMEOUT_MS 5000
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+struct novawm_scratchpad *novawm_scratchpad_get(struct novawm_server *srv,
+                                                const char *name,
+                                                bool create) {
+    if (!name || !*name)
+        return NULL;
+
+    for (int i = 0; i < srv->scratch_len; i++)
+        if (!strcmp(srv->scratch[i].name, name))
+            return &srv->scratch[i];
+
+    if (!create || srv->scratch_len >= NOVAWM_MAX_SCRATCHPADS)
+        return NULL;
+
+    struct novawm_scratchpad *sp = &srv->scratch[srv->scratch_len++];
+    memset(sp, 0, sizeof *sp);
+    snprintf(sp->name, sizeof sp->name, "%s", name);
+    return sp;
+}
+
+static void scratch_move(struct novawm_server *srv, struct novawm_client *c,
+                         int x, int y, bool raise) {
+    uint32_t vals[3] = { (uint32_t)x, (uint32_t)y, XCB_STACK_MODE_ABOVE };
+    uint16_t mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y;
+    if (raise)
+        mask |= XCB_CONFIG_WINDOW_STACK_MODE;
+
+    srv->backend->configure(srv, c->win, mask, vals);
+    srv->stats.configures++;
+    c->x = x;
+    c->y = y;
+}
+
+static void scratch_show(struct novawm_server *srv,
+                         struct novawm_scratchpad *sp) {
+    struct novawm_client *c = sp->client;
+
+    /* one configure moves it into view and raises it */
+    scratch_move(srv, c, sp->x, sp->y, true);
+    novawm_stack_mark_top(srv, c);
+    sp->visible = true;
+    novawm_client_set_hidden(srv, c, false);
+    novawm_spatial_update(srv, c);
+
+    uint32_t color = srv->cfg.border_color_active;
+    srv->backend->set_attributes(srv, c->win, XCB_CW_BORDER_PIXEL, &color);
+    c->border_color = color;
+    c->border_set = true;
+    novawm_set_focus(srv, c->win);
+    srv->scratch_focused = c;
+}
+
+static void scratch_hide(struct novawm_server *srv,
+                         struct novawm_scratchpad *sp) {
+    struct novawm_client *c = sp->client;
+
+    /* remember where the user left it */
+    sp->x = c->x;
+    sp->y = c->y;
+    scratch_move(srv, c, SCRATCH_PARK_X, sp->y, false);
+    sp->visible = false;
+    novawm_client_set_hidden(srv, c, true);
+    novawm_spatial_remove(srv, c);
+
+    if (srv->scratch_focused == c) {
+        srv->scratch_focused = NULL;
+        struct novawm_client *f = srv->mon.ws[srv->mon.current_ws].focused;
+        novawm_set_focus(srv, f ? f->win : srv->root);
+    }
+}
+
+/* Take ownership of an already detached client. The window stays mapped
+ * for its whole life; it is only ever moved in and out of view. */
+void novawm_scratchpad_capture(struct novawm_server *srv,
+                               struct novawm_scratchpad *sp,
+                               struct novawm_client *c) {
+    sp->client = c;
+    c->scratch = sp;
+    c->ws = -1;
+    c->floating = true;
+
+    if (c->w <= 0 || c->h <= 0) {
+        c->w = srv->mon.w / 2;
+        c->h = srv->mon.h / 2;
+        uint32_t size[2] = { (uint32_t)c->w, (uint32_t)c->h };
+        srv->backend->configure(srv, c->win,
+                                XCB_CONFIG_WINDOW_WIDTH |
+                                XCB_CONFIG_WINDOW_HEIGHT, size);
+    }
+    sp->x = srv->mon.x + (srv->mon.w - c->w) / 2;
+    sp->y = srv->mon.y + (srv->mon.h - c->h) / 4;
+
+    uint32_t bw = srv->cfg.border_width;
+    srv->backend->configure(srv, c->win, XCB_CONFIG_WINDOW_BORDER_WIDTH, &bw);
+    c->border_w = srv->cfg.border_width;
+
+    if (sp->show_on_map) {
+        sp->show_on_map = false;
+        scratch_show(srv, sp);
+    } else {
+        scratch_move(srv, c, SCRATCH_PARK_X, sp->y, false);
+        sp->visible = false;
+        novawm_client_set_hidden(srv, c, true);
+        novawm_spatial_remove(srv, c);
+    }
+
+    novawm_client_set_mapped(srv, c, true);
+    novawm_flush(srv);
+}
+
+void novawm_scratchpad_release(struct novawm_server *srv,
+                               struct novawm_client *c) {
+    struct novawm_scratchpad *sp = c->scratch;
+    if (!sp)
+        return;
+
+    sp->client = NULL;
+    sp->visible = false;
+    c->scratch = NULL;
+
+    if (srv->scratch_focused == c)
+        srv->scratch_focused = NULL;
+}
+
+/* "scratchpad, NAME [command]": show or hide NAME. If it has no window
+ * yet, run the command; a rule "scratchpad NAME" captures the window on
+ * its first map and shows it right away. Toggling again while that is
+ * pending does nothing, unless the command failed or its window has not
+ * shown up within SCRATCH_SPAWN_TIMEOUT_MS. */
+void novawm_scratchpad_toggle(struct novawm_server *srv, const char *arg) {
+    if (!arg)
+        return;
+
+    char name[32];
+    size_t n = 0;
+    while (arg[n] && !isspace((unsigned char)arg[n]) && n + 1 < sizeof name) {
+        name[n] = arg[n];
+        n++;
+    }
+    name[n] = '\0';
+
+    const char *cmd = arg + n;
+    while (isspace((unsigned char)*cmd))
+        cmd++;
+
+    struct novawm_scratchpad *sp = novawm_scratchpad_get(srv, name, true);
+    if (!sp)
+        return;
+
+    if (!sp->client) {
+        uint64_t now = now_ms();
+        if (sp->show_on_map &&
+            now - sp->spawned_ms >= SCRATCH_SPAWN_TIMEOUT_MS)
+            sp->show_on_map = false;    /* never mapped a window */
+        if (!sp->show_on_map && *cmd) {
+            pid_t pid = novawm_spawn(cmd);
+            if (pid > 0) {
+                sp->show_on_map = true;
+                sp->spawned_ms = now;
+                novawm_trace(srv, NOVAWM_TRACE_SPAWN, 0, (uint32_t)pid,
+                             NULL);
+            }
+        }
+        return;
+    }
+
+    if (sp->visible && srv->scratch_focused != sp->client) {
+        /* shown but behind focus: bring it forward instead of hiding */
+        scratch_show(srv, sp);
+    } else if (sp->visible) {
+        scratch_hide(srv, sp);
+    } else {
+        scratch_show(srv, sp);
+    }
+
+    novawm_flush(srv);
+}
+
+void novawm_scratchpad_move_focused(struct novawm_server *srv,
+                                    const char *name) {
+    struct novawm_workspace *ws = &srv->mon.ws[srv->mon.current_ws];
+    struct novawm_client *c = ws->focused;
+    if (!c)
+        return;
+
+    struct novawm_scratchpad *sp = novawm_scratchpad_get(srv, name, true);
+    if (!sp || sp->client)
+        return;
+
+    novawm_detach_client(srv, c);
+    novawm_scratchpad_capture(srv, sp, c);
+
+    if (ws->focused)
+        novawm_set_focus(srv, ws->focused->win);
+    novawm_arrange(srv);
+}
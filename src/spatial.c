@@ -0,0 +1,268 @@
+#include "novawm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/* Spatial index of the clients currently on screen, used for point
+ * queries (drops onto tiles) and directional focus. It is kept up to
+ * date incrementally: a client that moves is marked grid_dirty, arrange
+ * updates only those and the ones just shown, drags and scratchpad moves
+ * call novawm_spatial_update() themselves, and a client is only
+ * re-bucketed when the set of cells it covers changes. */
+
+static struct novawm_grid_cell *cell_at(struct novawm_spatial *g,
+                                        int cx, int cy) {
+    return &g->cells[cy * g->cols + cx];
+}
+
+static void cell_add(struct novawm_spatial *g, struct novawm_grid_cell *cell,
+                     struct novawm_client *c) {
+    if (cell->len == cell->cap) {
+        int cap = cell->cap * 2;
+        bool shared = cell->v >= g->store &&
+            cell->v < g->store + g->cols * g->rows * NOVAWM_GRID_PREALLOC;
+        struct novawm_client **v = shared
+            ? malloc((size_t)cap * sizeof *v)
+            : realloc(cell->v, (size_t)cap * sizeof *v);
+        if (!v)
+            return;
+        if (shared)
+            memcpy(v, cell->v, (size_t)cell->len * sizeof *v);
+        cell->v = v;
+        cell->cap = cap;
+    }
+    cell->v[cell->len++] = c;
+}
+
+static void cell_del(struct novawm_grid_cell *cell, struct novawm_client *c) {
+    for (int i = 0; i < cell->len; i++) {
+        if (cell->v[i] == c) {
+            cell->v[i] = cell->v[--cell->len];
+            return;
+        }
+    }
+}
+
+bool novawm_spatial_init(struct novawm_server *srv) {
+    struct novawm_spatial *g = &srv->mon.grid;
+    g->cols = (srv->mon.w + NOVAWM_GRID_CELL - 1) / NOVAWM_GRID_CELL;
+    g->rows = (srv->mon.h + NOVAWM_GRID_CELL - 1) / NOVAWM_GRID_CELL;
+    if (g->cols < 1) g->cols = 1;
+    if (g->rows < 1) g->rows = 1;
+    size_t n = (size_t)(g->cols * g->rows);
+    g->cells = calloc(n, sizeof *g->cells);
+    g->store = calloc(n * NOVAWM_GRID_PREALLOC, sizeof *g->store);
+    if (!g->cells || !g->store) {
+        free(g->cells);
+        free(g->store);
+        g->cells = NULL;
+        g->store = NULL;
+        return false;
+    }
+    /* small cells never touch the allocator after startup */
+    for (size_t i = 0; i < n; i++) {
+        g->cells[i].v = &g->store[i * NOVAWM_GRID_PREALLOC];
+        g->cells[i].cap = NOVAWM_GRID_PREALLOC;
+    }
+    return true;
+}
+
+static bool client_on_screen(struct novawm_server *srv,
+                             const struct novawm_client *c) {
+    if (c->scratch)
+        return c->scratch->visible;
+    struct novawm_box b = novawm_client_box(c);
+    return c->ws == srv->mon.current_ws && b.w > 0 && b.h > 0;
+}
+
+void novawm_spatial_remove(struct novawm_server *srv, struct novawm_client *c) {
+    struct novawm_spatial *g = &srv->mon.grid;
+    if (!c->indexed || !g->cells)
+        return;
+
+    for (int y = c->gy0; y <= c->gy1; y++)
+        for (int x = c->gx0; x <= c->gx1; x++)
+            cell_del(cell_at(g, x, y), c);
+    c->indexed = false;
+}
+
+void novawm_spatial_update(struct novawm_server *srv, struct novawm_client *c) {
+    struct novawm_spatial *g = &srv->mon.grid;
+    if (!g->cells)
+        return;
+    c->grid_dirty = false;
+    srv->stats.grid_updates++;
+
+    if (!client_on_screen(srv, c)) {
+        novawm_spatial_remove(srv, c);
+        return;
+    }
+
+    struct novawm_box b = novawm_client_box(c);
+    int bw2 = 2 * srv->cfg.border_width;
+    int x0 = (b.x - srv->mon.x) / NOVAWM_GRID_CELL;
+    int y0 = (b.y - srv->mon.y) / NOVAWM_GRID_CELL;
+    int x1 = (b.x + b.w + bw2 - 1 - srv->mon.x) / NOVAWM_GRID_CELL;
+    int y1 = (b.y + b.h + bw2 - 1 - srv->mon.y) / NOVAWM_GRID_CELL;
+
+    if (x1 < 0 || y1 < 0 || x0 >= g->cols || y0 >= g->rows ||
+        b.x + b.w + bw2 <= srv->mon.x || b.y + b.h + bw2 <= srv->mon.y) {
+        novawm_spatial_remove(srv, c);
+        return;
+    }
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= g->cols) x1 = g->cols - 1;
+    if (y1 >= g->rows) y1 = g->rows - 1;
+
+    if (c->indexed && c->gx0 == x0 && c->gy0 == y0 &&
+        c->gx1 == x1 && c->gy1 == y1)
+        return;
+
+    novawm_spatial_remove(srv, c);
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            cell_add(g, cell_at(g, x, y), c);
+
+    c->gx0 = x0;
+    c->gy0 = y0;
+    c->gx1 = x1;
+    c->gy1 = y1;
+    c->indexed = true;
+}
+
+static bool contains(struct novawm_server *srv,
+                     const struct novawm_client *c, int x, int y) {
+    struct novawm_box b = novawm_client_box(c);
+    int bw2 = 2 * srv->cfg.border_width;
+    return x >= b.x && y >= b.y &&
+           x < b.x + b.w + bw2 && y < b.y + b.h + bw2;
+}
+
+/* Is `a` stacked above `b`? Walks the stacking list from `b` upwards;
+ * only used to break ties between the few clients sharing a cell. */
+static bool stacked_above(const struct novawm_client *a,
+                          const struct novawm_client *b) {
+    for (const struct novawm_client *it = b->above; it; it = it->above)
+        if (it == a)
+            return true;
+    return false;
+}
+
+/* Topmost visible client under root coordinates (x, y). */
+struct novawm_client *novawm_spatial_at(struct novawm_server *srv,
+                                        int x, int y) {
+    struct novawm_spatial *g = &srv->mon.grid;
+    int cx = (x - srv->mon.x) / NOVAWM_GRID_CELL;
+    int cy = (y - srv->mon.y) / NOVAWM_GRID_CELL;
+    if (!g->cells || x < srv->mon.x || y < srv->mon.y ||
+        cx >= g->cols || cy >= g->rows)
+        return NULL;
+
+    struct novawm_grid_cell *cell = cell_at(g, cx, cy);
+    struct novawm_client *best = NULL;
+    for (int i = 0; i < cell->len; i++) {
+        struct novawm_client *c = cell->v[i];
+        if (contains(srv, c, x, y) && (!best || stacked_above(c, best)))
+            best = c;
+    }
+    return best;
+}
+
+/* Distance from `from` to `to` going in `dir`, or -1 if `to` is not in
+ * that direction. Gaps along the perpendicular axis count double so a
+ * window straight ahead beats a closer diagonal one. */
+static long dir_score(const struct novawm_box *from,
+                      const struct novawm_box *to, enum novawm_dir dir) {
+    long fcx = from->x + from->w / 2, fcy = from->y + from->h / 2;
+    long tcx = to->x + to->w / 2,     tcy = to->y + to->h / 2;
+    long gap, perp;
+
+    switch (dir) {
+    case NOVAWM_DIR_LEFT:
+        if (tcx >= fcx) return -1;
+        gap = from->x - (to->x + to->w);
+        break;
+    case NOVAWM_DIR_RIGHT:
+        if (tcx <= fcx) return -1;
+        gap = to->x - (from->x + from->w);
+        break;
+    case NOVAWM_DIR_UP:
+        if (tcy >= fcy) return -1;
+        gap = from->y - (to->y + to->h);
+        break;
+    default:
+        if (tcy <= fcy) return -1;
+        gap = to->y - (from->y + from->h);
+        break;
+    }
+    if (gap < 0)
+        gap = 0;
+
+    if (dir == NOVAWM_DIR_LEFT || dir == NOVAWM_DIR_RIGHT) {
+        perp = 0;
+        if (to->y + to->h <= from->y)      perp = from->y - (to->y + to->h);
+        else if (to->y >= from->y + from->h) perp = to->y - (from->y + from->h);
+    } else {
+        perp = 0;
+        if (to->x + to->w <= from->x)      perp = from->x - (to->x + to->w);
+        else if (to->x >= from->x + from->w) perp = to->x - (from->x + from->w);
+    }
+    return gap + 2 * perp;
+}
+
+/* Nearest visible client from `c` in `dir`. Scans the grid one band of
+ * cells at a time away from `c` and stops once a band can no longer beat
+ * the best score found. */
+struct novawm_client *novawm_spatial_neighbor(struct novawm_server *srv,
+                                              struct novawm_client *c,
+                                              enum novawm_dir dir) {
+    struct novawm_spatial *g = &srv->mon.grid;
+    if (!g->cells || !c)
+        return NULL;
+
+    bool horiz = (dir == NOVAWM_DIR_LEFT || dir == NOVAWM_DIR_RIGHT);
+    int step = (dir == NOVAWM_DIR_LEFT || dir == NOVAWM_DIR_UP) ? -1 : 1;
+    int bands = horiz ? g->cols : g->rows;
+    int across = horiz ? g->rows : g->cols;
+
+    struct novawm_box cb = novawm_client_box(c);
+    int start = horiz ? (cb.x + cb.w / 2 - srv->mon.x) / NOVAWM_GRID_CELL
+                      : (cb.y + cb.h / 2 - srv->mon.y) / NOVAWM_GRID_CELL;
+    if (start < 0) start = 0;
+    if (start >= bands) start = bands - 1;
+
+    struct novawm_client *best = NULL;
+    long best_score = LONG_MAX;
+
+    for (int b = start; b >= 0 && b < bands; b += step) {
+        /* anything first seen in this band is at least this far off */
+        long lo = (horiz ? srv->mon.x : srv->mon.y) + (long)b * NOVAWM_GRID_CELL;
+        long min_gap;
+        switch (dir) {
+        case NOVAWM_DIR_LEFT:  min_gap = cb.x - (lo + NOVAWM_GRID_CELL); break;
+        case NOVAWM_DIR_RIGHT: min_gap = lo - (cb.x + cb.w); break;
+        case NOVAWM_DIR_UP:    min_gap = cb.y - (lo + NOVAWM_GRID_CELL); break;
+        default:               min_gap = lo - (cb.y + cb.h); break;
+        }
+        if (best && min_gap > best_score)
+            break;
+
+        for (int a = 0; a < across; a++) {
+            struct novawm_grid_cell *cell =
+                horiz ? cell_at(g, b, a) : cell_at(g, a, b);
+            for (int i = 0; i < cell->len; i++) {
+                struct novawm_client *o = cell->v[i];
+                if (o == c)
+                    continue;
+                struct novawm_box ob = novawm_client_box(o);
+                long sc = dir_score(&cb, &ob, dir);
+                if (sc >= 0 && sc < best_score) {
+                    best = o;
+                    best_score = sc;
+                }
+            }
+        }
+    }
+    return best;
+}
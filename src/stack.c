@@ -0,0 +1,228 @@
+#include "novawm.h"
+#include <stdlib.h>
+
+/* NovaWM keeps its own copy of the server's stacking order for every
+ * managed window (srv->stack_bottom .. srv->stack_top). Handlers only
+ * flag raises; once per frame novawm_stack_commit() works out the order
+ * the visible windows should have (by layer, then raise order) and sends
+ * the fewest sibling-relative ConfigureWindow requests that produce it.
+ * Every request sent is mirrored into the list, so it stays exact.
+ *
+ * That order only changes when something is raised, inserted or changes
+ * layer, or when another set of windows becomes visible; all of those set
+ * srv->stack_dirty, and a frame without any (pointer motion, most focus
+ * steps) skips the walk. Removing a window never disorders the rest. */
+
+#define STACK_SLOTS_MIN 64
+
+struct novawm_stack_slot {
+    struct novawm_client *c;
+    int      pos;               /* index in current order */
+    uint32_t layer;
+    uint32_t order;             /* raise_seq if raised, else 0 */
+    int      tail, prev;        /* longest increasing subsequence */
+    bool     keep;
+};
+
+/* The commit's scratch array, sized with the client pool so that a
+ * warmed-up WM does not allocate for it. */
+bool novawm_stack_init(struct novawm_server *srv) {
+    int cap = srv->cfg.client_pool > STACK_SLOTS_MIN
+        ? srv->cfg.client_pool : STACK_SLOTS_MIN;
+    srv->stack_slots = calloc((size_t)cap, sizeof *srv->stack_slots);
+    if (!srv->stack_slots)
+        return false;
+    srv->stack_cap = cap;
+    srv->stack_dirty = true;
+    return true;
+}
+
+/* Layer or visibility changed somewhere: restack on the next commit. */
+void novawm_stack_invalidate(struct novawm_server *srv) {
+    srv->stack_dirty = true;
+}
+
+static void list_unlink(struct novawm_server *srv, struct novawm_client *c) {
+    if (c->below) c->below->above = c->above;
+    else          srv->stack_bottom = c->above;
+    if (c->above) c->above->below = c->below;
+    else          srv->stack_top = c->below;
+    c->below = c->above = NULL;
+}
+
+static void list_insert_above(struct novawm_server *srv,
+                              struct novawm_client *c,
+                              struct novawm_client *sib) {
+    c->below = sib;
+    c->above = sib ? sib->above : srv->stack_bottom;
+    if (c->above) c->above->below = c;
+    else          srv->stack_top = c;
+    if (sib) sib->above = c;
+    else     srv->stack_bottom = c;
+}
+
+/* New windows start out on top of their siblings. */
+void novawm_stack_insert(struct novawm_server *srv, struct novawm_client *c) {
+    list_insert_above(srv, c, srv->stack_top);
+    srv->stack_dirty = true;
+}
+
+void novawm_stack_remove(struct novawm_server *srv, struct novawm_client *c) {
+    list_unlink(srv, c);
+}
+
+void novawm_stack_raise(struct novawm_server *srv, struct novawm_client *c) {
+    c->raise_req = true;
+    c->raise_seq = ++srv->raise_seq;
+    srv->stack_dirty = true;
+}
+
+/* The caller already sent `c` to the very top (e.g. folded into another
+ * ConfigureWindow); record that without sending anything. */
+void novawm_stack_mark_top(struct novawm_server *srv,
+                           struct novawm_client *c) {
+    list_unlink(srv, c);
+    list_insert_above(srv, c, srv->stack_top);
+    srv->stack_dirty = true;
+}
+
+/* Reorder the list to match QueryTree's bottom-to-top child order. */
+void novawm_stack_sync(struct novawm_server *srv,
+                       const xcb_window_t *children, int len) {
+    struct novawm_client *prev = NULL;
+    for (int i = 0; i < len; i++) {
+        struct novawm_client *c = novawm_find_client(srv, children[i]);
+        if (!c)
+            continue;
+        list_unlink(srv, c);
+        list_insert_above(srv, c, prev);
+        prev = c;
+    }
+    srv->stack_dirty = true;
+}
+
+static enum novawm_layer client_layer(const struct novawm_client *c) {
+    if (c->scratch)    return NOVAWM_LAYER_SCRATCHPAD;
+    if (c->fullscreen) return NOVAWM_LAYER_FULLSCREEN;
+    if (c->floating)   return NOVAWM_LAYER_FLOATING;
+    return NOVAWM_LAYER_TILED;
+}
+
+static bool stack_visible(struct novawm_server *srv,
+                          const struct novawm_client *c) {
+    if (c->scratch)
+        return c->scratch->visible;
+    return c->ws == srv->mon.current_ws;
+}
+
+static int slot_cmp(const struct novawm_stack_slot *x,
+                    const struct novawm_stack_slot *y) {
+    if (x->layer != y->layer) return x->layer < y->layer ? -1 : 1;
+    if (x->order != y->order) return x->order < y->order ? -1 : 1;
+    return x->pos - y->pos;
+}
+
+/* Insertion sort: the slots start in current stacking order, so only the
+ * few raised or relayered clients move, and unlike glibc's qsort this
+ * never allocates. */
+static void sort_slots(struct novawm_stack_slot *slot, int n) {
+    for (int i = 1; i < n; i++) {
+        struct novawm_stack_slot s = slot[i];
+        int j = i;
+        while (j > 0 && slot_cmp(&slot[j - 1], &s) > 0) {
+            slot[j] = slot[j - 1];
+            j--;
+        }
+        slot[j] = s;
+    }
+}
+
+static void restack(struct novawm_server *srv, struct novawm_client *c,
+                    struct novawm_client *sib, uint32_t mode) {
+    uint32_t vals[2] = { sib->win, mode };
+    srv->backend->configure(srv, c->win,
+                            XCB_CONFIG_WINDOW_SIBLING |
+                            XCB_CONFIG_WINDOW_STACK_MODE, vals);
+    srv->stats.restacks++;
+
+    list_unlink(srv, c);
+    if (mode == XCB_STACK_MODE_ABOVE)
+        list_insert_above(srv, c, sib);
+    else
+        list_insert_above(srv, c, sib->below);
+}
+
+static void restack_visible(struct novawm_server *srv, int n) {
+    struct novawm_stack_slot *slot = srv->stack_slots;
+
+    int i = 0;
+    for (struct novawm_client *c = srv->stack_bottom; c; c = c->above) {
+        if (!stack_visible(srv, c))
+            continue;
+        slot[i].c = c;
+        slot[i].pos = i;
+        slot[i].layer = client_layer(c);
+        slot[i].order = c->raise_req ? c->raise_seq : 0;
+        slot[i].keep = false;
+        i++;
+    }
+
+    /* desired order, bottom to top */
+    sort_slots(slot, n);
+
+    /* Windows on the longest increasing run of current positions stay
+     * put; only the others are moved. */
+    int len = 0;
+    for (i = 0; i < n; i++) {
+        int lo = 0, hi = len;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (slot[slot[mid].tail].pos < slot[i].pos) lo = mid + 1;
+            else hi = mid;
+        }
+        slot[i].prev = lo ? slot[lo - 1].tail : -1;
+        slot[lo].tail = i;
+        if (lo == len) len++;
+    }
+    for (i = slot[len - 1].tail; i >= 0; i = slot[i].prev)
+        slot[i].keep = true;
+
+    int first = 0;
+    while (!slot[first].keep)
+        first++;
+
+    /* below the first kept window: stack each under its successor */
+    for (i = first - 1; i >= 0; i--)
+        restack(srv, slot[i].c, slot[i + 1].c, XCB_STACK_MODE_BELOW);
+    /* above it: stack each over its predecessor */
+    for (i = first + 1; i < n; i++)
+        if (!slot[i].keep)
+            restack(srv, slot[i].c, slot[i - 1].c, XCB_STACK_MODE_ABOVE);
+}
+
+void novawm_stack_commit(struct novawm_server *srv) {
+    if (srv->stack_dirty) {
+        int n = 0;
+        for (struct novawm_client *c = srv->stack_bottom; c; c = c->above)
+            if (stack_visible(srv, c))
+                n++;
+
+        if (n > srv->stack_cap) {
+            /* past the pool, like the clients themselves */
+            int cap = 2 * n;
+            struct novawm_stack_slot *slots =
+                realloc(srv->stack_slots, (size_t)cap * sizeof *slots);
+            if (slots) {
+                srv->stack_slots = slots;
+                srv->stack_cap = cap;
+            }
+        }
+        if (n > 1 && n <= srv->stack_cap)
+            restack_visible(srv, n);
+
+        for (struct novawm_client *c = srv->stack_bottom; c; c = c->above)
+            c->raise_req = false;
+        srv->stack_dirty = false;
+    }
+    novawm_flush(srv);
+}
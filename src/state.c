@@ -0,0 +1,167 @@
+#include "novawm.h"
+#include "novawm_state.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <linux/futex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Writer side of the shared state segment (see novawm_state.h). Each frame
+ * the state is rebuilt into a private copy; only when that differs from
+ * what readers have is it written under the seqlock and waiters woken, so
+ * pointer motion and other no-op frames cost readers nothing. */
+
+_Static_assert(NOVAWM_STATE_WORKSPACES == NOVAWM_WORKSPACES,
+               "state segment workspace count out of sync");
+
+static char shm_name[128];
+
+static void state_name(char *out, size_t outsz) {
+    const char *disp = getenv("DISPLAY");
+    snprintf(out, outsz, "%s-%u%s", NOVAWM_STATE_SHM_PREFIX,
+             (unsigned)geteuid(), disp && *disp ? disp : ":0");
+    /* only the leading slash is allowed */
+    for (char *p = out + 1; *p; p++)
+        if (*p == '/')
+            *p = '_';
+}
+
+void novawm_state_init(struct novawm_server *srv) {
+    if (!srv->cfg.state_shm)
+        return;
+
+    state_name(shm_name, sizeof shm_name);
+    int fd = shm_open(shm_name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("novawm: shm_open");
+        return;
+    }
+
+    /* /dev/shm is shared by every user: anyone may have created the name
+     * first and would then read, or feed readers, what we write */
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_uid != geteuid()) {
+        fprintf(stderr, "novawm: %s is not ours, state not published\n",
+                shm_name);
+        close(fd);
+        return;
+    }
+    if (st.st_mode & 022)
+        fchmod(fd, 0644);
+
+    struct novawm_state *seg = MAP_FAILED;
+    if (ftruncate(fd, sizeof *seg) == 0)
+        seg = mmap(NULL, sizeof *seg, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, 0);
+    close(fd);
+    srv->state_stage = calloc(1, sizeof *srv->state_stage);
+    if (seg == MAP_FAILED || !srv->state_stage) {
+        perror("novawm: state segment");
+        if (seg != MAP_FAILED)
+            munmap(seg, sizeof *seg);
+        free(srv->state_stage);
+        srv->state_stage = NULL;
+        return;
+    }
+
+    /* after a restart the old contents are still there; keep seq going
+     * up so readers waiting on it notice */
+    if (seg->magic != NOVAWM_STATE_MAGIC || (seg->seq & 1u))
+        seg->seq = 0;
+    seg->magic = NOVAWM_STATE_MAGIC;
+    seg->version = NOVAWM_STATE_VERSION;
+    seg->size = sizeof *seg;
+    srv->state = seg;
+}
+
+static void put_client(struct novawm_state *st, struct novawm_client *c,
+                       int ws, xcb_window_t focus) {
+    if (st->client_count >= NOVAWM_STATE_MAX_CLIENTS) {
+        st->truncated++;
+        return;
+    }
+
+    struct novawm_state_client *sc = &st->clients[st->client_count++];
+    sc->win = c->win;
+    sc->ws = (int16_t)ws;
+    sc->flags = (c->floating ? NOVAWM_STATE_FLOATING : 0) |
+                (c->fullscreen ? NOVAWM_STATE_FULLSCREEN : 0) |
+                (c->hidden || !c->mapped ? NOVAWM_STATE_HIDDEN : 0) |
+                (c->scratch ? NOVAWM_STATE_SCRATCHPAD : 0) |
+                (c->win == focus ? NOVAWM_STATE_FOCUSED : 0);
+    sc->x = c->x;
+    sc->y = c->y;
+    sc->w = c->w;
+    sc->h = c->h;
+}
+
+/* Bytes of the segment that carry data, from the mon fields on. */
+static size_t state_used(const struct novawm_state *st) {
+    return offsetof(struct novawm_state, clients) -
+           offsetof(struct novawm_state, mon_x) +
+           st->client_count * sizeof st->clients[0];
+}
+
+void novawm_state_publish(struct novawm_server *srv) {
+    struct novawm_state *seg = srv->state;
+    struct novawm_state *st = srv->state_stage;
+    if (!seg)
+        return;
+
+    xcb_window_t focus = XCB_NONE;
+    if (srv->scratch_focused)
+        focus = srv->scratch_focused->win;
+    else if (srv->mon.ws[srv->mon.current_ws].focused)
+        focus = srv->mon.ws[srv->mon.current_ws].focused->win;
+
+    st->mon_x = srv->mon.x;
+    st->mon_y = srv->mon.y;
+    st->mon_w = srv->mon.w;
+    st->mon_h = srv->mon.h;
+    st->current_ws = (uint32_t)srv->mon.current_ws;
+    st->focused = focus;
+    st->client_count = 0;
+    st->truncated = 0;
+
+    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
+        struct novawm_workspace *ws = &srv->mon.ws[i];
+        uint32_t before = st->client_count;
+        for (struct novawm_client *c = ws->clients; c; c = c->next)
+            put_client(st, c, i, focus);
+        st->ws[i].focused = ws->focused ? ws->focused->win : XCB_NONE;
+        st->ws[i].clients = (uint16_t)(st->client_count - before);
+        st->ws[i].layout = (uint8_t)ws->layout;
+        st->ws[i].pad = 0;
+    }
+    for (int i = 0; i < srv->scratch_len; i++)
+        if (srv->scratch[i].client)
+            put_client(st, srv->scratch[i].client, -1, focus);
+
+    /* client_count is part of the compared bytes */
+    if (!memcmp(&seg->mon_x, &st->mon_x, state_used(st)))
+        return;
+
+    /* seqlock write: odd while the data is inconsistent */
+    __atomic_store_n(&seg->seq, seg->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&seg->mon_x, &st->mon_x, state_used(st));
+    __atomic_store_n(&seg->seq, seg->seq + 1, __ATOMIC_RELEASE);
+
+    syscall(SYS_futex, &seg->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    srv->stats.state_publishes++;
+}
+
+void novawm_state_fini(struct novawm_server *srv) {
+    if (!srv->state)
+        return;
+    munmap(srv->state, sizeof *srv->state);
+    shm_unlink(shm_name);
+    free(srv->state_stage);
+    srv->state = NULL;
+    srv->state_stage = NULL;
+}
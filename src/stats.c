@@ -0,0 +1,146 @@
+#include "novawm.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* --- startup timing --- */
+
+static const char *const phase_names[NOVAWM_PHASE_COUNT] = {
+    [NOVAWM_PHASE_CONFIG]    = "config",
+    [NOVAWM_PHASE_CONNECT]   = "connect",
+    [NOVAWM_PHASE_INIT]      = "init",
+    [NOVAWM_PHASE_GRAB]      = "grab",
+    [NOVAWM_PHASE_AUTOSTART] = "autostart",
+    [NOVAWM_PHASE_SCAN]      = "scan",
+};
+
+uint64_t novawm_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/* Record the time since `since` as `phase`; returns now, the start of the
+ * next phase. */
+uint64_t novawm_startup_phase(struct novawm_server *srv,
+                              enum novawm_phase phase, uint64_t since) {
+    uint64_t now = novawm_now_us();
+    srv->startup.phase_us[phase] = now - since;
+    return now;
+}
+
+static void startup_line(struct novawm_server *srv, FILE *out) {
+    const struct novawm_startup *su = &srv->startup;
+
+    fprintf(out, "%.2f ms to event loop (",
+            (double)(su->ready_us - su->start_us) / 1000.0);
+    for (int i = 0; i < NOVAWM_PHASE_COUNT; i++)
+        fprintf(out, "%s%s %.2f", i ? ", " : "", phase_names[i],
+                (double)su->phase_us[i] / 1000.0);
+    fprintf(out, " ms)\n");
+}
+
+/* Called on entering the event loop. With NOVAWM_STARTUP_ONLY set the WM
+ * exits right there, so cold start can be measured by running it in a
+ * loop against a scratch X server. */
+void novawm_startup_ready(struct novawm_server *srv) {
+    if (srv->startup.ready_us)
+        return;
+    srv->startup.ready_us = novawm_now_us();
+    srv->startup.ready_allocs = novawm_alloc_count();
+    fprintf(stderr, "novawm: startup ");
+    startup_line(srv, stderr);
+
+    if (getenv("NOVAWM_STARTUP_ONLY"))
+        srv->running = false;
+}
+
+/* Resident set size from /proc, -1 if unavailable. */
+static long rss_kb(void) {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f)
+        return -1;
+    char line[128];
+    long kb = -1;
+    while (fgets(line, sizeof line, f))
+        if (sscanf(line, "VmRSS: %ld kB", &kb) == 1)
+            break;
+    fclose(f);
+    return kb;
+}
+
+void novawm_stats_dump(struct novawm_server *srv, FILE *out) {
+    const struct novawm_stats *st = &srv->stats;
+
+    fprintf(out, "novawm: stats\n");
+    fprintf(out, "  events       %" PRIu64 "\n", st->events);
+    fprintf(out, "  frames       %" PRIu64 "\n", st->frames);
+    fprintf(out, "  arranges     %" PRIu64 " (%" PRIu64 " from cached slots)\n",
+            st->arranges, st->layouts_cached);
+    fprintf(out, "  configures   %" PRIu64 " (%" PRIu64 " resizes)\n",
+            st->configures, st->resizes);
+    fprintf(out, "  grid         %" PRIu64 " updates\n", st->grid_updates);
+    fprintf(out, "  key_repeats  %" PRIu64 " (detectable: %s)\n",
+            st->key_repeats, srv->detectable_repeat ? "yes" : "no");
+    fprintf(out, "  coalesced    %" PRIu64 "\n", st->coalesced);
+    fprintf(out, "  focus        %" PRIu64 "\n", st->focus_changes);
+    fprintf(out, "  restacks     %" PRIu64 " (%.2f per focus change)\n",
+            st->restacks,
+            st->focus_changes
+                ? (double)st->restacks / (double)st->focus_changes : 0.0);
+    fprintf(out, "  maps         %" PRIu64 " / unmaps %" PRIu64 "\n",
+            st->maps, st->unmaps);
+    fprintf(out, "  sync         %" PRIu64 " requests, %" PRIu64
+            " deferred, %" PRIu64 " timeouts (%s)\n",
+            st->sync_requests, st->sync_deferred, st->sync_timeouts,
+            srv->have_sync ? "xsync" : "no xsync");
+    fprintf(out, "  drags        %" PRIu64 " (%.2f client configures each)\n",
+            st->drags,
+            st->drags ? (double)st->drag_configures / (double)st->drags : 0.0);
+    fprintf(out, "  state        %" PRIu64 " publishes (%s)\n",
+            st->state_publishes, srv->state ? "shm" : "off");
+    if (srv->boost.mode != NOVAWM_BOOST_OFF)
+        fprintf(out, "  boost        %" PRIu64 " changes, %" PRIu64
+                " deferred, %" PRIu64 " failures (%s)\n",
+                srv->boost.changes, srv->boost.deferred, srv->boost.failures,
+                srv->boost.mode == NOVAWM_BOOST_CGROUP ? "cgroup" : "nice");
+    if (srv->startup.ready_us) {
+        fprintf(out, "  startup      ");
+        startup_line(srv, out);
+    }
+#if defined(__GLIBC__) && defined(NOVAWM_COUNT_ALLOCS)
+    fprintf(out, "  allocs       %" PRIu64, novawm_alloc_count());
+    if (srv->startup.ready_us)
+        fprintf(out, " (%" PRIu64 " since the event loop started)",
+                novawm_alloc_count() - srv->startup.ready_allocs);
+#else
+    fprintf(out, "  allocs       not counted");
+#endif
+    fprintf(out, ", pool %d/%d clients, %" PRIu64 " past it",
+            srv->pool.used, srv->pool.size, srv->pool.overflow);
+    fprintf(out, ", %d/%d bsp nodes, %" PRIu64 " past it\n",
+            srv->bsp_pool.used, srv->bsp_pool.size, srv->bsp_pool.overflow);
+    if (srv->bar.h) {
+        const uint64_t *r = srv->bar.redraws;
+        fprintf(out, "  bar          %" PRIu64 " workspace, %" PRIu64
+                " layout, %" PRIu64 " title segment redraws, %" PRIu64
+                " exposes\n", r[NOVAWM_BAR_SEG_WORKSPACE],
+                r[NOVAWM_BAR_SEG_LAYOUT], r[NOVAWM_BAR_SEG_TITLE],
+                srv->bar.exposes);
+    }
+    fprintf(out, "  rss          %ld kB\n", rss_kb());
+    if (srv->trace.ring)
+        fprintf(out, "  trace        %" PRIu64 " records, last %d kept, "
+                "%d dumps\n", srv->trace.head, NOVAWM_TRACE_RECORDS,
+                srv->trace.dumps);
+    novawm_audit_dump(srv, out);
+    fprintf(out, "  errors       %" PRIu64 " (%" PRIu64 " dead clients dropped)\n",
+            st->errors, st->dead_unmanaged);
+    for (int i = 0; i < st->error_kinds; i++) {
+        const struct novawm_error_count *e = &st->error_counts[i];
+        fprintf(out, "    %-18s %-24s %" PRIu64 "\n",
+                novawm_error_name(e->code), novawm_request_name(e->major),
+                e->count);
+    }
+    fflush(out);
+}
@@ -0,0 +1,199 @@
+#include "novawm.h"
+#include <stdlib.h>
+#include <time.h>
+
+/* _NET_WM_SYNC_REQUEST: before a size change the client is sent a counter
+ * value, and it sets its XSync counter to that value once it has painted
+ * the new size. An alarm on the counter tells us when; until then newer
+ * geometry for that client is held back, so a slow painter sees at most
+ * one configure in flight. Clients without the protocol, and clients that
+ * do not answer within NOVAWM_SYNC_TIMEOUT_MS, are configured as before. */
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+void novawm_sync_init(struct novawm_server *srv) {
+    srv->have_sync = false;
+
+    const xcb_query_extension_reply_t *ext =
+        NOVAWM_REPLY(srv, xcb_get_extension_data(srv->conn, &xcb_sync_id));
+    if (!ext || !ext->present)
+        return;
+
+    xcb_sync_initialize_reply_t *r = NOVAWM_REPLY(srv,
+        xcb_sync_initialize_reply(
+            srv->conn,
+            xcb_sync_initialize(srv->conn, XCB_SYNC_MAJOR_VERSION,
+                                XCB_SYNC_MINOR_VERSION),
+            NULL));
+    if (r) {
+        srv->have_sync = true;
+        srv->sync_event_base = ext->first_event;
+    }
+    free(r);
+}
+
+/* Arm an alarm on the client's _NET_WM_SYNC_REQUEST_COUNTER, if it has
+ * one (see novawm_window_info.sync_counter). The counter need not start
+ * at 0: an earlier window manager, or we before a restart, may have
+ * advanced it. The new alarm fires at once with its value, and until
+ * that has arrived the client is configured without sync requests. */
+void novawm_sync_setup(struct novawm_server *srv, struct novawm_client *c,
+                       xcb_sync_counter_t counter) {
+    if (!srv->have_sync || c->sync_alarm || !counter)
+        return;
+
+    c->sync_counter = counter;
+    c->sync_alarm = srv->backend->alarm_create(srv, counter);
+}
+
+void novawm_sync_release(struct novawm_server *srv, struct novawm_client *c) {
+    if (c->sync_waiting)
+        srv->sync_waiting--;
+    c->sync_waiting = false;
+    c->sync_deferred = false;
+    c->sync_known = false;
+    if (c->sync_alarm)
+        srv->backend->alarm_destroy(srv, c->sync_alarm);
+    c->sync_alarm = XCB_NONE;
+    c->sync_counter = XCB_NONE;
+}
+
+/* Ask the client to report when it has painted; the configure must
+ * follow right after. */
+static void sync_request(struct novawm_server *srv, struct novawm_client *c) {
+    c->sync_value++;
+
+    xcb_client_message_event_t ev = {
+        .response_type = XCB_CLIENT_MESSAGE,
+        .format        = 32,
+        .window        = c->win,
+        .type          = srv->atoms[NOVAWM_ATOM_WM_PROTOCOLS],
+    };
+    ev.data.data32[0] = srv->atoms[NOVAWM_ATOM_NET_WM_SYNC_REQUEST];
+    ev.data.data32[1] = XCB_CURRENT_TIME;
+    ev.data.data32[2] = (uint32_t)c->sync_value;
+    ev.data.data32[3] = (uint32_t)(c->sync_value >> 32);
+    srv->backend->send_event(srv, c->win, XCB_EVENT_MASK_NO_EVENT, &ev);
+
+    srv->backend->alarm_set(srv, c->sync_alarm, c->sync_value);
+
+    c->sync_waiting = true;
+    c->sync_deadline = now_ms() + NOVAWM_SYNC_TIMEOUT_MS;
+    srv->sync_waiting++;
+    srv->stats.sync_requests++;
+}
+
+/* Move/resize a managed client, holding the request back while the client
+ * is still painting the previous size. */
+void novawm_client_configure(struct novawm_server *srv,
+                             struct novawm_client *c,
+                             int x, int y, int w, int h) {
+    if (c->sync_waiting) {
+        c->sync_deferred = true;
+        c->sync_x = x;
+        c->sync_y = y;
+        c->sync_w = w;
+        c->sync_h = h;
+        srv->stats.sync_deferred++;
+        return;
+    }
+    c->sync_deferred = false;
+
+    if (c->x == x && c->y == y && c->w == w && c->h == h)
+        return;
+
+    bool resize = c->w != w || c->h != h;
+
+    /* a move alone needs no repaint; unmapped windows may never paint */
+    if (c->sync_alarm && c->sync_known && c->mapped && resize)
+        sync_request(srv, c);
+
+    uint32_t geom[4] = { (uint32_t)x, (uint32_t)y, (uint32_t)w, (uint32_t)h };
+    srv->backend->configure(
+        srv,
+        c->win,
+        XCB_CONFIG_WINDOW_X |
+        XCB_CONFIG_WINDOW_Y |
+        XCB_CONFIG_WINDOW_WIDTH |
+        XCB_CONFIG_WINDOW_HEIGHT,
+        geom
+    );
+    srv->stats.configures++;
+    if (resize)
+        srv->stats.resizes++;
+
+    c->x = x;
+    c->y = y;
+    c->w = w;
+    c->h = h;
+    c->grid_dirty = true;
+}
+
+/* The client is done (or gave up): send whatever geometry piled up. */
+static void sync_done(struct novawm_server *srv, struct novawm_client *c) {
+    c->sync_waiting = false;
+    srv->sync_waiting--;
+
+    if (c->sync_deferred) {
+        novawm_client_configure(srv, c, c->sync_x, c->sync_y,
+                                c->sync_w, c->sync_h);
+        if (!c->hidden && c->mapped)
+            novawm_spatial_update(srv, c);
+    }
+}
+
+void novawm_sync_alarm_notify(struct novawm_server *srv,
+                              xcb_sync_alarm_notify_event_t *ev) {
+    for (struct novawm_client *c = srv->stack_bottom; c; c = c->above) {
+        if (c->sync_alarm != ev->alarm)
+            continue;
+
+        uint64_t v = ((uint64_t)(uint32_t)ev->counter_value.hi << 32) |
+                     ev->counter_value.lo;
+        if (!c->sync_known) {
+            /* the alarm's first firing: ask for values above this */
+            c->sync_known = true;
+            if (v > c->sync_value)
+                c->sync_value = v;
+            return;
+        }
+        if (c->sync_waiting && v >= c->sync_value) {
+            sync_done(srv, c);
+            srv->backend->flush(srv);
+        }
+        return;
+    }
+}
+
+/* poll() timeout until the nearest sync deadline, -1 if none pending */
+int novawm_sync_timeout(struct novawm_server *srv) {
+    if (!srv->sync_waiting)
+        return -1;
+
+    uint64_t now = now_ms(), next = UINT64_MAX;
+    for (struct novawm_client *c = srv->stack_bottom; c; c = c->above)
+        if (c->sync_waiting && c->sync_deadline < next)
+            next = c->sync_deadline;
+    return next <= now ? 0 : (int)(next - now);
+}
+
+void novawm_sync_expire(struct novawm_server *srv) {
+    if (!srv->sync_waiting)
+        return;
+
+    uint64_t now = now_ms();
+    bool sent = false;
+    for (struct novawm_client *c = srv->stack_bottom; c; c = c->above) {
+        if (c->sync_waiting && c->sync_deadline <= now) {
+            srv->stats.sync_timeouts++;
+            sync_done(srv, c);
+            sent = true;
+        }
+    }
+    if (sent)
+        srv->backend->flush(srv);
+}
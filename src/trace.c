@@ -0,0 +1,200 @@
+#include "novawm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Trace ring. Recording (novawm_trace() in novawm.h) is a clock read and
+ * five stores into a preallocated slot; names, scaling to time and JSON
+ * all happen here at dump time. The output is Chrome trace JSON, which
+ * chrome://tracing and ui.perfetto.dev both open directly. */
+
+static volatile sig_atomic_t dump_requested;
+
+static void on_sigusr1(int sig) {
+    (void)sig;
+    dump_requested = 1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void novawm_trace_init(struct novawm_server *srv) {
+    struct novawm_trace *t = &srv->trace;
+
+    t->ring = malloc(NOVAWM_TRACE_RECORDS * sizeof *t->ring);
+    if (!t->ring) {
+        perror("novawm: trace ring");
+        return;
+    }
+    /* fault the pages in now rather than on the first lap */
+    memset(t->ring, 0, NOVAWM_TRACE_RECORDS * sizeof *t->ring);
+    t->head = 0;
+    t->clock0 = novawm_trace_clock();
+    t->ns0 = now_ns();
+
+    /* no SA_RESTART: the signal should wake the event loop's poll() */
+    struct sigaction sa = { .sa_handler = on_sigusr1 };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+}
+
+void novawm_trace_poll(struct novawm_server *srv) {
+    if (!dump_requested)
+        return;
+    dump_requested = 0;
+    novawm_trace_dump(srv);
+}
+
+static const char *trace_name(struct novawm_server *srv,
+                              const struct novawm_trace_rec *r) {
+    switch ((enum novawm_trace_kind)r->kind) {
+    case NOVAWM_TRACE_EVENT:
+    case NOVAWM_TRACE_HANDLER_BEGIN:
+    case NOVAWM_TRACE_HANDLER_END:
+        return novawm_event_name(srv, r->sub);
+    case NOVAWM_TRACE_COMMIT_BEGIN:
+    case NOVAWM_TRACE_COMMIT_END:
+        return "commit";
+    case NOVAWM_TRACE_ARRANGE_BEGIN:
+    case NOVAWM_TRACE_ARRANGE_END:
+        return "arrange";
+    case NOVAWM_TRACE_REPLY_BEGIN:
+    case NOVAWM_TRACE_REPLY_END:
+        return "reply wait";
+    case NOVAWM_TRACE_IDLE_BEGIN:
+    case NOVAWM_TRACE_IDLE_END:
+        return "idle";
+    case NOVAWM_TRACE_FLUSH:
+        return "flush";
+    case NOVAWM_TRACE_SPAWN:
+        return "spawn";
+    }
+    return "?";
+}
+
+/* 'B', 'E' or 'i' (instant) */
+static char trace_phase(const struct novawm_trace_rec *r) {
+    switch ((enum novawm_trace_kind)r->kind) {
+    case NOVAWM_TRACE_HANDLER_BEGIN:
+    case NOVAWM_TRACE_COMMIT_BEGIN:
+    case NOVAWM_TRACE_ARRANGE_BEGIN:
+    case NOVAWM_TRACE_REPLY_BEGIN:
+    case NOVAWM_TRACE_IDLE_BEGIN:
+        return 'B';
+    case NOVAWM_TRACE_HANDLER_END:
+    case NOVAWM_TRACE_COMMIT_END:
+    case NOVAWM_TRACE_ARRANGE_END:
+    case NOVAWM_TRACE_REPLY_END:
+    case NOVAWM_TRACE_IDLE_END:
+        return 'E';
+    default:
+        return 'i';
+    }
+}
+
+/* Writes the ring, oldest record first, to
+ * $XDG_RUNTIME_DIR/novawm-trace-<pid>-<n>.json (or /tmp). The name is
+ * easy to guess, so the file is only ever created, never opened: in /tmp
+ * someone else could have put a symlink there. An existing file, as after
+ * a restart under the same pid, moves on to the next <n>. */
+bool novawm_trace_dump(struct novawm_server *srv) {
+    struct novawm_trace *t = &srv->trace;
+    if (!t->ring)
+        return false;
+
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    char path[512];
+    int fd;
+    for (int tries = 0; ; tries++) {
+        snprintf(path, sizeof path, "%s/novawm-trace-%d-%d.json",
+                 dir && *dir ? dir : "/tmp", (int)getpid(), t->dumps);
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+                  0600);
+        if (fd >= 0 || errno != EEXIST || tries == 100)
+            break;
+        t->dumps++;
+    }
+    FILE *out = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!out) {
+        perror(path);
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    /* ticks to ns, measured over the whole time the ring has existed */
+    uint64_t clock1 = novawm_trace_clock(), ns1 = now_ns();
+    double scale = clock1 > t->clock0
+        ? (double)(ns1 - t->ns0) / (double)(clock1 - t->clock0) : 1.0;
+
+    uint64_t end = t->head;
+    uint64_t start = end > NOVAWM_TRACE_RECORDS
+        ? end - NOVAWM_TRACE_RECORDS : 0;
+    int pid = (int)getpid();
+    int depth = 0;
+    const char *sep = "";
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (uint64_t i = start; i < end; i++) {
+        const struct novawm_trace_rec *r =
+            &t->ring[i & (NOVAWM_TRACE_RECORDS - 1)];
+        char ph = trace_phase(r);
+
+        /* the oldest records may end spans whose start was overwritten */
+        if (ph == 'E' && depth == 0)
+            continue;
+        depth += ph == 'B' ? 1 : ph == 'E' ? -1 : 0;
+
+        double us = ((double)t->ns0 +
+                     (double)(int64_t)(r->ts - t->clock0) * scale) / 1000.0;
+        fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                "\"pid\":%d,\"tid\":%d", sep, trace_name(srv, r), ph, us,
+                pid, pid);
+        if (ph == 'i')
+            fprintf(out, ",\"s\":\"t\"");
+
+        switch ((enum novawm_trace_kind)r->kind) {
+        case NOVAWM_TRACE_EVENT:
+        case NOVAWM_TRACE_HANDLER_BEGIN:
+            fprintf(out, ",\"args\":{\"type\":%u}", r->sub);
+            break;
+        case NOVAWM_TRACE_REPLY_BEGIN:
+            fprintf(out, ",\"args\":{\"site\":\"%s:%" PRIu32 "\"}",
+                    r->site ? r->site : "?", r->arg);
+            break;
+        case NOVAWM_TRACE_SPAWN:
+            fprintf(out, ",\"args\":{\"pid\":%" PRIu32 "}", r->arg);
+            break;
+        default:
+            break;
+        }
+        fputc('}', out);
+        sep = ",\n";
+    }
+    fprintf(out, "\n]}\n");
+
+    bool ok = !ferror(out);
+    if (fclose(out) != 0)
+        ok = false;
+    if (!ok) {
+        perror(path);
+        return false;
+    }
+
+    t->dumps++;
+    fprintf(stderr, "novawm: trace of %" PRIu64 " records written to %s\n",
+            end - start, path);
+    return true;
+}
+
+void novawm_trace_fini(struct novawm_server *srv) {
+    free(srv->trace.ring);
+    srv->trace.ring = NULL;
+}
@@ -3,13 +3,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-void novawm_spawn(const char *cmd) {
-    if (!cmd || !*cmd) return;
+/* Returns the child's pid, or -1 if nothing was started. */
+pid_t novawm_spawn(const char *cmd) {
+    if (!cmd || !*cmd) return -1;
 
     pid_t pid = fork();
     if (pid < 0) {
         perror("fork");
-        return;
+        return -1;
     }
 
     if (pid == 0) {
@@ -25,9 +26,11 @@ void novawm_spawn(const char *cmd) {
         unsetenv("DESKTOP_SESSION");
 
         setsid();
+        novawm_boost_enter_scope();
         execl("/bin/sh", "sh", "-c", cmd, NULL);
 
         perror("execl");
         _exit(1);
     }
+    return pid;
 }
\ No newline at end of file
@@ -2,10 +2,42 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <xcb/xkb.h>
 
 /* splash is local to this file – no field needed in novawm_server */
 static xcb_window_t novawm_splash = XCB_NONE;
 
+/* gethostname() at connect, to tell local clients' _NET_WM_PID apart */
+static char novawm_host[256];
+
+static const char *const novawm_atom_names[NOVAWM_ATOM_COUNT] = {
+    [NOVAWM_ATOM_STATE]                  = "_NOVAWM_STATE",
+    [NOVAWM_ATOM_UTF8_STRING]            = "UTF8_STRING",
+    [NOVAWM_ATOM_NET_WM_NAME]            = "_NET_WM_NAME",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE]     = "_NET_WM_WINDOW_TYPE",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_NORMAL]       = "_NET_WM_WINDOW_TYPE_NORMAL",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_DIALOG]       = "_NET_WM_WINDOW_TYPE_DIALOG",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_UTILITY]      = "_NET_WM_WINDOW_TYPE_UTILITY",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_TOOLBAR]      = "_NET_WM_WINDOW_TYPE_TOOLBAR",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_SPLASH]       = "_NET_WM_WINDOW_TYPE_SPLASH",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_MENU]         = "_NET_WM_WINDOW_TYPE_MENU",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_DOCK]         = "_NET_WM_WINDOW_TYPE_DOCK",
+    [NOVAWM_ATOM_NET_WM_WINDOW_TYPE_NOTIFICATION] = "_NET_WM_WINDOW_TYPE_NOTIFICATION",
+    [NOVAWM_ATOM_WM_STATE]               = "WM_STATE",
+    [NOVAWM_ATOM_NET_SUPPORTED]          = "_NET_SUPPORTED",
+    [NOVAWM_ATOM_NET_SUPPORTING_WM_CHECK] = "_NET_SUPPORTING_WM_CHECK",
+    [NOVAWM_ATOM_NET_WM_STATE]           = "_NET_WM_STATE",
+    [NOVAWM_ATOM_NET_WM_STATE_HIDDEN]    = "_NET_WM_STATE_HIDDEN",
+    [NOVAWM_ATOM_NET_WM_STATE_FULLSCREEN] = "_NET_WM_STATE_FULLSCREEN",
+    [NOVAWM_ATOM_NET_WM_BYPASS_COMPOSITOR] = "_NET_WM_BYPASS_COMPOSITOR",
+    [NOVAWM_ATOM_WM_PROTOCOLS]           = "WM_PROTOCOLS",
+    [NOVAWM_ATOM_NET_WM_SYNC_REQUEST]    = "_NET_WM_SYNC_REQUEST",
+    [NOVAWM_ATOM_NET_WM_SYNC_REQUEST_COUNTER] = "_NET_WM_SYNC_REQUEST_COUNTER",
+    [NOVAWM_ATOM_NET_WM_PID] = "_NET_WM_PID",
+};
+
 /* --- small helpers --- */
 
 static void
@@ -75,10 +107,490 @@ novawm_x11_draw_splash(struct novawm_server *srv) {
     xcb_flush(srv->conn);
 }
 
+/* Ask XKB for detectable autorepeat: held keys then produce a stream of
+ * KeyPress events without the fake KeyRelease in between, which lets the
+ * input code tell repeats from fresh presses. */
+static void
+novawm_x11_enable_detectable_repeat(struct novawm_server *srv) {
+    srv->detectable_repeat = false;
+
+    const xcb_query_extension_reply_t *ext =
+        NOVAWM_REPLY(srv, xcb_get_extension_data(srv->conn, &xcb_xkb_id));
+    if (!ext || !ext->present)
+        return;
+
+    xcb_xkb_use_extension_cookie_t uc =
+        xcb_xkb_use_extension(srv->conn, XCB_XKB_MAJOR_VERSION,
+                              XCB_XKB_MINOR_VERSION);
+    xcb_xkb_per_client_flags_cookie_t fc =
+        xcb_xkb_per_client_flags(
+            srv->conn, XCB_XKB_ID_USE_CORE_KBD,
+            XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT,
+            XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT,
+            0, 0, 0);
+
+    xcb_xkb_use_extension_reply_t *ur =
+        NOVAWM_REPLY(srv, xcb_xkb_use_extension_reply(srv->conn, uc, NULL));
+    xcb_xkb_per_client_flags_reply_t *fr =
+        NOVAWM_REPLY(srv, xcb_xkb_per_client_flags_reply(srv->conn, fc, NULL));
+
+    if (ur && ur->supported && fr &&
+        (fr->value & XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT))
+        srv->detectable_repeat = true;
+
+    free(ur);
+    free(fr);
+}
+
+/* --- property parsing --- */
+
+/* Copy a STRING/UTF8_STRING property into `out`, NUL-terminated. When
+ * `second` is set, copy the second NUL-separated part (WM_CLASS class). */
+static void prop_string(xcb_get_property_reply_t *r, char *out, size_t outsz,
+                        bool second) {
+    out[0] = '\0';
+    if (!r || r->format != 8)
+        return;
+
+    int len = xcb_get_property_value_length(r);
+    const char *v = xcb_get_property_value(r);
+
+    if (second) {
+        const char *nul = memchr(v, '\0', (size_t)len);
+        if (!nul)
+            return;
+        len -= (int)(nul + 1 - v);
+        v = nul + 1;
+    }
+
+    size_t n = strnlen(v, (size_t)len);
+    if (n >= outsz)
+        n = outsz - 1;
+    memcpy(out, v, n);
+    out[n] = '\0';
+}
+
+static const struct {
+    enum novawm_atom atom;
+    const char      *name;
+} window_types[] = {
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_NORMAL,       "normal" },
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_DIALOG,       "dialog" },
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_UTILITY,      "utility" },
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_TOOLBAR,      "toolbar" },
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_SPLASH,       "splash" },
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_MENU,         "menu" },
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_DOCK,         "dock" },
+    { NOVAWM_ATOM_NET_WM_WINDOW_TYPE_NOTIFICATION, "notification" },
+};
+
+/* First window type we know about, in the client's preference order. */
+static const char *prop_window_type(struct novawm_server *srv,
+                                    xcb_get_property_reply_t *r) {
+    if (!r || r->format != 32)
+        return "";
+
+    int n = xcb_get_property_value_length(r) / 4;
+    const xcb_atom_t *types = xcb_get_property_value(r);
+
+    for (int i = 0; i < n; i++)
+        for (size_t t = 0; t < sizeof window_types / sizeof *window_types; t++)
+            if (types[i] == srv->atoms[window_types[t].atom])
+                return window_types[t].name;
+    return "";
+}
+
+/* The counter from _NET_WM_SYNC_REQUEST_COUNTER, if WM_PROTOCOLS says
+ * the client speaks _NET_WM_SYNC_REQUEST; 0 otherwise. */
+static xcb_sync_counter_t
+prop_sync_counter(struct novawm_server *srv,
+                  xcb_get_property_reply_t *protocols,
+                  xcb_get_property_reply_t *counter) {
+    if (!protocols || protocols->format != 32 ||
+        !counter || counter->format != 32 ||
+        xcb_get_property_value_length(counter) < 4)
+        return XCB_NONE;
+
+    int n = xcb_get_property_value_length(protocols) / 4;
+    const xcb_atom_t *p = xcb_get_property_value(protocols);
+    for (int i = 0; i < n; i++)
+        if (p[i] == srv->atoms[NOVAWM_ATOM_NET_WM_SYNC_REQUEST])
+            return *(const uint32_t *)xcb_get_property_value(counter);
+    return XCB_NONE;
+}
+
+/* _NET_WM_PID, 0 if unset. A PID only means something on the host it
+ * came from, so it is dropped unless WM_CLIENT_MACHINE (`mr`) names ours;
+ * a remote client's PID could be any local process. */
+static pid_t prop_pid(xcb_get_property_reply_t *r,
+                      xcb_get_property_reply_t *mr) {
+    if (!r || r->format != 32 || xcb_get_property_value_length(r) < 4)
+        return 0;
+    if (!mr || mr->format != 8 || !novawm_host[0])
+        return 0;
+    size_t len = (size_t)xcb_get_property_value_length(mr);
+    if (len != strlen(novawm_host) ||
+        memcmp(xcb_get_property_value(mr), novawm_host, len))
+        return 0;
+    pid_t pid = (pid_t)*(const uint32_t *)xcb_get_property_value(r);
+    return pid > 0 ? pid : 0;
+}
+
+/* --- backend requests --- */
+
+/* Everything placement needs is requested up front, so managing a window
+ * costs a single round trip. */
+static bool
+x11_query_window(struct novawm_server *srv, xcb_window_t win,
+                 struct novawm_window_info *out) {
+    NOVAWM_AUDIT_QUERY(srv);
+    xcb_get_window_attributes_cookie_t ac =
+        xcb_get_window_attributes(srv->conn, win);
+    xcb_get_geometry_cookie_t gc = xcb_get_geometry(srv->conn, win);
+    xcb_get_property_cookie_t cc =
+        xcb_get_property(srv->conn, 0, win, XCB_ATOM_WM_CLASS,
+                         XCB_ATOM_STRING, 0, 64);
+    xcb_get_property_cookie_t nc =
+        xcb_get_property(srv->conn, 0, win, srv->atoms[NOVAWM_ATOM_NET_WM_NAME],
+                         srv->atoms[NOVAWM_ATOM_UTF8_STRING], 0, 64);
+    xcb_get_property_cookie_t oc =
+        xcb_get_property(srv->conn, 0, win, XCB_ATOM_WM_NAME,
+                         XCB_GET_PROPERTY_TYPE_ANY, 0, 64);
+    xcb_get_property_cookie_t tc =
+        xcb_get_property(srv->conn, 0, win,
+                         srv->atoms[NOVAWM_ATOM_NET_WM_WINDOW_TYPE],
+                         XCB_ATOM_ATOM, 0, 16);
+    xcb_get_property_cookie_t sc =
+        xcb_get_property(srv->conn, 0, win,
+                         srv->atoms[NOVAWM_ATOM_NET_WM_STATE],
+                         XCB_ATOM_ATOM, 0, 16);
+    xcb_get_property_cookie_t pc =
+        xcb_get_property(srv->conn, 0, win,
+                         srv->atoms[NOVAWM_ATOM_WM_PROTOCOLS],
+                         XCB_ATOM_ATOM, 0, 32);
+    xcb_get_property_cookie_t yc =
+        xcb_get_property(srv->conn, 0, win,
+                         srv->atoms[NOVAWM_ATOM_NET_WM_SYNC_REQUEST_COUNTER],
+                         XCB_ATOM_CARDINAL, 0, 1);
+    xcb_get_property_cookie_t hc =
+        xcb_get_property(srv->conn, 0, win, XCB_ATOM_WM_NORMAL_HINTS,
+                         XCB_ATOM_WM_SIZE_HINTS, 0, 18);
+    xcb_get_property_cookie_t ic =
+        xcb_get_property(srv->conn, 0, win, srv->atoms[NOVAWM_ATOM_NET_WM_PID],
+                         XCB_ATOM_CARDINAL, 0, 1);
+    xcb_get_property_cookie_t mc =
+        xcb_get_property(srv->conn, 0, win, XCB_ATOM_WM_CLIENT_MACHINE,
+                         XCB_ATOM_STRING, 0, 64);
+
+    xcb_get_window_attributes_reply_t *ar =
+        NOVAWM_REPLY(srv, xcb_get_window_attributes_reply(srv->conn, ac, NULL));
+    xcb_get_geometry_reply_t *gr =
+        NOVAWM_REPLY(srv, xcb_get_geometry_reply(srv->conn, gc, NULL));
+    xcb_get_property_reply_t *cr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, cc, NULL));
+    xcb_get_property_reply_t *nr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, nc, NULL));
+    xcb_get_property_reply_t *wr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, oc, NULL));
+    xcb_get_property_reply_t *tr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, tc, NULL));
+    xcb_get_property_reply_t *sr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, sc, NULL));
+    xcb_get_property_reply_t *pr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, pc, NULL));
+    xcb_get_property_reply_t *yr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, yc, NULL));
+    xcb_get_property_reply_t *hr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, hc, NULL));
+    xcb_get_property_reply_t *ir =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, ic, NULL));
+    xcb_get_property_reply_t *mr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, mc, NULL));
+
+    memset(out, 0, sizeof *out);
+    out->override_redirect = ar && ar->override_redirect;
+    if (gr) {
+        out->x = gr->x;
+        out->y = gr->y;
+        out->w = gr->width;
+        out->h = gr->height;
+    }
+
+    struct novawm_window_props *props = &out->props;
+    prop_string(cr, props->instance, sizeof props->instance, false);
+    prop_string(cr, props->wm_class, sizeof props->wm_class, true);
+    prop_string(nr, props->title, sizeof props->title, false);
+    if (!props->title[0])
+        prop_string(wr, props->title, sizeof props->title, false);
+    props->type = prop_window_type(srv, tr);
+
+    if (sr && sr->format == 32) {
+        int n = xcb_get_property_value_length(sr) / 4;
+        const xcb_atom_t *st = xcb_get_property_value(sr);
+        for (int i = 0; i < n; i++)
+            if (st[i] == srv->atoms[NOVAWM_ATOM_NET_WM_STATE_FULLSCREEN])
+                out->fullscreen = true;
+    }
+
+    out->sync_counter = prop_sync_counter(srv, pr, yr);
+    out->pid = prop_pid(ir, mr);
+    novawm_size_hints_update(&out->hints, hr);
+
+    bool alive = ar != NULL;
+    free(ar);
+    free(gr);
+    free(cr);
+    free(nr);
+    free(wr);
+    free(tr);
+    free(sr);
+    free(pr);
+    free(yr);
+    free(hr);
+    free(ir);
+    free(mr);
+    return alive;
+}
+
+static bool
+x11_size_hints(struct novawm_server *srv, xcb_window_t win,
+               struct novawm_size_hints *out) {
+    NOVAWM_AUDIT_QUERY(srv);
+    xcb_get_property_reply_t *r = NOVAWM_REPLY(srv,
+        xcb_get_property_reply(
+            srv->conn,
+            xcb_get_property(srv->conn, 0, win,
+                             XCB_ATOM_WM_NORMAL_HINTS,
+                             XCB_ATOM_WM_SIZE_HINTS, 0, 18),
+            NULL));
+    novawm_size_hints_update(out, r);
+    free(r);
+    return r != NULL;
+}
+
+static bool
+x11_title(struct novawm_server *srv, xcb_window_t win, char *out,
+          size_t outsz) {
+    NOVAWM_AUDIT_QUERY(srv);
+    xcb_get_property_cookie_t nc =
+        xcb_get_property(srv->conn, 0, win, srv->atoms[NOVAWM_ATOM_NET_WM_NAME],
+                         srv->atoms[NOVAWM_ATOM_UTF8_STRING], 0, 64);
+    xcb_get_property_cookie_t oc =
+        xcb_get_property(srv->conn, 0, win, XCB_ATOM_WM_NAME,
+                         XCB_GET_PROPERTY_TYPE_ANY, 0, 64);
+    xcb_get_property_reply_t *nr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, nc, NULL));
+    xcb_get_property_reply_t *wr =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, oc, NULL));
+
+    prop_string(nr, out, outsz, false);
+    if (!out[0])
+        prop_string(wr, out, outsz, false);
+    bool alive = nr || wr;
+    free(nr);
+    free(wr);
+    return alive;
+}
+
+static void
+x11_configure(struct novawm_server *srv, xcb_window_t win,
+              uint16_t mask, const uint32_t *values) {
+    xcb_configure_window(srv->conn, win, mask, values);
+}
+
+static void
+x11_map(struct novawm_server *srv, xcb_window_t win) {
+    xcb_map_window(srv->conn, win);
+}
+
+static void
+x11_unmap(struct novawm_server *srv, xcb_window_t win) {
+    xcb_unmap_window(srv->conn, win);
+}
+
+static void
+x11_set_attributes(struct novawm_server *srv, xcb_window_t win,
+                   uint32_t mask, const uint32_t *values) {
+    xcb_change_window_attributes(srv->conn, win, mask, values);
+}
+
+static void
+x11_focus(struct novawm_server *srv, xcb_window_t win) {
+    xcb_set_input_focus(srv->conn, XCB_INPUT_FOCUS_POINTER_ROOT, win,
+                        XCB_CURRENT_TIME);
+}
+
+static void
+x11_grab_key(struct novawm_server *srv, uint16_t mods, xcb_keycode_t key) {
+    xcb_grab_key(srv->conn, 1, srv->root, mods, key,
+                 XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+}
+
+static void
+x11_ungrab_keys(struct novawm_server *srv) {
+    xcb_ungrab_key(srv->conn, XCB_GRAB_ANY, srv->root, XCB_MOD_MASK_ANY);
+}
+
+static void
+x11_set_property(struct novawm_server *srv, xcb_window_t win,
+                 xcb_atom_t prop, xcb_atom_t type, uint8_t format,
+                 uint32_t len, const void *data) {
+    xcb_change_property(srv->conn, XCB_PROP_MODE_REPLACE, win, prop, type,
+                        format, len, data);
+}
+
+static void
+x11_delete_property(struct novawm_server *srv, xcb_window_t win,
+                    xcb_atom_t prop) {
+    xcb_delete_property(srv->conn, win, prop);
+}
+
+static void
+x11_send_event(struct novawm_server *srv, xcb_window_t win, uint32_t mask,
+               const void *ev) {
+    xcb_send_event(srv->conn, 0, win, mask, ev);
+}
+
+static void
+x11_kill(struct novawm_server *srv, xcb_window_t win) {
+    xcb_kill_client(srv->conn, win);
+}
+
+static xcb_sync_int64_t sync_int64(uint64_t v) {
+    xcb_sync_int64_t r = {
+        .hi = (int32_t)(v >> 32),
+        .lo = (uint32_t)v,
+    };
+    return r;
+}
+
+static xcb_sync_alarm_t
+x11_alarm_create(struct novawm_server *srv, xcb_sync_counter_t counter) {
+    /* re-armed by every ChangeAlarm */
+    xcb_sync_create_alarm_value_list_t vl = {
+        .counter   = counter,
+        .valueType = XCB_SYNC_VALUETYPE_ABSOLUTE,
+        .value     = sync_int64(0),
+        .testType  = XCB_SYNC_TESTTYPE_POSITIVE_COMPARISON,
+        .events    = 1,
+    };
+    xcb_sync_alarm_t alarm = xcb_generate_id(srv->conn);
+    xcb_sync_create_alarm_aux(srv->conn, alarm,
+                              XCB_SYNC_CA_COUNTER |
+                              XCB_SYNC_CA_VALUE_TYPE |
+                              XCB_SYNC_CA_VALUE |
+                              XCB_SYNC_CA_TEST_TYPE |
+                              XCB_SYNC_CA_EVENTS,
+                              &vl);
+    return alarm;
+}
+
+static void
+x11_alarm_set(struct novawm_server *srv, xcb_sync_alarm_t alarm,
+              uint64_t value) {
+    xcb_sync_change_alarm_value_list_t vl = {
+        .value = sync_int64(value),
+    };
+    xcb_sync_change_alarm_aux(srv->conn, alarm, XCB_SYNC_CA_VALUE, &vl);
+}
+
+static void
+x11_alarm_destroy(struct novawm_server *srv, xcb_sync_alarm_t alarm) {
+    xcb_sync_destroy_alarm(srv->conn, alarm);
+}
+
+static void
+x11_flush(struct novawm_server *srv) {
+    xcb_flush(srv->conn);
+    novawm_trace(srv, NOVAWM_TRACE_FLUSH, 0, 0, NULL);
+}
+
+const struct novawm_backend novawm_backend_x11 = {
+    .name            = "x11",
+    .query_window    = x11_query_window,
+    .size_hints      = x11_size_hints,
+    .title           = x11_title,
+    .configure       = x11_configure,
+    .map             = x11_map,
+    .unmap           = x11_unmap,
+    .set_attributes  = x11_set_attributes,
+    .focus           = x11_focus,
+    .grab_key        = x11_grab_key,
+    .ungrab_keys     = x11_ungrab_keys,
+    .set_property    = x11_set_property,
+    .delete_property = x11_delete_property,
+    .send_event      = x11_send_event,
+    .kill            = x11_kill,
+    .alarm_create    = x11_alarm_create,
+    .alarm_set       = x11_alarm_set,
+    .alarm_destroy   = x11_alarm_destroy,
+    .flush           = x11_flush,
+};
+
+/* Clients adopted at startup never went through manage; fetch what
+ * manage would have for all of them in one round trip. */
+static void
+probe_clients(struct novawm_server *srv) {
+    int n = 0;
+    for (struct novawm_client *c = srv->stack_bottom; c; c = c->above)
+        n++;
+    if (!n)
+        return;
+
+    xcb_get_property_cookie_t pc[n], yc[n], hc[n], ic[n], mc[n];
+    int i = 0;
+    for (struct novawm_client *c = srv->stack_bottom; c; c = c->above, i++) {
+        pc[i] = xcb_get_property(srv->conn, 0, c->win,
+                                 srv->atoms[NOVAWM_ATOM_WM_PROTOCOLS],
+                                 XCB_ATOM_ATOM, 0, 32);
+        yc[i] = xcb_get_property(srv->conn, 0, c->win,
+                                 srv->atoms[NOVAWM_ATOM_NET_WM_SYNC_REQUEST_COUNTER],
+                                 XCB_ATOM_CARDINAL, 0, 1);
+        hc[i] = xcb_get_property(srv->conn, 0, c->win,
+                                 XCB_ATOM_WM_NORMAL_HINTS,
+                                 XCB_ATOM_WM_SIZE_HINTS, 0, 18);
+        ic[i] = xcb_get_property(srv->conn, 0, c->win,
+                                 srv->atoms[NOVAWM_ATOM_NET_WM_PID],
+                                 XCB_ATOM_CARDINAL, 0, 1);
+        mc[i] = xcb_get_property(srv->conn, 0, c->win,
+                                 XCB_ATOM_WM_CLIENT_MACHINE,
+                                 XCB_ATOM_STRING, 0, 64);
+    }
+
+    i = 0;
+    for (struct novawm_client *c = srv->stack_bottom; c; c = c->above, i++) {
+        xcb_get_property_reply_t *pr =
+            NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, pc[i], NULL));
+        xcb_get_property_reply_t *yr =
+            NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, yc[i], NULL));
+        xcb_get_property_reply_t *hr =
+            NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, hc[i], NULL));
+        xcb_get_property_reply_t *ir =
+            NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, ic[i], NULL));
+        xcb_get_property_reply_t *mr =
+            NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, mc[i], NULL));
+        novawm_sync_setup(srv, c, prop_sync_counter(srv, pr, yr));
+        novawm_size_hints_update(&c->hints, hr);
+        novawm_layout_invalidate(srv, c->ws);
+        c->pid = prop_pid(ir, mr);
+        free(pr);
+        free(yr);
+        free(hr);
+        free(ir);
+        free(mr);
+    }
+}
+
 /* --- public X11 backend --- */
 
+/* Connect and claim the root window. Needs nothing from the config, so
+ * main() parses it on another thread meanwhile. Every request that does
+ * not depend on an answer goes out before the first reply is awaited:
+ * the atoms, the keyboard mapping (xcb_key_symbols_alloc only sends the
+ * request) and the XKB/XSync extension queries all share the round trip
+ * of the SubstructureRedirect check. */
 bool
-novawm_x11_init(struct novawm_server *srv) {
+novawm_x11_connect(struct novawm_server *srv) {
     int screen_num = 0;
 
     const char *disp = getenv("DISPLAY");
@@ -87,11 +599,15 @@ novawm_x11_init(struct novawm_server *srv) {
 
     fprintf(stderr, "novawm: connecting to DISPLAY=\"%s\"\n", disp);
 
+    srv->backend = &novawm_backend_x11;
     srv->conn = xcb_connect(disp, &screen_num);
     if (xcb_connection_has_error(srv->conn)) {
         fprintf(stderr, "novawm: cannot connect to X on %s\n", disp);
         return false;
     }
+    if (gethostname(novawm_host, sizeof novawm_host) != 0)
+        novawm_host[0] = '\0';
+    novawm_host[sizeof novawm_host - 1] = '\0';
 
     const xcb_setup_t *setup = xcb_get_setup(srv->conn);
     xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
@@ -102,25 +618,31 @@ novawm_x11_init(struct novawm_server *srv) {
     srv->screen = it.data;
     srv->root   = srv->screen->root;
 
+    /* Intern atoms now; replies are collected after the redirect check */
+    xcb_intern_atom_cookie_t atom_ck[NOVAWM_ATOM_COUNT];
+    for (int i = 0; i < NOVAWM_ATOM_COUNT; i++)
+        atom_ck[i] = xcb_intern_atom(srv->conn, 0,
+                                     (uint16_t)strlen(novawm_atom_names[i]),
+                                     novawm_atom_names[i]);
+
+    srv->keysyms = xcb_key_symbols_alloc(srv->conn);
+    if (!srv->keysyms) {
+        fprintf(stderr, "novawm: cannot alloc keysyms\n");
+        return false;
+    }
+
+    xcb_prefetch_extension_data(srv->conn, &xcb_xkb_id);
+    xcb_prefetch_extension_data(srv->conn, &xcb_sync_id);
+
     /* Try to become the WM */
-    uint32_t mask =
-        XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
-        XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY   |
-        XCB_EVENT_MASK_STRUCTURE_NOTIFY      |
-        XCB_EVENT_MASK_PROPERTY_CHANGE       |
-        XCB_EVENT_MASK_BUTTON_PRESS          |
-        XCB_EVENT_MASK_BUTTON_RELEASE        |
-        XCB_EVENT_MASK_POINTER_MOTION        |
-        XCB_EVENT_MASK_ENTER_WINDOW          |
-        XCB_EVENT_MASK_KEY_PRESS;
-
-    uint32_t values[] = { mask };
+    uint32_t values[] = { NOVAWM_ROOT_EVENT_MASK };
 
     xcb_void_cookie_t ck =
         xcb_change_window_attributes_checked(
             srv->conn, srv->root, XCB_CW_EVENT_MASK, values);
 
-    xcb_generic_error_t *err = xcb_request_check(srv->conn, ck);
+    xcb_generic_error_t *err =
+        NOVAWM_REPLY(srv, xcb_request_check(srv->conn, ck));
     if (err) {
         if (err->error_code == XCB_ACCESS) {
             fprintf(stderr,
@@ -134,30 +656,44 @@ novawm_x11_init(struct novawm_server *srv) {
         return false;
     }
 
+    for (int i = 0; i < NOVAWM_ATOM_COUNT; i++) {
+        xcb_intern_atom_reply_t *ar =
+            NOVAWM_REPLY(srv,
+                xcb_intern_atom_reply(srv->conn, atom_ck[i], NULL));
+        srv->atoms[i] = ar ? ar->atom : XCB_ATOM_NONE;
+        free(ar);
+    }
+
     /* Monitor geometry */
     srv->mon.x = 0;
     srv->mon.y = 0;
     srv->mon.w = srv->screen->width_in_pixels;
     srv->mon.h = srv->screen->height_in_pixels;
 
-    /* workspaces init */
-    srv->mon.current_ws = 0;
-    for (int i = 0; i < NOVAWM_WORKSPACES; i++) {
-        srv->mon.ws[i].clients = NULL;
-        srv->mon.ws[i].focused = NULL;
-    }
+    novawm_sync_init(srv);
 
-    srv->drag.active = false;
-    srv->drag.client = NULL;
+    novawm_x11_enable_detectable_repeat(srv);
+    if (!srv->detectable_repeat)
+        fprintf(stderr, "novawm: XKB detectable autorepeat unavailable\n");
 
-    srv->keysyms = xcb_key_symbols_alloc(srv->conn);
-    if (!srv->keysyms) {
-        fprintf(stderr, "novawm: cannot alloc keysyms\n");
+    return true;
+}
+
+/* The rest of the setup, once the config is loaded. */
+bool
+novawm_x11_init(struct novawm_server *srv) {
+    if (!novawm_server_init(srv))
         return false;
-    }
+
+    novawm_ewmh_init(srv);
+    novawm_bar_init(srv);
 
     novawm_splash = XCB_NONE;
-    novawm_x11_show_splash(srv);
+    srv->restarted = getenv("NOVAWM_RESTART") != NULL;
+    if (srv->restarted)
+        unsetenv("NOVAWM_RESTART"); /* don't leak into spawned clients */
+    else
+        novawm_x11_show_splash(srv);
 
     fprintf(stderr, "novawm: X11 backend initialized, root=0x%08x\n",
             srv->root);
@@ -167,7 +703,7 @@ novawm_x11_init(struct novawm_server *srv) {
 
 void
 novawm_x11_grab_keys(struct novawm_server *srv) {
-    xcb_ungrab_key(srv->conn, XCB_GRAB_ANY, srv->root, XCB_MOD_MASK_ANY);
+    srv->backend->ungrab_keys(srv);
 
     for (int i = 0; i < srv->cfg.binds_len; i++) {
         struct novawm_bind *b = &srv->cfg.binds[i];
@@ -175,15 +711,12 @@ novawm_x11_grab_keys(struct novawm_server *srv) {
             continue;
 
         xcb_keycode_t *codes =
-            xcb_key_symbols_get_keycode(srv->keysyms, b->keysym);
+            NOVAWM_REPLY(srv,
+                xcb_key_symbols_get_keycode(srv->keysyms, b->keysym));
         if (!codes) continue;
 
-        for (xcb_keycode_t *c = codes; *c != XCB_NO_SYMBOL; c++) {
-            xcb_grab_key(
-                srv->conn, 1, srv->root, b->mods, *c,
-                XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC
-            );
-        }
+        for (xcb_keycode_t *c = codes; *c != XCB_NO_SYMBOL; c++)
+            srv->backend->grab_key(srv, b->mods, *c);
         free(codes);
     }
 
@@ -193,140 +726,349 @@ novawm_x11_grab_keys(struct novawm_server *srv) {
 void
 novawm_x11_scan_existing(struct novawm_server *srv) {
     xcb_query_tree_cookie_t qc = xcb_query_tree(srv->conn, srv->root);
-    xcb_query_tree_reply_t *qr = xcb_query_tree_reply(srv->conn, qc, NULL);
-    if (!qr) return;
+    xcb_get_property_cookie_t sc =
+        xcb_get_property(srv->conn, 1, srv->root,
+                         srv->atoms[NOVAWM_ATOM_STATE], XCB_ATOM_CARDINAL,
+                         0, UINT32_MAX / 4);
+
+    xcb_query_tree_reply_t *qr =
+        NOVAWM_REPLY(srv, xcb_query_tree_reply(srv->conn, qc, NULL));
+    xcb_get_property_reply_t *snap =
+        NOVAWM_REPLY(srv, xcb_get_property_reply(srv->conn, sc, NULL));
+    if (!qr) {
+        free(snap);
+        return;
+    }
 
     int len = xcb_query_tree_children_length(qr);
     xcb_window_t *children = xcb_query_tree_children(qr);
 
-    for (int i = 0; i < len; i++) {
-        xcb_window_t w = children[i];
+    xcb_get_window_attributes_cookie_t *ac = malloc((size_t)len * sizeof *ac);
+    uint8_t *state = malloc((size_t)len);
+    if (len && (!ac || !state)) {
+        free(ac);
+        free(state);
+        free(snap);
+        free(qr);
+        return;
+    }
 
-        xcb_get_window_attributes_cookie_t ac =
-            xcb_get_window_attributes(srv->conn, w);
+    /* one GetWindowAttributes per child, all in flight at once */
+    for (int i = 0; i < len; i++)
+        ac[i] = xcb_get_window_attributes(srv->conn, children[i]);
 
+    for (int i = 0; i < len; i++) {
         xcb_get_window_attributes_reply_t *ar =
-            xcb_get_window_attributes_reply(srv->conn, ac, NULL);
+            NOVAWM_REPLY(srv,
+                xcb_get_window_attributes_reply(srv->conn, ac[i], NULL));
 
-        if (!ar) continue;
+        state[i] = 0xff;
+        if (ar && children[i] != novawm_splash && !ar->override_redirect)
+            state[i] = ar->map_state;
+        free(ar);
+    }
 
-        if (w != novawm_splash &&
-            ar->map_state == XCB_MAP_STATE_VIEWABLE &&
-            !ar->override_redirect) {
-            novawm_manage_window(srv, w);
-        }
+    novawm_restart_restore(srv, snap, children, len, state);
 
-        free(ar);
+    for (int i = 0; i < len; i++) {
+        if (state[i] != XCB_MAP_STATE_VIEWABLE)
+            continue;
+
+        struct novawm_client *c =
+            novawm_attach_client(srv, children[i], srv->mon.current_ws);
+        novawm_focus_client(srv, c);
     }
 
+    /* the tree lists children bottom to top */
+    novawm_stack_sync(srv, children, len);
+    probe_clients(srv);
+
+    /* size hints may change the tiling of what was just adopted */
+    novawm_arrange(srv);
+
+    free(ac);
+    free(state);
+    free(snap);
     free(qr);
 }
 
-void
-novawm_x11_run(struct novawm_server *srv) {
-    srv->running = true;
+/* Synthetic ConfigureNotify with the geometry we gave the client, the
+ * ICCCM answer to a ConfigureRequest we do not honour. */
+static void
+send_configure_notify(struct novawm_server *srv, struct novawm_client *c) {
+    xcb_configure_notify_event_t ce = {
+        .response_type     = XCB_CONFIGURE_NOTIFY,
+        .event             = c->win,
+        .window            = c->win,
+        .above_sibling     = XCB_NONE,
+        .x                 = (int16_t)c->x,
+        .y                 = (int16_t)c->y,
+        .width             = (uint16_t)c->w,
+        .height            = (uint16_t)c->h,
+        .border_width      = (uint16_t)(c->border_w > 0 ? c->border_w : 0),
+        .override_redirect = 0,
+    };
+    srv->backend->send_event(srv, c->win, XCB_EVENT_MASK_STRUCTURE_NOTIFY,
+                             &ce);
+}
 
-    while (srv->running) {
-        xcb_generic_event_t *ev = xcb_wait_for_event(srv->conn);
-        if (!ev) break;
-
-        uint8_t type = ev->response_type & ~0x80;
-
-        switch (type) {
-        case XCB_MAP_REQUEST: {
-            xcb_map_request_event_t *e =
-                (xcb_map_request_event_t *)ev;
-            novawm_manage_window(srv, e->window);
-        } break;
-
-        case XCB_DESTROY_NOTIFY: {
-            xcb_destroy_notify_event_t *e =
-                (xcb_destroy_notify_event_t *)ev;
-            if (novawm_splash && e->window == novawm_splash) {
-                novawm_splash = XCB_NONE;
-            } else {
-                struct novawm_client *c =
-                    novawm_find_client(srv, e->window);
-                if (c) novawm_unmanage_window(srv, c);
-            }
-        } break;
-
-        case XCB_UNMAP_NOTIFY: {
-            /* We ignore UnmapNotify for normal windows so workspace
-             * switching (which unmaps) does NOT unmanage clients. */
-            xcb_unmap_notify_event_t *e =
-                (xcb_unmap_notify_event_t *)ev;
-            if (novawm_splash && e->window == novawm_splash) {
-                /* if splash got unmapped by something, just drop it */
-                novawm_splash = XCB_NONE;
-            }
-        } break;
-
-        case XCB_CONFIGURE_REQUEST: {
-            xcb_configure_request_event_t *e =
-                (xcb_configure_request_event_t *)ev;
-
-            uint32_t mask = 0;
-            uint32_t vals[7];
-            int i = 0;
-
-            if (e->value_mask & XCB_CONFIG_WINDOW_X)
-                vals[i] = e->x, mask |= XCB_CONFIG_WINDOW_X, i++;
-            if (e->value_mask & XCB_CONFIG_WINDOW_Y)
-                vals[i] = e->y, mask |= XCB_CONFIG_WINDOW_Y, i++;
-            if (e->value_mask & XCB_CONFIG_WINDOW_WIDTH)
-                vals[i] = e->width, mask |= XCB_CONFIG_WINDOW_WIDTH, i++;
-            if (e->value_mask & XCB_CONFIG_WINDOW_HEIGHT)
-                vals[i] = e->height, mask |= XCB_CONFIG_WINDOW_HEIGHT, i++;
+static void
+handle_event(struct novawm_server *srv, xcb_generic_event_t *ev) {
+    uint8_t type = ev->response_type & ~0x80;
+
+    srv->stats.events++;
+
+    if (type == 0) {
+        novawm_x11_error(srv, (xcb_generic_error_t *)ev);
+        return;
+    }
+
+    if (srv->have_sync &&
+        type == srv->sync_event_base + XCB_SYNC_ALARM_NOTIFY) {
+        novawm_sync_alarm_notify(srv, (xcb_sync_alarm_notify_event_t *)ev);
+        return;
+    }
+
+    switch (type) {
+    case XCB_MAP_REQUEST: {
+        xcb_map_request_event_t *e =
+            (xcb_map_request_event_t *)ev;
+        novawm_manage_window(srv, e->window);
+    } break;
+
+    case XCB_DESTROY_NOTIFY: {
+        xcb_destroy_notify_event_t *e =
+            (xcb_destroy_notify_event_t *)ev;
+        if (novawm_splash && e->window == novawm_splash) {
+            novawm_splash = XCB_NONE;
+        } else {
+            struct novawm_client *c =
+                novawm_find_client(srv, e->window);
+            if (c) novawm_unmanage_window(srv, c);
+        }
+    } break;
+
+    case XCB_UNMAP_NOTIFY: {
+        /* Our own unmaps (workspace switching, monocle) are counted and
+         * ignored. Any other means the client withdrew the window or is
+         * destroying it: it is unmanaged now, so nothing more is sent to
+         * it while its DestroyNotify is on the way. */
+        xcb_unmap_notify_event_t *e =
+            (xcb_unmap_notify_event_t *)ev;
+        if (novawm_splash && e->window == novawm_splash) {
+            /* if splash got unmapped by something, just drop it */
+            novawm_splash = XCB_NONE;
+            break;
+        }
+        struct novawm_client *c = novawm_find_client(srv, e->window);
+        if (!c)
+            break;
+        if (c->unmaps_pending && !(ev->response_type & 0x80))
+            c->unmaps_pending--;
+        else
+            novawm_unmanage_window(srv, c);
+    } break;
+
+    case XCB_CONFIGURE_REQUEST: {
+        xcb_configure_request_event_t *e =
+            (xcb_configure_request_event_t *)ev;
+        struct novawm_client *c = novawm_find_client(srv, e->window);
+
+        uint32_t mask = 0;
+        uint32_t vals[7];
+        int i = 0;
+
+        if (e->value_mask & XCB_CONFIG_WINDOW_X)
+            vals[i] = e->x, mask |= XCB_CONFIG_WINDOW_X, i++;
+        if (e->value_mask & XCB_CONFIG_WINDOW_Y)
+            vals[i] = e->y, mask |= XCB_CONFIG_WINDOW_Y, i++;
+        if (e->value_mask & XCB_CONFIG_WINDOW_WIDTH)
+            vals[i] = e->width, mask |= XCB_CONFIG_WINDOW_WIDTH, i++;
+        if (e->value_mask & XCB_CONFIG_WINDOW_HEIGHT)
+            vals[i] = e->height, mask |= XCB_CONFIG_WINDOW_HEIGHT, i++;
+        if (e->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+            vals[i] = e->border_width, mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH, i++;
+        if (c && (!c->floating || c->fullscreen)) {
+            /* tiled geometry is ours: tell it where it is instead of
+             * letting it reflow */
+            send_configure_notify(srv, c);
+            srv->backend->flush(srv);
+            break;
+        }
+        if (c) {
+            /* stacking of managed windows is ours; a plain raise request
+             * is honoured through the stack model */
+            if ((e->value_mask & XCB_CONFIG_WINDOW_STACK_MODE) &&
+                !(e->value_mask & XCB_CONFIG_WINDOW_SIBLING) &&
+                e->stack_mode == XCB_STACK_MODE_ABOVE && c->floating)
+                novawm_stack_raise(srv, c);
+            if (e->value_mask & XCB_CONFIG_WINDOW_X)      c->x = e->x;
+            if (e->value_mask & XCB_CONFIG_WINDOW_Y)      c->y = e->y;
+            if (e->value_mask & XCB_CONFIG_WINDOW_WIDTH)  c->w = e->width;
+            if (e->value_mask & XCB_CONFIG_WINDOW_HEIGHT) c->h = e->height;
             if (e->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
-                vals[i] = e->border_width, mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH, i++;
+                c->border_w = e->border_width;
+            if (!c->hidden)
+                novawm_spatial_update(srv, c);
+        } else {
             if (e->value_mask & XCB_CONFIG_WINDOW_SIBLING)
                 vals[i] = e->sibling, mask |= XCB_CONFIG_WINDOW_SIBLING, i++;
             if (e->value_mask & XCB_CONFIG_WINDOW_STACK_MODE)
                 vals[i] = e->stack_mode, mask |= XCB_CONFIG_WINDOW_STACK_MODE, i++;
+        }
 
-            xcb_configure_window(
-                srv->conn, e->window, mask, vals);
-            xcb_flush(srv->conn);
-        } break;
-
-        case XCB_EXPOSE: {
-            xcb_expose_event_t *e =
-                (xcb_expose_event_t *)ev;
-
-            if (novawm_splash && e->window == novawm_splash)
-                novawm_x11_draw_splash(srv);
-        } break;
-
-        case XCB_KEY_PRESS:
-            novawm_handle_key_press(
-                srv, (xcb_key_press_event_t *)ev);
+        srv->backend->configure(srv, e->window, (uint16_t)mask, vals);
+        srv->backend->flush(srv);
+    } break;
+
+    case XCB_PROPERTY_NOTIFY: {
+        xcb_property_notify_event_t *e =
+            (xcb_property_notify_event_t *)ev;
+        if (e->atom == XCB_ATOM_WM_NAME ||
+            e->atom == srv->atoms[NOVAWM_ATOM_NET_WM_NAME]) {
+            /* fetched by the bar if and when it shows this client */
+            struct novawm_client *c = novawm_find_client(srv, e->window);
+            if (c)
+                c->title_stale = true;
             break;
-
-        case XCB_BUTTON_PRESS:
-            novawm_handle_button_press(
-                srv, (xcb_button_press_event_t *)ev);
+        }
+        if (e->atom != XCB_ATOM_WM_NORMAL_HINTS)
             break;
 
-        case XCB_BUTTON_RELEASE:
-            novawm_handle_button_release(
-                srv, (xcb_button_release_event_t *)ev);
+        struct novawm_client *c = novawm_find_client(srv, e->window);
+        if (!c)
             break;
 
-        case XCB_MOTION_NOTIFY:
-            novawm_handle_motion_notify(
-                srv, (xcb_motion_notify_event_t *)ev);
-            break;
+        srv->backend->size_hints(srv, c->win, &c->hints);
+        novawm_layout_invalidate(srv, c->ws);
+
+        if (!c->floating && c->ws == srv->mon.current_ws)
+            novawm_arrange(srv);
+    } break;
+
+    case XCB_EXPOSE: {
+        xcb_expose_event_t *e =
+            (xcb_expose_event_t *)ev;
+
+        if (novawm_splash && e->window == novawm_splash)
+            novawm_x11_draw_splash(srv);
+        else if (srv->bar.win && e->window == srv->bar.win && !e->count)
+            novawm_bar_expose(srv);
+    } break;
+
+    case XCB_CLIENT_MESSAGE:
+        novawm_ewmh_client_message(
+            srv, (xcb_client_message_event_t *)ev);
+        break;
+
+    case XCB_KEY_PRESS:
+        novawm_handle_key_press(
+            srv, (xcb_key_press_event_t *)ev);
+        break;
+
+    case XCB_KEY_RELEASE:
+        novawm_handle_key_release(
+            srv, (xcb_key_release_event_t *)ev);
+        break;
+
+    case XCB_BUTTON_PRESS:
+        novawm_handle_button_press(
+            srv, (xcb_button_press_event_t *)ev);
+        break;
+
+    case XCB_BUTTON_RELEASE:
+        novawm_handle_button_release(
+            srv, (xcb_button_release_event_t *)ev);
+        break;
+
+    case XCB_MOTION_NOTIFY:
+        novawm_handle_motion_notify(
+            srv, (xcb_motion_notify_event_t *)ev);
+        break;
+
+    case XCB_ENTER_NOTIFY:
+        novawm_handle_enter_notify(
+            srv, (xcb_enter_notify_event_t *)ev);
+        break;
+
+    default:
+        break;
+    }
+}
 
-        case XCB_ENTER_NOTIFY:
-            novawm_handle_enter_notify(
-                srv, (xcb_enter_notify_event_t *)ev);
-            break;
+/* One event, bracketed for the trace and the round-trip audit. */
+void
+novawm_x11_handle_event(struct novawm_server *srv, xcb_generic_event_t *ev) {
+    uint8_t type = ev->response_type & 0x7f;
+
+    novawm_trace(srv, NOVAWM_TRACE_HANDLER_BEGIN, type, 0, NULL);
+    NOVAWM_AUDIT_BEGIN(srv, type);
+    handle_event(srv, ev);
+    NOVAWM_AUDIT_END(srv);
+    novawm_trace(srv, NOVAWM_TRACE_HANDLER_END, type, 0, NULL);
+}
 
-        default:
-            break;
+void
+novawm_x11_run(struct novawm_server *srv) {
+    srv->running = true;
+
+    novawm_bar_update(srv);
+    novawm_stack_commit(srv);
+    novawm_state_publish(srv);
+    novawm_startup_ready(srv);
+
+    struct pollfd pfd = {
+        .fd     = xcb_get_file_descriptor(srv->conn),
+        .events = POLLIN,
+    };
+
+    while (srv->running) {
+        xcb_generic_event_t *ev = xcb_poll_for_event(srv->conn);
+        if (!ev) {
+            if (xcb_connection_has_error(srv->conn))
+                break;
+            /* sleep until the server talks, a sync ack is overdue or a
+             * held-back boost change is due */
+            int timeout = novawm_sync_timeout(srv);
+            int boost = novawm_boost_timeout(srv);
+            if (boost >= 0 && (timeout < 0 || boost < timeout))
+                timeout = boost;
+            xcb_flush(srv->conn);
+            novawm_trace(srv, NOVAWM_TRACE_FLUSH, 0, 0, NULL);
+            novawm_trace(srv, NOVAWM_TRACE_IDLE_BEGIN, 0, 0, NULL);
+            poll(&pfd, 1, timeout);
+            novawm_trace(srv, NOVAWM_TRACE_IDLE_END, 0, 0, NULL);
+            novawm_trace_poll(srv);
+            novawm_sync_expire(srv);
+            novawm_boost_update(srv);
+            continue;
         }
 
-        free(ev);
+        /* Drain everything that has already arrived before committing,
+         * so a burst of autorepeat presses becomes one layout frame. */
+        do {
+            novawm_trace(srv, NOVAWM_TRACE_EVENT, ev->response_type & 0x7f,
+                         0, NULL);
+            novawm_x11_handle_event(srv, ev);
+            free(ev);
+        } while (srv->running &&
+                 (ev = xcb_poll_for_event(srv->conn)));
+
+        novawm_x11_commit_frame(srv);
     }
+}
+
+/* After a batch of events: apply folded input, restack, publish. */
+void
+novawm_x11_commit_frame(struct novawm_server *srv) {
+    novawm_trace(srv, NOVAWM_TRACE_COMMIT_BEGIN, 0, 0, NULL);
+    NOVAWM_AUDIT_BEGIN(srv, NOVAWM_AUDIT_COMMIT);
+    novawm_input_commit(srv);
+    novawm_bar_update(srv);
+    novawm_stack_commit(srv);
+    novawm_state_publish(srv);
+    novawm_boost_update(srv);
+    NOVAWM_AUDIT_END(srv);
+    novawm_trace(srv, NOVAWM_TRACE_COMMIT_END, 0, 0, NULL);
+    srv->stats.frames++;
 }
\ No newline at end of file